@@ -0,0 +1,114 @@
+// Measures the throughput of image<...>::read_image against the former
+// pixel-by-pixel stream reads.
+//
+// usage: benchmark_image_read [width] [height] [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <valarray>
+#include <vector>
+
+#include <boost/astronomy/io/image.hpp>
+#include <boost/cstdfloat.hpp>
+#include <boost/endian/conversion.hpp>
+
+
+using namespace boost::astronomy::io;
+
+namespace
+{
+    typedef std::chrono::steady_clock clock_type;
+
+    std::string const file_name = "benchmark_image_read.raw";
+
+    void create_file(std::size_t bytes)
+    {
+        std::vector<char> buffer(bytes);
+        for (std::size_t i = 0; i < bytes; i++)
+        {
+            buffer[i] = static_cast<char>(i * 31u);
+        }
+        std::ofstream file(file_name, std::ios_base::out | std::ios_base::binary);
+        file.write(buffer.data(), static_cast<std::streamsize>(bytes));
+    }
+
+    double megabytes_per_second(std::size_t bytes, clock_type::duration elapsed)
+    {
+        return (static_cast<double>(bytes) / 1048576.0) / std::chrono::duration<double>(elapsed).count();
+    }
+
+    // one stream call and one conversion per pixel as read_image_logic used to do
+    template <typename PixelType, typename Raw>
+    double per_pixel_read(std::size_t count)
+    {
+        std::valarray<PixelType> data(count);
+        std::fstream file(file_name, std::ios_base::in | std::ios_base::binary);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Raw raw;
+            file.read(reinterpret_cast<char*>(&raw), sizeof(Raw));
+            raw = boost::endian::big_to_native(raw);
+            std::memcpy(&data[i], &raw, sizeof(Raw));
+        }
+        return static_cast<double>(data[count / 2]);
+    }
+
+    template <bitpix DataType>
+    double bulk_read(std::size_t width, std::size_t height)
+    {
+        std::fstream file(file_name, std::ios_base::in | std::ios_base::binary);
+        image<DataType> img(file, width, height, 0);
+        return static_cast<double>(img(height / 2, 0));
+    }
+
+    template <bitpix DataType, typename PixelType, typename Raw>
+    void run(char const* name, std::size_t width, std::size_t height, int repetitions)
+    {
+        std::size_t const count = width * height;
+        std::size_t const bytes = count * sizeof(PixelType);
+        create_file(bytes);
+
+        double sink = 0;
+        clock_type::duration per_pixel = clock_type::duration::max();
+        clock_type::duration bulk = clock_type::duration::max();
+        for (int i = 0; i < repetitions; i++)
+        {
+            clock_type::time_point start = clock_type::now();
+            sink += per_pixel_read<PixelType, Raw>(count);
+            per_pixel = (std::min)(per_pixel, clock_type::now() - start);
+
+            start = clock_type::now();
+            sink += bulk_read<DataType>(width, height);
+            bulk = (std::min)(bulk, clock_type::now() - start);
+        }
+
+        std::cout << name << ": per-pixel " << megabytes_per_second(bytes, per_pixel) << " MB/s, bulk "
+            << megabytes_per_second(bytes, bulk) << " MB/s (checksum " << sink << ")\n";
+
+        std::remove(file_name.c_str());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t width = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    std::size_t height = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+    int repetitions = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    std::cout << "image " << width << " x " << height << ", best of " << repetitions << "\n";
+    run<B16, std::int16_t, std::uint16_t>("B16 ", width, height, repetitions);
+    run<B32, std::int32_t, std::uint32_t>("B32 ", width, height, repetitions);
+    run<_B32, boost::float32_t, std::uint32_t>("_B32", width, height, repetitions);
+    run<_B64, boost::float64_t, std::uint64_t>("_B64", width, height, repetitions);
+
+    return 0;
+}
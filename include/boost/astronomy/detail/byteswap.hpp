@@ -0,0 +1,179 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_BYTESWAP_HPP
+#define BOOST_ASTRONOMY_DETAIL_BYTESWAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <boost/endian/conversion.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BOOST_ASTRONOMY_DETAIL_BYTESWAP_AVX2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BOOST_ASTRONOMY_DETAIL_BYTESWAP_SSSE3
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOOST_ASTRONOMY_DETAIL_BYTESWAP_SSE2
+#endif
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            ///@cond INTERNAL
+            template <std::size_t Size>
+            struct byteswap_element;
+
+            template <>
+            struct byteswap_element<2>
+            {
+                static void apply(unsigned char* data)
+                {
+                    std::uint16_t value;
+                    std::memcpy(&value, data, 2);
+                    value = boost::endian::endian_reverse(value);
+                    std::memcpy(data, &value, 2);
+                }
+            };
+
+            template <>
+            struct byteswap_element<4>
+            {
+                static void apply(unsigned char* data)
+                {
+                    std::uint32_t value;
+                    std::memcpy(&value, data, 4);
+                    value = boost::endian::endian_reverse(value);
+                    std::memcpy(data, &value, 4);
+                }
+            };
+
+            template <>
+            struct byteswap_element<8>
+            {
+                static void apply(unsigned char* data)
+                {
+                    std::uint64_t value;
+                    std::memcpy(&value, data, 8);
+                    value = boost::endian::endian_reverse(value);
+                    std::memcpy(data, &value, 8);
+                }
+            };
+
+#if defined(BOOST_ASTRONOMY_DETAIL_BYTESWAP_AVX2) || defined(BOOST_ASTRONOMY_DETAIL_BYTESWAP_SSSE3)
+            // pshufb masks reversing every Size byte group of a 16 byte lane
+            template <std::size_t Size>
+            inline __m128i byteswap_mask();
+
+            template <>
+            inline __m128i byteswap_mask<2>()
+            {
+                return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            }
+
+            template <>
+            inline __m128i byteswap_mask<4>()
+            {
+                return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            }
+
+            template <>
+            inline __m128i byteswap_mask<8>()
+            {
+                return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+            }
+#endif
+
+#if defined(BOOST_ASTRONOMY_DETAIL_BYTESWAP_SSE2)
+            // SSE2 has no byte shuffle so 16 bit words are reordered first and then
+            // the two bytes of every word are exchanged with shifts
+            template <std::size_t Size>
+            inline __m128i reverse_words(__m128i value);
+
+            template <>
+            inline __m128i reverse_words<2>(__m128i value)
+            {
+                return value;
+            }
+
+            template <>
+            inline __m128i reverse_words<4>(__m128i value)
+            {
+                value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+                return _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+            }
+
+            template <>
+            inline __m128i reverse_words<8>(__m128i value)
+            {
+                value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+                return _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+            }
+#endif
+
+            //! reverses the byte order of count elements of Size bytes each, in place
+            template <std::size_t Size>
+            inline void reverse_bytes(unsigned char* data, std::size_t count)
+            {
+                std::size_t bytes = count * Size;
+                std::size_t i = 0;
+
+#if defined(BOOST_ASTRONOMY_DETAIL_BYTESWAP_AVX2)
+                __m256i const mask = _mm256_broadcastsi128_si256(byteswap_mask<Size>());
+                for (; i + 32 <= bytes; i += 32)
+                {
+                    __m256i value = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_shuffle_epi8(value, mask));
+                }
+#elif defined(BOOST_ASTRONOMY_DETAIL_BYTESWAP_SSSE3)
+                __m128i const mask = byteswap_mask<Size>();
+                for (; i + 16 <= bytes; i += 16)
+                {
+                    __m128i value = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_shuffle_epi8(value, mask));
+                }
+#elif defined(BOOST_ASTRONOMY_DETAIL_BYTESWAP_SSE2)
+                for (; i + 16 <= bytes; i += 16)
+                {
+                    __m128i value = reverse_words<Size>(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i)));
+                    value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), value);
+                }
+#endif
+                for (; i < bytes; i += Size)
+                {
+                    byteswap_element<Size>::apply(data + i);
+                }
+            }
+
+            template <>
+            inline void reverse_bytes<1>(unsigned char*, std::size_t) {}
+            ///@endcond
+
+            //! converts count big-endian values stored at data to native byte order, in place
+            //! the conversion works on the object representation so it is bit exact for IEEE floating point types
+            template <typename T>
+            inline void big_to_native_inplace(T* data, std::size_t count)
+            {
+                if (boost::endian::order::native == boost::endian::order::little)
+                {
+                    reverse_bytes<sizeof(T)>(reinterpret_cast<unsigned char*>(data), count);
+                }
+            }
+
+            //! converts count native values stored at data to big-endian byte order, in place
+            template <typename T>
+            inline void native_to_big_inplace(T* data, std::size_t count)
+            {
+                big_to_native_inplace(data, count);
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_BYTESWAP_HPP
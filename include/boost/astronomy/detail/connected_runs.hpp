@@ -0,0 +1,78 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_CONNECTED_RUNS_HPP
+#define BOOST_ASTRONOMY_DETAIL_CONNECTED_RUNS_HPP
+
+#include <cstddef>
+#include <vector>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! horizontal run of pixels above the threshold in one row and the sums of its pixel values
+            struct pixel_run
+            {
+                std::size_t row;
+                std::size_t first; //! first column of the run
+                std::size_t last; //! column after the run
+                double flux; //! sum of the values
+                double column_flux; //! sum of value * column
+                double column2_flux; //! sum of value * column * column
+                double peak; //! largest value
+            };
+
+            //! returns the root of run, halving the path on the way
+            //! parents are never greater than the run they belong to, so the root is the first run of the component
+            inline std::size_t find_root(std::vector<std::size_t>& parent, std::size_t run)
+            {
+                while (parent[run] != run)
+                {
+                    parent[run] = parent[parent[run]];
+                    run = parent[run];
+                }
+                return run;
+            }
+
+            //! joins the components of runs a and b, the root with the larger index is linked to the other one
+            inline void join_runs(std::vector<std::size_t>& parent, std::size_t a, std::size_t b)
+            {
+                a = find_root(parent, a);
+                b = find_root(parent, b);
+                if (a < b)
+                {
+                    parent[b] = a;
+                }
+                else if (b < a)
+                {
+                    parent[a] = b;
+                }
+            }
+
+            //! joins every run of a row with the runs of the row above it that it touches, both rows are ordered by column
+            //! the runs of the rows are numbered from above_index and current_index in parent
+            //! diagonal is 1 if pixels touching at a corner are connected (8-connectivity) and 0 otherwise
+            inline void join_rows(std::vector<std::size_t>& parent, pixel_run const* above, std::size_t above_count,
+                std::size_t above_index, pixel_run const* current, std::size_t current_count, std::size_t current_index,
+                std::size_t diagonal)
+            {
+                std::size_t first_above = 0;
+                for (std::size_t run = 0; run < current_count; run++)
+                {
+                    while (first_above < above_count && above[first_above].last + diagonal <= current[run].first)
+                    {
+                        first_above++;
+                    }
+                    for (std::size_t touching = first_above;
+                        touching < above_count && above[touching].first < current[run].last + diagonal; touching++)
+                    {
+                        join_runs(parent, above_index + touching, current_index + run);
+                    }
+                }
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_CONNECTED_RUNS_HPP
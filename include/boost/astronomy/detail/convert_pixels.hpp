@@ -0,0 +1,307 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_CONVERT_PIXELS_HPP
+#define BOOST_ASTRONOMY_DETAIL_CONVERT_PIXELS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include <boost/cstdfloat.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOOST_ASTRONOMY_DETAIL_CONVERT_SSE2
+#endif
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            ///@cond INTERNAL
+            template <typename Target, typename Source>
+            inline Target convert_to_integer(Source value, bool, std::false_type /*integer source*/)
+            {
+                std::int64_t const wide = static_cast<std::int64_t>(value);
+                std::int64_t const low = static_cast<std::int64_t>((std::numeric_limits<Target>::min)());
+                std::int64_t const high = static_cast<std::int64_t>((std::numeric_limits<Target>::max)());
+                return static_cast<Target>(wide < low ? low : (wide > high ? high : wide));
+            }
+
+            template <typename Target, typename Source>
+            inline Target convert_to_integer(Source value, bool nearest, std::true_type /*floating point source*/)
+            {
+                double const wide = static_cast<double>(value);
+                if (std::isnan(wide))
+                {
+                    return 0;
+                }
+                double const rounded = nearest ? std::nearbyint(wide) : std::trunc(wide);
+                if (rounded <= static_cast<double>((std::numeric_limits<Target>::min)()))
+                {
+                    return (std::numeric_limits<Target>::min)();
+                }
+                if (rounded >= static_cast<double>((std::numeric_limits<Target>::max)()))
+                {
+                    return (std::numeric_limits<Target>::max)();
+                }
+                return static_cast<Target>(rounded);
+            }
+
+            template <typename Target, typename Source>
+            inline Target convert_value(Source value, bool, std::true_type /*floating point target*/)
+            {
+                return static_cast<Target>(value);
+            }
+
+            template <typename Target, typename Source>
+            inline Target convert_value(Source value, bool nearest, std::false_type /*integer target*/)
+            {
+                return convert_to_integer<Target>(value, nearest, std::is_floating_point<Source>());
+            }
+            ///@endcond
+
+            //! converts value to Target, integer targets saturate at their limits and NaN becomes 0
+            //! floating point values converted to integers are rounded to nearest (halfway values to even, as the
+            //! default rounding mode of the FPU) if nearest is true, otherwise toward zero
+            template <typename Target, typename Source>
+            inline Target convert_value(Source value, bool nearest)
+            {
+                return convert_value<Target>(value, nearest, std::is_floating_point<Target>());
+            }
+
+            //! converts count values one by one, the reference the vectorized kernels must match
+            template <typename Target, typename Source>
+            inline void convert_scalar(Source const* input, std::size_t count, Target* output, bool nearest)
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    output[i] = convert_value<Target>(input[i], nearest);
+                }
+            }
+
+            //! converts count values of input to output with convert_value()
+            //! pairs of pixel types with an SSE2 kernel convert 16 bytes of input or output at once
+            template <typename Target, typename Source>
+            struct convert_kernel
+            {
+                static void apply(Source const* input, std::size_t count, Target* output, bool nearest)
+                {
+                    convert_scalar(input, count, output, nearest);
+                }
+            };
+
+            template <typename PixelType>
+            struct convert_kernel<PixelType, PixelType>
+            {
+                static void apply(PixelType const* input, std::size_t count, PixelType* output, bool)
+                {
+                    std::copy_n(input, count, output);
+                }
+            };
+
+#if defined(BOOST_ASTRONOMY_DETAIL_CONVERT_SSE2)
+            ///@cond INTERNAL
+            // floating point values without NaN (which become 0) clamped to [low, high]
+            inline __m128 clamp_ps(__m128 value, float low, float high)
+            {
+                value = _mm_and_ps(value, _mm_cmpord_ps(value, value));
+                return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(low)), _mm_set1_ps(high));
+            }
+
+            inline __m128i round_ps(__m128 value, bool nearest)
+            {
+                return nearest ? _mm_cvtps_epi32(value) : _mm_cvttps_epi32(value);
+            }
+            ///@endcond
+
+            // widening of integers by unpacking and of floats by conversion
+
+            template <>
+            struct convert_kernel<boost::float32_t, std::uint8_t>
+            {
+                static void apply(std::uint8_t const* input, std::size_t count, boost::float32_t* output, bool nearest)
+                {
+                    __m128i const zero = _mm_setzero_si128();
+                    std::size_t i = 0;
+                    for (; i + 16 <= count; i += 16)
+                    {
+                        __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + i));
+                        __m128i const low = _mm_unpacklo_epi8(bytes, zero);
+                        __m128i const high = _mm_unpackhi_epi8(bytes, zero);
+                        _mm_storeu_ps(output + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)));
+                        _mm_storeu_ps(output + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)));
+                        _mm_storeu_ps(output + i + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)));
+                        _mm_storeu_ps(output + i + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<boost::float32_t, std::int16_t>
+            {
+                static void apply(std::int16_t const* input, std::size_t count, boost::float32_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 8 <= count; i += 8)
+                    {
+                        __m128i const words = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + i));
+                        //every word in the high half of a 32 bit lane, shifted down with its sign
+                        __m128i const low = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+                        __m128i const high = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16);
+                        _mm_storeu_ps(output + i, _mm_cvtepi32_ps(low));
+                        _mm_storeu_ps(output + i + 4, _mm_cvtepi32_ps(high));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<boost::float32_t, std::int32_t>
+            {
+                static void apply(std::int32_t const* input, std::size_t count, boost::float32_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 4 <= count; i += 4)
+                    {
+                        __m128i const values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + i));
+                        _mm_storeu_ps(output + i, _mm_cvtepi32_ps(values));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<boost::float64_t, boost::float32_t>
+            {
+                static void apply(boost::float32_t const* input, std::size_t count, boost::float64_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 4 <= count; i += 4)
+                    {
+                        __m128 const values = _mm_loadu_ps(input + i);
+                        _mm_storeu_pd(output + i, _mm_cvtps_pd(values));
+                        _mm_storeu_pd(output + i + 2, _mm_cvtps_pd(_mm_movehl_ps(values, values)));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            // narrowing with saturation, packs saturate integers and floats are clamped before rounding
+
+            template <>
+            struct convert_kernel<boost::float32_t, boost::float64_t>
+            {
+                static void apply(boost::float64_t const* input, std::size_t count, boost::float32_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 4 <= count; i += 4)
+                    {
+                        __m128 const low = _mm_cvtpd_ps(_mm_loadu_pd(input + i));
+                        __m128 const high = _mm_cvtpd_ps(_mm_loadu_pd(input + i + 2));
+                        _mm_storeu_ps(output + i, _mm_movelh_ps(low, high));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<std::int16_t, std::int32_t>
+            {
+                static void apply(std::int32_t const* input, std::size_t count, std::int16_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 8 <= count; i += 8)
+                    {
+                        __m128i const low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + i));
+                        __m128i const high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + i + 4));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(low, high));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<std::uint8_t, std::int16_t>
+            {
+                static void apply(std::int16_t const* input, std::size_t count, std::uint8_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 16 <= count; i += 16)
+                    {
+                        __m128i const low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + i));
+                        __m128i const high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + i + 8));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(low, high));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<std::int32_t, boost::float32_t>
+            {
+                static void apply(boost::float32_t const* input, std::size_t count, std::int32_t* output, bool nearest)
+                {
+                    __m128 const limit = _mm_set1_ps(2147483648.0f);
+                    std::size_t i = 0;
+                    for (; i + 4 <= count; i += 4)
+                    {
+                        __m128 values = _mm_loadu_ps(input + i);
+                        values = _mm_and_ps(values, _mm_cmpord_ps(values, values));
+                        values = _mm_max_ps(values, _mm_set1_ps(-2147483648.0f));
+                        //values from 2^31 convert to INT_MIN which is flipped to INT_MAX
+                        __m128i const over = _mm_castps_si128(_mm_cmpge_ps(values, limit));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+                            _mm_xor_si128(round_ps(values, nearest), over));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<std::int16_t, boost::float32_t>
+            {
+                static void apply(boost::float32_t const* input, std::size_t count, std::int16_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 8 <= count; i += 8)
+                    {
+                        __m128i const low = round_ps(clamp_ps(_mm_loadu_ps(input + i), -32768.0f, 32767.0f), nearest);
+                        __m128i const high = round_ps(clamp_ps(_mm_loadu_ps(input + i + 4), -32768.0f, 32767.0f), nearest);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(low, high));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+
+            template <>
+            struct convert_kernel<std::uint8_t, boost::float32_t>
+            {
+                static void apply(boost::float32_t const* input, std::size_t count, std::uint8_t* output, bool nearest)
+                {
+                    std::size_t i = 0;
+                    for (; i + 16 <= count; i += 16)
+                    {
+                        __m128i values[4];
+                        for (std::size_t j = 0; j < 4; j++)
+                        {
+                            values[j] = round_ps(clamp_ps(_mm_loadu_ps(input + i + 4 * j), 0.0f, 255.0f), nearest);
+                        }
+                        __m128i const low = _mm_packs_epi32(values[0], values[1]);
+                        __m128i const high = _mm_packs_epi32(values[2], values[3]);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(low, high));
+                    }
+                    convert_scalar(input + i, count - i, output + i, nearest);
+                }
+            };
+#endif
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_CONVERT_PIXELS_HPP
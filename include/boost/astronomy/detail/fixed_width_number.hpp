@@ -0,0 +1,262 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_FIXED_WIDTH_NUMBER_HPP
+#define BOOST_ASTRONOMY_DETAIL_FIXED_WIDTH_NUMBER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! returns true if [begin, end) contains only spaces
+            inline bool is_blank(char const* begin, char const* end)
+            {
+                for (; begin != end; ++begin)
+                {
+                    if (*begin != ' ')
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            //! parses the integer in the fixed width field [begin, end) into value without allocating
+            //! leading and trailing spaces are ignored and a blank field is 0
+            //! returns false if the field is not an integer or does not fit in std::int64_t
+            inline bool parse_integer(char const* begin, char const* end, std::int64_t& value)
+            {
+                while (begin != end && *begin == ' ')
+                {
+                    ++begin;
+                }
+                while (begin != end && end[-1] == ' ')
+                {
+                    --end;
+                }
+
+                value = 0;
+                if (begin == end)
+                {
+                    return true;
+                }
+
+                bool const negative = *begin == '-';
+                if (*begin == '-' || *begin == '+')
+                {
+                    ++begin;
+                }
+                if (begin == end)
+                {
+                    return false;
+                }
+
+                //accumulated as a negative number so that the minimum of std::int64_t can be parsed
+                std::int64_t const limit = (std::numeric_limits<std::int64_t>::min)();
+                std::int64_t result = 0;
+                for (; begin != end; ++begin)
+                {
+                    unsigned const digit = static_cast<unsigned>(*begin - '0');
+                    if (digit > 9 || result < (limit + static_cast<std::int64_t>(digit)) / 10)
+                    {
+                        return false;
+                    }
+                    result = result * 10 - static_cast<std::int64_t>(digit);
+                }
+
+                if (!negative && result == limit)
+                {
+                    return false;
+                }
+                value = negative ? result : -result;
+                return true;
+            }
+
+            //! parses the real number in the fixed width field [begin, end) into value without allocating
+            //! accepts Fortran formats: optional sign, digits with an optional decimal point and an optional exponent
+            //! introduced by E or D (or only by the sign of the exponent), leading and trailing spaces are ignored
+            //! if the field has no decimal point then its last decimals digits are the fraction (Fw.d, Ew.d, Dw.d)
+            //! a blank field is 0, returns false if the field is not a number
+            inline bool parse_real(char const* begin, char const* end, std::size_t decimals, double& value)
+            {
+                static double const powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+                while (begin != end && *begin == ' ')
+                {
+                    ++begin;
+                }
+                while (begin != end && end[-1] == ' ')
+                {
+                    --end;
+                }
+
+                value = 0;
+                if (begin == end)
+                {
+                    return true;
+                }
+
+                bool const negative = *begin == '-';
+                if (*begin == '-' || *begin == '+')
+                {
+                    ++begin;
+                }
+
+                //value = digits * 10^exponent, digits has no leading zeros and only its first 19 digits are
+                //accumulated in mantissa, digits past the size of digits are dropped and counted in exponent
+                char digits[64];
+                std::size_t digit_count = 0;
+                std::uint64_t mantissa = 0;
+                long exponent = 0;
+                bool has_digits = false;
+                bool has_point = false;
+                bool truncated = false; //true if a non zero digit is not in mantissa
+
+                for (; begin != end; ++begin)
+                {
+                    char const c = *begin;
+                    if (c >= '0' && c <= '9')
+                    {
+                        has_digits = true;
+                        if (has_point)
+                        {
+                            exponent--;
+                        }
+                        if (digit_count == 0 && c == '0')
+                        {
+                            continue;
+                        }
+
+                        if (digit_count < 19)
+                        {
+                            mantissa = mantissa * 10 + static_cast<std::uint64_t>(c - '0');
+                        }
+                        else if (c != '0')
+                        {
+                            truncated = true;
+                        }
+
+                        if (digit_count < sizeof(digits))
+                        {
+                            digits[digit_count++] = c;
+                        }
+                        else
+                        {
+                            exponent++;
+                        }
+                    }
+                    else if (c == '.' && !has_point)
+                    {
+                        has_point = true;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                if (!has_digits)
+                {
+                    return false;
+                }
+                if (!has_point)
+                {
+                    exponent -= static_cast<long>(decimals);
+                }
+
+                if (begin != end)
+                {
+                    if (*begin == 'E' || *begin == 'e' || *begin == 'D' || *begin == 'd')
+                    {
+                        ++begin;
+                    }
+                    else if (*begin != '+' && *begin != '-')
+                    {
+                        return false;
+                    }
+
+                    bool const negative_exponent = begin != end && *begin == '-';
+                    if (begin != end && (*begin == '-' || *begin == '+'))
+                    {
+                        ++begin;
+                    }
+                    if (begin == end)
+                    {
+                        return false;
+                    }
+
+                    long written = 0;
+                    for (; begin != end; ++begin)
+                    {
+                        unsigned const digit = static_cast<unsigned>(*begin - '0');
+                        if (digit > 9)
+                        {
+                            return false;
+                        }
+                        if (written < 100000)
+                        {
+                            written = written * 10 + static_cast<long>(digit);
+                        }
+                    }
+                    exponent += negative_exponent ? -written : written;
+                }
+
+                if (digit_count == 0)
+                {
+                    value = negative ? -0.0 : 0.0;
+                    return true;
+                }
+
+                //exact when the mantissa and the power of 10 are both exactly representable
+                long const scale = exponent + static_cast<long>(digit_count > 19 ? digit_count - 19 : 0);
+                if (!truncated && mantissa <= (std::uint64_t(1) << 53) && scale >= -22 && scale <= 22)
+                {
+                    double result = static_cast<double>(mantissa);
+                    result = scale < 0 ? result / powers[-scale] : result * powers[scale];
+                    value = negative ? -result : result;
+                    return true;
+                }
+
+                //otherwise the digits are converted by strtod, the text has no decimal point so the locale does not matter
+                char text[sizeof(digits) + 16];
+                std::size_t length = 0;
+                if (negative)
+                {
+                    text[length++] = '-';
+                }
+                for (std::size_t i = 0; i < digit_count; i++)
+                {
+                    text[length++] = digits[i];
+                }
+                text[length++] = 'e';
+                long power = exponent;
+                if (power < 0)
+                {
+                    text[length++] = '-';
+                    power = -power;
+                }
+                char reversed[24];
+                std::size_t reversed_length = 0;
+                do
+                {
+                    reversed[reversed_length++] = static_cast<char>('0' + power % 10);
+                    power /= 10;
+                } while (power > 0);
+                while (reversed_length > 0)
+                {
+                    text[length++] = reversed[--reversed_length];
+                }
+                text[length] = '\0';
+                value = std::strtod(text, nullptr);
+                return true;
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_FIXED_WIDTH_NUMBER_HPP
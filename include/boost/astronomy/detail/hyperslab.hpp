@@ -0,0 +1,110 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_HYPERSLAB_HPP
+#define BOOST_ASTRONOMY_DETAIL_HYPERSLAB_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! returns the number of elements of an array of shape
+            //! an array without axis has no element, as a data unit with NAXIS = 0
+            inline std::size_t element_count(std::vector<std::size_t> const& shape)
+            {
+                std::size_t count = shape.empty() ? 0 : 1;
+                for (std::size_t extent : shape)
+                {
+                    count *= extent;
+                }
+                return count;
+            }
+
+            //! throws region_out_of_range_exception unless the hyperslab which starts at first and has count
+            //! elements along every axis is inside an array of shape
+            inline void check_hyperslab(std::vector<std::size_t> const& shape, std::vector<std::size_t> const& first,
+                std::vector<std::size_t> const& count)
+            {
+                if (first.size() != shape.size() || count.size() != shape.size())
+                {
+                    throw region_out_of_range_exception();
+                }
+                for (std::size_t axis = 0; axis < shape.size(); axis++)
+                {
+                    if (first[axis] > shape[axis] || count[axis] > shape[axis] - first[axis])
+                    {
+                        throw region_out_of_range_exception();
+                    }
+                }
+            }
+
+            //! calls copy_run(source, destination, length) for every run of contiguous elements of the hyperslab which
+            //! starts at first and has count elements along every axis of an array of shape stored with axis 0 varying
+            //! fastest (the order of FITS data units), source is the index of the run in the array and destination
+            //! its index in the hyperslab stored in the same order
+            //! runs are merged across the leading axes which the hyperslab covers completely, so a plane of a cube is
+            //! one run and a spectrum along the last axis is one run of one element per plane
+            template <typename CopyRun>
+            void for_each_run(std::vector<std::size_t> const& shape, std::vector<std::size_t> const& first,
+                std::vector<std::size_t> const& count, CopyRun copy_run)
+            {
+                check_hyperslab(shape, first, count);
+                std::size_t const rank = shape.size();
+                if (element_count(count) == 0)
+                {
+                    return;
+                }
+
+                std::vector<std::size_t> strides(rank, 1);
+                for (std::size_t axis = 1; axis < rank; axis++)
+                {
+                    strides[axis] = strides[axis - 1] * shape[axis - 1];
+                }
+
+                std::size_t merged = 1; //leading axes inside one run
+                std::size_t run = count[0];
+                while (merged < rank && count[merged - 1] == shape[merged - 1])
+                {
+                    run *= count[merged];
+                    merged++;
+                }
+
+                std::size_t base = 0;
+                for (std::size_t axis = 0; axis < rank; axis++)
+                {
+                    base += first[axis] * strides[axis];
+                }
+
+                std::vector<std::size_t> index(rank, 0);
+                std::size_t source = base;
+                std::size_t destination = 0;
+                while (true)
+                {
+                    copy_run(source, destination, run);
+                    destination += run;
+
+                    //odometer over the axes outside the run
+                    std::size_t axis = merged;
+                    while (axis < rank && ++index[axis] == count[axis])
+                    {
+                        source -= (count[axis] - 1) * strides[axis];
+                        index[axis] = 0;
+                        axis++;
+                    }
+                    if (axis == rank)
+                    {
+                        return;
+                    }
+                    source += strides[axis];
+                }
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_HYPERSLAB_HPP
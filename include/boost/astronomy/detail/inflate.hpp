@@ -0,0 +1,76 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_INFLATE_HPP
+#define BOOST_ASTRONOMY_DETAIL_INFLATE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+//GZIP compressed data can be read only if zlib is available, CMake defines BOOST_ASTRONOMY_HAS_ZLIB when it finds zlib
+#if defined(BOOST_ASTRONOMY_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! returns true if gzip_decompress() is available
+            inline bool has_gzip()
+            {
+#if defined(BOOST_ASTRONOMY_HAS_ZLIB)
+                return true;
+#else
+                return false;
+#endif
+            }
+
+            //! decompresses gzip (or zlib) data of size bytes into exactly output_size bytes at output
+            //! throws invalid_compressed_data_exception if the data does not decompress to output_size bytes
+            //! and unsupported_compression_exception if the library is built without zlib
+            inline void gzip_decompress(unsigned char const* input, std::size_t size, unsigned char* output, std::size_t output_size)
+            {
+#if defined(BOOST_ASTRONOMY_HAS_ZLIB)
+                if (size > (std::numeric_limits<uInt>::max)() || output_size > (std::numeric_limits<uInt>::max)())
+                {
+                    throw invalid_compressed_data_exception();
+                }
+
+                z_stream stream;
+                std::memset(&stream, 0, sizeof(stream));
+                //15 bits window, +32 detects gzip and zlib headers
+                if (inflateInit2(&stream, 15 + 32) != Z_OK)
+                {
+                    throw invalid_compressed_data_exception();
+                }
+
+                stream.next_in = const_cast<unsigned char*>(input);
+                stream.avail_in = static_cast<uInt>(size);
+                stream.next_out = output;
+                stream.avail_out = static_cast<uInt>(output_size);
+
+                int result = inflate(&stream, Z_FINISH);
+                std::size_t written = output_size - stream.avail_out;
+                inflateEnd(&stream);
+
+                if (result != Z_STREAM_END || written != output_size)
+                {
+                    throw invalid_compressed_data_exception();
+                }
+#else
+                (void)input;
+                (void)size;
+                (void)output;
+                (void)output_size;
+                throw unsupported_compression_exception();
+#endif
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_INFLATE_HPP
@@ -0,0 +1,124 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_KEYWORD_INDEX_HPP
+#define BOOST_ASTRONOMY_DETAIL_KEYWORD_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#include <boost/utility/string_view.hpp>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! index of the cards of a header by keyword
+            //! the 8 chars of a keyword (padded with spaces) are packed in one 64 bit integer and the (keyword, card)
+            //! pairs are kept in a sorted vector, so building the index and looking up keys never allocates strings
+            //! cards with the same keyword (HISTORY, COMMENT, ...) are adjacent in the order of the header
+            class keyword_index
+            {
+            public:
+                static std::size_t const npos = static_cast<std::size_t>(-1);
+
+                //! keyword and position of one card
+                struct entry
+                {
+                    std::uint64_t key;
+                    std::size_t card;
+
+                    bool operator<(entry const& other) const
+                    {
+                        return this->key < other.key || (this->key == other.key && this->card < other.card);
+                    }
+                };
+
+            private:
+                std::vector<entry> entries; //! sorted by keyword and then by position of card
+
+            public:
+                //! packs the first 8 chars of a card (the keyword with its padding)
+                static std::uint64_t pack(char const* keyword)
+                {
+                    std::uint64_t key;
+                    std::memcpy(&key, keyword, 8);
+                    return key;
+                }
+
+                //! packs key padded with spaces to 8 chars, returns false if key is longer than 8 chars
+                static bool pack(boost::string_view key, std::uint64_t& packed)
+                {
+                    if (key.size() > 8)
+                    {
+                        return false;
+                    }
+                    char keyword[8] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+                    std::memcpy(keyword, key.data(), key.size());
+                    packed = pack(keyword);
+                    return true;
+                }
+
+                //! indexes count cards of 80 chars stored one after the other at header
+                void assign(char const* header, std::size_t count)
+                {
+                    this->entries.clear();
+                    this->entries.reserve(count);
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        entry card = {pack(header + i * 80), i};
+                        this->entries.push_back(card);
+                    }
+                    std::sort(this->entries.begin(), this->entries.end());
+                }
+
+                void clear()
+                {
+                    this->entries.clear();
+                }
+
+                //! returns the entries of all the cards with key in the order of the header
+                std::pair<entry const*, entry const*> equal_range(boost::string_view key) const
+                {
+                    std::uint64_t packed;
+                    if (!pack(key, packed) || this->entries.empty())
+                    {
+                        return std::pair<entry const*, entry const*>(nullptr, nullptr);
+                    }
+
+                    entry const* begin = this->entries.data();
+                    entry const* end = begin + this->entries.size();
+                    entry const lowest = {packed, 0};
+                    entry const* first = std::lower_bound(begin, end, lowest);
+                    entry const* last = first;
+                    while (last != end && last->key == packed)
+                    {
+                        ++last;
+                    }
+                    return std::make_pair(first, last);
+                }
+
+                //! returns the position of the last card with key (the one in effect if a keyword is repeated)
+                //! or npos if there is no such card
+                std::size_t find(boost::string_view key) const
+                {
+                    std::pair<entry const*, entry const*> range = equal_range(key);
+                    return range.first == range.second ? npos : (range.second - 1)->card;
+                }
+
+                //! returns the number of cards with key
+                std::size_t count(boost::string_view key) const
+                {
+                    std::pair<entry const*, entry const*> range = equal_range(key);
+                    return static_cast<std::size_t>(range.second - range.first);
+                }
+            };
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_KEYWORD_INDEX_HPP
@@ -0,0 +1,90 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_PARALLEL_FOR_HPP
+#define BOOST_ASTRONOMY_DETAIL_PARALLEL_FOR_HPP
+
+#include <cstddef>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! returns the number of threads to use when threads is 0 (the number of hardware threads)
+            inline std::size_t thread_count(std::size_t threads = 0)
+            {
+                if (threads == 0)
+                {
+                    threads = std::thread::hardware_concurrency();
+                }
+                return threads == 0 ? 1 : threads;
+            }
+
+            //! calls function(i) for every i in [0, count) on up to threads threads (0 uses all hardware threads)
+            //! indices are handed out one at a time so tasks of different cost are balanced between threads
+            //! the first exception thrown by function is rethrown in the calling thread after all threads finish
+            template <typename Function>
+            void parallel_for(std::size_t count, Function function, std::size_t threads = 0)
+            {
+                threads = (std::min)(thread_count(threads), count);
+                if (threads <= 1)
+                {
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        function(i);
+                    }
+                    return;
+                }
+
+                std::atomic<std::size_t> next(0);
+                std::exception_ptr error;
+                std::mutex error_mutex;
+
+                auto worker = [&]()
+                {
+                    try
+                    {
+                        for (std::size_t i = next++; i < count; i = next++)
+                        {
+                            function(i);
+                        }
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                        next = count;
+                    }
+                };
+
+                std::vector<std::thread> pool;
+                pool.reserve(threads - 1);
+                for (std::size_t i = 1; i < threads; i++)
+                {
+                    pool.emplace_back(worker);
+                }
+                worker();
+                for (std::thread& thread : pool)
+                {
+                    thread.join();
+                }
+
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_PARALLEL_FOR_HPP
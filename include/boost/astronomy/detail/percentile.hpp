@@ -0,0 +1,214 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_PERCENTILE_HPP
+#define BOOST_ASTRONOMY_DETAIL_PERCENTILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! unsigned integer of size Size
+            template <std::size_t Size> struct unsigned_of_size;
+            template <> struct unsigned_of_size<1> { typedef std::uint8_t type; };
+            template <> struct unsigned_of_size<2> { typedef std::uint16_t type; };
+            template <> struct unsigned_of_size<4> { typedef std::uint32_t type; };
+            template <> struct unsigned_of_size<8> { typedef std::uint64_t type; };
+
+            //! maps pixel values to unsigned keys with the same order, so values can be selected digit by digit
+            template <typename T>
+            struct order_key
+            {
+                typedef typename unsigned_of_size<sizeof(T)>::type key_type;
+                static key_type const sign_bit = static_cast<key_type>(key_type(1) << (8 * sizeof(T) - 1));
+
+                static key_type to_key(T value)
+                {
+                    key_type bits;
+                    std::memcpy(&bits, &value, sizeof(T));
+                    if (std::is_floating_point<T>::value)
+                    {
+                        //negative values are stored as sign and magnitude so their order is reversed
+                        return static_cast<key_type>((bits & sign_bit) ? ~bits : (bits | sign_bit));
+                    }
+                    return std::is_signed<T>::value ? static_cast<key_type>(bits ^ sign_bit) : bits;
+                }
+
+                static T from_key(key_type key)
+                {
+                    if (std::is_floating_point<T>::value)
+                    {
+                        key = static_cast<key_type>((key & sign_bit) ? (key ^ sign_bit) : ~key);
+                    }
+                    else if (std::is_signed<T>::value)
+                    {
+                        key = static_cast<key_type>(key ^ sign_bit);
+                    }
+                    T value;
+                    std::memcpy(&value, &key, sizeof(T));
+                    return value;
+                }
+
+                //! NaN has no place in the order so it is left out
+                static bool is_ordered(T value)
+                {
+                    return !std::isnan(value);
+                }
+            };
+
+            //! returns the values at percentiles q (each in [0, 100]) of size pixels, NaN pixels are ignored
+            //! throws invalid_percentile_exception if a percentile is outside [0, 100]
+            //! the value at percentile q is the pixel of rank min(n - 1, floor(q * n / 100)) among n ordered pixels,
+            //! so percentile 50 is the upper median. if no pixel is ordered every value is NaN (0 for integers)
+            //!
+            //! the selection refines the pixels' order preserving keys 16 bits at a time: every pass over the pixels
+            //! counts one digit of the keys sharing the digits found so far, in a histogram per distinct prefix.
+            //! 8 and 16 bit pixels take a single counting pass, 32 bit pixels take two and 64 bit pixels four.
+            //! the pixels are neither copied nor reordered; extra memory is one histogram per distinct prefix
+            //! (at most 512 KiB each) per part of the pixels counted in parallel, the number of parts is lowered
+            //! so that all the histograms of a pass take at most 16 MiB when there are several prefixes
+            template <typename T>
+            std::vector<T> percentiles(T const* pixels, std::size_t size, std::vector<double> const& q,
+                std::size_t threads = 0)
+            {
+                typedef order_key<T> key_traits;
+                typedef typename key_traits::key_type key_type;
+
+                std::size_t const key_bits = 8 * sizeof(T);
+                std::size_t const digit_bits = (std::min)(key_bits, std::size_t(16));
+                std::size_t const bins = std::size_t(1) << digit_bits;
+                std::size_t const passes = key_bits / digit_bits;
+
+                for (double percentage : q)
+                {
+                    if (!(percentage >= 0 && percentage <= 100))
+                    {
+                        throw boost::astronomy::invalid_percentile_exception();
+                    }
+                }
+
+                //rank of the wanted pixel among the pixels with the prefix found so far
+                std::vector<std::uint64_t> rank(q.size());
+                std::vector<std::uint64_t> prefix(q.size(), 0);
+                std::vector<std::size_t> group(q.size(), 0);
+                std::vector<std::uint64_t> group_prefix(1, 0);
+
+                //every part of the pixels is counted by one task into its own histograms
+                std::size_t const min_part_size = std::size_t(1) << 16;
+                std::size_t const max_parts = (std::max)(std::size_t(1),
+                    (std::min)(thread_count(threads), size / min_part_size));
+                std::size_t const max_histogram_counts = std::size_t(1) << 21;
+
+                std::uint64_t ordered = 0;
+                for (std::size_t pass = 0; pass < passes; pass++)
+                {
+                    std::size_t const shift = key_bits - digit_bits * (pass + 1);
+                    std::size_t const groups = group_prefix.size();
+                    std::size_t const parts = (std::max)(std::size_t(1),
+                        (std::min)(max_parts, max_histogram_counts / (groups * bins)));
+                    std::size_t const part_size = (size + parts - 1) / parts;
+                    std::vector<std::uint64_t> histogram(parts * groups * bins, 0);
+
+                    parallel_for(parts, [&](std::size_t part)
+                    {
+                        std::uint64_t* counts = &histogram[part * groups * bins];
+                        std::size_t const end = (std::min)(size, (part + 1) * part_size);
+                        for (std::size_t i = part * part_size; i < end; i++)
+                        {
+                            if (!key_traits::is_ordered(pixels[i]))
+                            {
+                                continue;
+                            }
+                            key_type const key = key_traits::to_key(pixels[i]);
+                            std::size_t const digit = static_cast<std::size_t>((key >> shift) & (bins - 1));
+                            if (pass == 0)
+                            {
+                                counts[digit]++;
+                                continue;
+                            }
+
+                            //group_prefix is sorted, so the group of the pixel is found by binary search
+                            std::uint64_t const high = static_cast<std::uint64_t>(key) >> (shift + digit_bits);
+                            std::vector<std::uint64_t>::const_iterator const g =
+                                std::lower_bound(group_prefix.begin(), group_prefix.end(), high);
+                            if (g != group_prefix.end() && *g == high)
+                            {
+                                counts[static_cast<std::size_t>(g - group_prefix.begin()) * bins + digit]++;
+                            }
+                        }
+                    }, parts);
+
+                    for (std::size_t part = 1; part < parts; part++)
+                    {
+                        for (std::size_t i = 0; i < groups * bins; i++)
+                        {
+                            histogram[i] += histogram[part * groups * bins + i];
+                        }
+                    }
+
+                    if (pass == 0)
+                    {
+                        for (std::size_t i = 0; i < bins; i++)
+                        {
+                            ordered += histogram[i];
+                        }
+                        if (ordered == 0)
+                        {
+                            T const none = std::numeric_limits<T>::has_quiet_NaN ? std::numeric_limits<T>::quiet_NaN() : T();
+                            return std::vector<T>(q.size(), none);
+                        }
+                        for (std::size_t k = 0; k < q.size(); k++)
+                        {
+                            double const position = std::floor(q[k] / 100.0 * static_cast<double>(ordered));
+                            rank[k] = (std::min)(ordered - 1, static_cast<std::uint64_t>(position));
+                        }
+                    }
+
+                    //finds the digit of every wanted pixel and regroups them by their longer prefix
+                    std::vector<std::uint64_t> next_prefix(q.size());
+                    for (std::size_t k = 0; k < q.size(); k++)
+                    {
+                        std::uint64_t const* counts = &histogram[group[k] * bins];
+                        std::size_t digit = 0;
+                        while (rank[k] >= counts[digit])
+                        {
+                            rank[k] -= counts[digit];
+                            digit++;
+                        }
+                        prefix[k] = (prefix[k] << digit_bits) | digit;
+                        next_prefix[k] = prefix[k];
+                    }
+                    std::sort(next_prefix.begin(), next_prefix.end());
+                    next_prefix.erase(std::unique(next_prefix.begin(), next_prefix.end()), next_prefix.end());
+                    for (std::size_t k = 0; k < q.size(); k++)
+                    {
+                        group[k] = static_cast<std::size_t>(
+                            std::lower_bound(next_prefix.begin(), next_prefix.end(), prefix[k]) - next_prefix.begin());
+                    }
+                    group_prefix.swap(next_prefix);
+                }
+
+                std::vector<T> result(q.size());
+                for (std::size_t k = 0; k < q.size(); k++)
+                {
+                    result[k] = key_traits::from_key(static_cast<key_type>(prefix[k]));
+                }
+                return result;
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_PERCENTILE_HPP
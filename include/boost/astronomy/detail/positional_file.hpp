@@ -0,0 +1,121 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_POSITIONAL_FILE_HPP
+#define BOOST_ASTRONOMY_DETAIL_POSITIONAL_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <mutex>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! read only file which supports reads at an offset without a shared cursor
+            //! so any number of threads can read from the same file at the same time
+            class positional_file
+            {
+#if defined(_WIN32)
+                mutable std::ifstream file;
+                mutable std::mutex file_mutex; //no pread on Windows, reads are serialized
+#else
+                int descriptor;
+#endif
+
+            public:
+                explicit positional_file(std::string const& file_path)
+                {
+#if defined(_WIN32)
+                    file.open(file_path, std::ios_base::in | std::ios_base::binary);
+                    if (!file)
+                    {
+                        throw fits_exception();
+                    }
+#else
+                    descriptor = ::open(file_path.c_str(), O_RDONLY);
+                    if (descriptor < 0)
+                    {
+                        throw fits_exception();
+                    }
+#endif
+                }
+
+                positional_file(positional_file const&) = delete;
+                positional_file& operator=(positional_file const&) = delete;
+
+                ~positional_file()
+                {
+#if !defined(_WIN32)
+                    ::close(descriptor);
+#endif
+                }
+
+                //! returns the size of the file in bytes
+                std::uint64_t size() const
+                {
+#if defined(_WIN32)
+                    std::lock_guard<std::mutex> lock(file_mutex);
+                    std::streampos position = file.tellg();
+                    file.seekg(0, std::ios_base::end);
+                    std::uint64_t result = static_cast<std::uint64_t>(file.tellg());
+                    file.seekg(position);
+                    return result;
+#else
+                    struct stat status;
+                    if (::fstat(descriptor, &status) != 0)
+                    {
+                        throw fits_exception();
+                    }
+                    return static_cast<std::uint64_t>(status.st_size);
+#endif
+                }
+
+                //! reads exactly size bytes starting at offset into buffer
+                void read(char* buffer, std::size_t size, std::uint64_t offset) const
+                {
+#if defined(_WIN32)
+                    std::lock_guard<std::mutex> lock(file_mutex);
+                    file.seekg(static_cast<std::streamoff>(offset));
+                    file.read(buffer, static_cast<std::streamsize>(size));
+                    if (!file)
+                    {
+                        file.clear();
+                        throw fits_exception();
+                    }
+#else
+                    while (size > 0)
+                    {
+                        ssize_t count = ::pread(descriptor, buffer, size, static_cast<off_t>(offset));
+                        if (count < 0 && errno == EINTR)
+                        {
+                            continue;
+                        }
+                        if (count <= 0)
+                        {
+                            throw fits_exception();
+                        }
+                        buffer += count;
+                        size -= static_cast<std::size_t>(count);
+                        offset += static_cast<std::uint64_t>(count);
+                    }
+#endif
+                }
+            };
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_POSITIONAL_FILE_HPP
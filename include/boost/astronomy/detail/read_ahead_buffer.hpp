@@ -0,0 +1,288 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_READ_AHEAD_BUFFER_HPP
+#define BOOST_ASTRONOMY_DETAIL_READ_AHEAD_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <ios>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <boost/astronomy/detail/positional_file.hpp>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! input stream buffer over a file which a background thread reads ahead in blocks of block_size bytes
+            //! into a pool of block_count buffers, so that the data following the current position is already in
+            //! memory while the data before it is being processed
+            //! seeks inside the blocks already read (or being read) consume them, other seeks restart the reads
+            class read_ahead_buffer : public std::streambuf
+            {
+                struct block
+                {
+                    std::vector<char> bytes;
+                    std::uint64_t offset = 0; //! position of bytes in the file
+                    std::size_t size = 0; //! number of valid bytes
+                };
+
+                positional_file file;
+                std::uint64_t file_size;
+                std::size_t block_size;
+
+                std::vector<block> blocks; //! pool of buffers
+                std::deque<std::size_t> free_blocks; //! buffers which can be filled
+                std::deque<std::size_t> filled_blocks; //! buffers read in the order of the file
+                std::size_t current = no_block; //! buffer of the get area
+                std::uint64_t base = 0; //! position in the file of the start of get area
+                std::uint64_t expected = 0; //! position of the next block to be delivered to the reader
+                std::uint64_t next_read = 0; //! position at which the background thread reads the next block
+                std::uint64_t generation = 0; //! incremented when reads are restarted, older reads are dropped
+                bool failed = false; //! true if a background read failed
+                bool stopping = false;
+
+                std::mutex mutex;
+                std::condition_variable changed;
+                std::thread reader;
+
+                static std::size_t const no_block = static_cast<std::size_t>(-1);
+
+            public:
+                //! opens file_path and starts reading it from the beginning
+                explicit read_ahead_buffer(std::string const& file_path, std::size_t bytes_per_block = 4 << 20,
+                    std::size_t block_count = 4) :
+                    file(file_path), file_size(file.size()), block_size((std::max)(bytes_per_block, std::size_t(1))),
+                    blocks((std::max)(block_count, std::size_t(2)))
+                {
+                    for (std::size_t i = 0; i < this->blocks.size(); i++)
+                    {
+                        this->blocks[i].bytes.resize(this->block_size);
+                        this->free_blocks.push_back(i);
+                    }
+                    this->reader = std::thread([this]()
+                    {
+                        read_blocks();
+                    });
+                }
+
+                read_ahead_buffer(read_ahead_buffer const&) = delete;
+                read_ahead_buffer& operator=(read_ahead_buffer const&) = delete;
+
+                ~read_ahead_buffer()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(this->mutex);
+                        this->stopping = true;
+                    }
+                    this->changed.notify_all();
+                    this->reader.join();
+                }
+
+                //! returns the size of the file in bytes
+                std::uint64_t size() const
+                {
+                    return this->file_size;
+                }
+
+            protected:
+                int_type underflow()
+                {
+                    if (gptr() < egptr())
+                    {
+                        return traits_type::to_int_type(*gptr());
+                    }
+
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    release_current();
+                    if (!take_block(lock))
+                    {
+                        return traits_type::eof();
+                    }
+                    return traits_type::to_int_type(*gptr());
+                }
+
+                pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which)
+                {
+                    std::uint64_t position = this->base + static_cast<std::uint64_t>(gptr() - eback());
+                    if (direction == std::ios_base::beg)
+                    {
+                        position = 0;
+                    }
+                    else if (direction == std::ios_base::end)
+                    {
+                        position = this->file_size;
+                    }
+                    if (offset < 0 && static_cast<std::uint64_t>(-offset) > position)
+                    {
+                        return pos_type(off_type(-1));
+                    }
+                    return seekpos(pos_type(static_cast<off_type>(position + static_cast<std::uint64_t>(offset))), which);
+                }
+
+                pos_type seekpos(pos_type target, std::ios_base::openmode which)
+                {
+                    if (!(which & std::ios_base::in) || target < pos_type(0))
+                    {
+                        return pos_type(off_type(-1));
+                    }
+
+                    std::uint64_t const position = static_cast<std::uint64_t>(static_cast<off_type>(target));
+                    if (this->current != no_block && position >= this->base &&
+                        position < this->base + static_cast<std::uint64_t>(egptr() - eback()))
+                    {
+                        setg(eback(), eback() + (position - this->base), egptr());
+                        return target;
+                    }
+
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    release_current();
+                    if (position >= this->expected && position < this->next_read && !this->failed)
+                    {
+                        //blocks up to position are already read or being read, the ones before it are dropped
+                        while (take_block(lock) && position >= this->base + static_cast<std::uint64_t>(egptr() - eback()))
+                        {
+                            release_current();
+                        }
+                        if (this->current != no_block)
+                        {
+                            setg(eback(), eback() + (position - this->base), egptr());
+                            return target;
+                        }
+                    }
+
+                    //reads restart at position and the blocks read ahead are dropped
+                    restart(position);
+                    this->changed.notify_all();
+                    return target;
+                }
+
+                std::streamsize showmanyc()
+                {
+                    std::uint64_t position = this->base + static_cast<std::uint64_t>(gptr() - eback());
+                    return position < this->file_size ? static_cast<std::streamsize>(this->file_size - position) : -1;
+                }
+
+            private:
+                //! makes the buffer of the get area free, mutex must be locked
+                void release_current()
+                {
+                    if (this->current != no_block)
+                    {
+                        this->base += static_cast<std::uint64_t>(egptr() - eback());
+                        this->free_blocks.push_back(this->current);
+                        this->current = no_block;
+                        setg(nullptr, nullptr, nullptr);
+                        this->changed.notify_all();
+                    }
+                }
+
+                //! waits for the next block and makes it the get area, returns false at the end of file or on error
+                bool take_block(std::unique_lock<std::mutex>& lock)
+                {
+                    if (this->expected >= this->file_size)
+                    {
+                        return false;
+                    }
+                    this->changed.wait(lock, [this]()
+                    {
+                        return !this->filled_blocks.empty() || this->failed;
+                    });
+                    if (this->filled_blocks.empty())
+                    {
+                        return false;
+                    }
+
+                    this->current = this->filled_blocks.front();
+                    this->filled_blocks.pop_front();
+                    block& taken = this->blocks[this->current];
+                    this->base = taken.offset;
+                    this->expected = taken.offset + taken.size;
+                    setg(taken.bytes.data(), taken.bytes.data(), taken.bytes.data() + taken.size);
+                    return true;
+                }
+
+                //! drops all the blocks read ahead and restarts reading at position, mutex must be locked
+                void restart(std::uint64_t position)
+                {
+                    this->generation++;
+                    for (std::size_t index : this->filled_blocks)
+                    {
+                        this->free_blocks.push_back(index);
+                    }
+                    this->filled_blocks.clear();
+                    this->base = position;
+                    this->expected = position;
+                    this->next_read = position;
+                    this->failed = false;
+                }
+
+                //! body of the background thread, fills free buffers with the following blocks of the file
+                void read_blocks()
+                {
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    while (true)
+                    {
+                        this->changed.wait(lock, [this]()
+                        {
+                            return this->stopping ||
+                                (!this->failed && !this->free_blocks.empty() && this->next_read < this->file_size);
+                        });
+                        if (this->stopping)
+                        {
+                            return;
+                        }
+
+                        std::size_t const index = this->free_blocks.front();
+                        this->free_blocks.pop_front();
+                        std::uint64_t const offset = this->next_read;
+                        std::size_t const size = static_cast<std::size_t>(
+                            (std::min)(static_cast<std::uint64_t>(this->block_size), this->file_size - offset));
+                        std::uint64_t const read_generation = this->generation;
+                        this->next_read += size;
+
+                        bool success = true;
+                        lock.unlock();
+                        try
+                        {
+                            this->file.read(this->blocks[index].bytes.data(), size, offset);
+                        }
+                        catch (...)
+                        {
+                            success = false;
+                        }
+                        lock.lock();
+
+                        if (read_generation != this->generation)
+                        {
+                            this->free_blocks.push_back(index);
+                            continue;
+                        }
+                        if (!success)
+                        {
+                            this->free_blocks.push_back(index);
+                            this->failed = true;
+                        }
+                        else
+                        {
+                            this->blocks[index].offset = offset;
+                            this->blocks[index].size = size;
+                            this->filled_blocks.push_back(index);
+                        }
+                        this->changed.notify_all();
+                    }
+                }
+            };
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_READ_AHEAD_BUFFER_HPP
@@ -0,0 +1,149 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_RICE_HPP
+#define BOOST_ASTRONOMY_DETAIL_RICE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! reads a big-endian bit stream (most significant bit of every byte first)
+            class bit_reader
+            {
+                unsigned char const* next;
+                unsigned char const* end;
+                std::uint64_t bits; //! unread bits, right aligned
+                int available; //! number of unread bits in bits
+
+                void refill()
+                {
+                    while (available <= 48 && next != end)
+                    {
+                        bits = (bits << 8) | *next++;
+                        available += 8;
+                    }
+                }
+
+                static int highest_bit(std::uint64_t value)
+                {
+#if defined(__GNUC__) || defined(__clang__)
+                    return 63 - __builtin_clzll(value);
+#else
+                    int bit = 0;
+                    while (value >>= 1)
+                    {
+                        bit++;
+                    }
+                    return bit;
+#endif
+                }
+
+            public:
+                bit_reader(unsigned char const* first, unsigned char const* last) :
+                    next(first), end(last), bits(0), available(0) {}
+
+                //! returns the next count (at most 32) bits
+                std::uint32_t read(int count)
+                {
+                    if (available < count)
+                    {
+                        refill();
+                        if (available < count)
+                        {
+                            throw invalid_compressed_data_exception();
+                        }
+                    }
+                    available -= count;
+                    std::uint32_t value = static_cast<std::uint32_t>(bits >> available) &
+                        static_cast<std::uint32_t>((std::uint64_t(1) << count) - 1);
+                    bits &= (std::uint64_t(1) << available) - 1;
+                    return value;
+                }
+
+                //! returns the number of 0 bits before the next 1 bit, both are consumed
+                std::uint32_t read_unary()
+                {
+                    std::uint32_t zeros = 0;
+                    while (true)
+                    {
+                        if (bits == 0)
+                        {
+                            zeros += static_cast<std::uint32_t>(available);
+                            available = 0;
+                            refill();
+                            if (available == 0)
+                            {
+                                throw invalid_compressed_data_exception();
+                            }
+                            continue;
+                        }
+
+                        int one = highest_bit(bits);
+                        zeros += static_cast<std::uint32_t>(available - 1 - one);
+                        available = one;
+                        bits &= (std::uint64_t(1) << available) - 1;
+                        return zeros;
+                    }
+                }
+            };
+
+            //! decodes count values compressed with the Rice algorithm of the FITS tiled image convention (RICE_1)
+            //! Unsigned is the unsigned integer of BYTEPIX bytes, values are reconstructed modulo its range
+            //! block_size is the value of BLOCKSIZE (number of differences sharing one code length, 32 by default)
+            template <typename Unsigned>
+            void rice_decode(unsigned char const* input, std::size_t size, Unsigned* output, std::size_t count,
+                std::size_t block_size = 32)
+            {
+                int const fs_bits = sizeof(Unsigned) == 1 ? 3 : (sizeof(Unsigned) == 2 ? 4 : 5);
+                int const fs_max = sizeof(Unsigned) == 1 ? 6 : (sizeof(Unsigned) == 2 ? 14 : 25);
+                int const value_bits = 8 * static_cast<int>(sizeof(Unsigned));
+
+                if (size < sizeof(Unsigned) || block_size == 0)
+                {
+                    throw invalid_compressed_data_exception();
+                }
+
+                //first value is stored as it is, the others as differences from the previous value
+                std::uint32_t last = 0;
+                for (std::size_t i = 0; i < sizeof(Unsigned); i++)
+                {
+                    last = (last << 8) | input[i];
+                }
+
+                bit_reader reader(input + sizeof(Unsigned), input + size);
+                for (std::size_t i = 0; i < count; )
+                {
+                    int const fs = static_cast<int>(reader.read(fs_bits)) - 1;
+                    std::size_t const block_end = (std::min)(count, i + block_size);
+
+                    if (fs < 0)
+                    {
+                        //all the differences of the block are 0
+                        std::fill(output + i, output + block_end, static_cast<Unsigned>(last));
+                        i = block_end;
+                        continue;
+                    }
+
+                    for (; i < block_end; i++)
+                    {
+                        //differences are stored directly when fs == fs_max, otherwise the high bits are in unary
+                        std::uint32_t difference = fs == fs_max ? reader.read(value_bits) :
+                            (reader.read_unary() << fs) | (fs > 0 ? reader.read(fs) : 0);
+                        difference = (difference & 1) ? ~(difference >> 1) : (difference >> 1);
+                        last = static_cast<Unsigned>(last + difference);
+                        output[i] = static_cast<Unsigned>(last);
+                    }
+                }
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_RICE_HPP
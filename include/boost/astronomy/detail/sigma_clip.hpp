@@ -0,0 +1,146 @@
+#ifndef BOOST_ASTRONOMY_DETAIL_SIGMA_CLIP_HPP
+#define BOOST_ASTRONOMY_DETAIL_SIGMA_CLIP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace detail
+        {
+            //! mean, median and standard deviation (divided by count) of values sorted in increasing order
+            struct clipped_statistics
+            {
+                std::size_t count = 0; //!number of values kept
+                double mean = 0;
+                double median = 0; //!mean of the two middle values for an even count
+                double sigma = 0;
+
+                template <typename T>
+                static clipped_statistics of_sorted(T const* first, T const* last)
+                {
+                    clipped_statistics result;
+                    result.count = static_cast<std::size_t>(last - first);
+                    if (result.count == 0)
+                    {
+                        return result;
+                    }
+
+                    double sum = 0;
+                    for (T const* value = first; value != last; value++)
+                    {
+                        sum += static_cast<double>(*value);
+                    }
+                    result.mean = sum / static_cast<double>(result.count);
+                    result.median = (static_cast<double>(first[(result.count - 1) / 2]) +
+                        static_cast<double>(first[result.count / 2])) / 2;
+
+                    double m2 = 0;
+                    for (T const* value = first; value != last; value++)
+                    {
+                        double const delta = static_cast<double>(*value) - result.mean;
+                        m2 += delta * delta;
+                    }
+                    result.sigma = std::sqrt(m2 / static_cast<double>(result.count));
+                    return result;
+                }
+            };
+
+            //! sorts [first, last) and narrows it to the values kept by iterative sigma clipping: every iteration
+            //! rejects the values more than sigma_low standard deviations below or sigma_high above the median of
+            //! the values kept so far, until no value is rejected, max_iterations are done or 2 values are left
+            //! returns the statistics of the values kept, which are [first, last) on return
+            template <typename T>
+            clipped_statistics sigma_clip(T*& first, T*& last, double sigma_low, double sigma_high, std::size_t max_iterations)
+            {
+                std::sort(first, last);
+                clipped_statistics statistics = clipped_statistics::of_sorted(first, last);
+                for (std::size_t iteration = 0; iteration < max_iterations && last - first > 2; iteration++)
+                {
+                    double const low = statistics.median - sigma_low * statistics.sigma;
+                    double const high = statistics.median + sigma_high * statistics.sigma;
+                    T* const kept_first = std::lower_bound(first, last, low,
+                        [](T value, double bound) { return static_cast<double>(value) < bound; });
+                    T* const kept_last = std::upper_bound(kept_first, last, high,
+                        [](double bound, T value) { return bound < static_cast<double>(value); });
+                    if (kept_first == first && kept_last == last)
+                    {
+                        break;
+                    }
+                    first = kept_first;
+                    last = kept_last;
+                    statistics = clipped_statistics::of_sorted(first, last);
+                }
+                return statistics;
+            }
+
+            //! statistics of [first, last), which is reordered to find the median
+            template <typename T>
+            clipped_statistics statistics_of_unsorted(T* first, T* last)
+            {
+                clipped_statistics result;
+                result.count = static_cast<std::size_t>(last - first);
+                if (result.count == 0)
+                {
+                    return result;
+                }
+
+                double sum = 0;
+                for (T const* value = first; value != last; value++)
+                {
+                    sum += static_cast<double>(*value);
+                }
+                result.mean = sum / static_cast<double>(result.count);
+                double m2 = 0;
+                for (T const* value = first; value != last; value++)
+                {
+                    double const delta = static_cast<double>(*value) - result.mean;
+                    m2 += delta * delta;
+                }
+                result.sigma = std::sqrt(m2 / static_cast<double>(result.count));
+
+                T* const middle = first + result.count / 2;
+                std::nth_element(first, middle, last);
+                result.median = static_cast<double>(*middle);
+                if (result.count % 2 == 0)
+                {
+                    result.median = (result.median + static_cast<double>(*std::max_element(first, middle))) / 2;
+                }
+                return result;
+            }
+
+            //! same as sigma_clip() without sorting, for large numbers of values: every iteration finds the median
+            //! with nth_element and moves the values kept to the front of [first, last) with partitions
+            //! the values kept are [first, last) on return in no particular order
+            template <typename T>
+            clipped_statistics sigma_clip_unsorted(T*& first, T*& last, double sigma_low, double sigma_high,
+                std::size_t max_iterations)
+            {
+                clipped_statistics statistics = statistics_of_unsorted(first, last);
+                for (std::size_t iteration = 0; iteration < max_iterations && last - first > 2; iteration++)
+                {
+                    double const low = statistics.median - sigma_low * statistics.sigma;
+                    double const high = statistics.median + sigma_high * statistics.sigma;
+                    T* const kept_first = std::partition(first, last,
+                        [low](T value) { return static_cast<double>(value) < low; });
+                    T* const kept_last = std::partition(kept_first, last,
+                        [high](T value) { return !(high < static_cast<double>(value)); });
+                    if (kept_first == first && kept_last == last)
+                    {
+                        break;
+                    }
+                    first = kept_first;
+                    last = kept_last;
+                    statistics = statistics_of_unsorted(first, last);
+                }
+                return statistics;
+            }
+        } //namespace detail
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_DETAIL_SIGMA_CLIP_HPP
@@ -61,6 +61,87 @@ namespace boost
             }
         };
 
+        class region_out_of_range_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Region is not completely inside the image";
+            }
+        };
+
+        class unsupported_compression_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Compression method of the tile compressed image is not supported";
+            }
+        };
+
+        class invalid_compressed_data_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Compressed data of the tile compressed image is not valid";
+            }
+        };
+
+        class column_not_found_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Table has no column with the given name";
+            }
+        };
+
+        class column_type_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Requested type does not match the data type of the column";
+            }
+        };
+
+        class invalid_table_field_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Field of the ASCII table is not a valid number";
+            }
+        };
+
+        class invalid_value_type_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Value of the card cannot be converted to the requested type";
+            }
+        };
+
+        class image_size_mismatch_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Images combined in an expression do not have the same size";
+            }
+        };
+
+        class invalid_percentile_exception : public fits_exception
+        {
+        public:
+            const char* what() const throw()
+            {
+                return "Percentile must be in [0, 100]";
+            }
+        };
+
     } //namespace astronomy
 } //namespace boost
 #endif // !BOOST_ASTRONOMY_EXCEPTION_FITS_EXCEPTION_HPP
@@ -0,0 +1,192 @@
+#ifndef BOOST_ASTRONOMY_IO_ASCII_TABLE_EXTENSION_HPP
+#define BOOST_ASTRONOMY_IO_ASCII_TABLE_EXTENSION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <algorithm>
+
+#include <boost/astronomy/io/hdu.hpp>
+#include <boost/astronomy/io/column_format.hpp>
+#include <boost/astronomy/io/table_column.hpp>
+#include <boost/astronomy/io/table_extension.hpp>
+#include <boost/astronomy/io/table_selection.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/detail/fixed_width_number.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!ASCII table extension (XTENSION = 'TABLE') whose fields are converted into columns
+            //!Aw fields are stored as characters, Iw fields as std::int64_t and Fw.d, Ew.d, Dw.d fields as double
+            //!blocks of rows are parsed by a pool of threads, fields equal to TNULLn are NaN in real columns
+            //!and 0 in integer columns if they are not numbers
+            struct ascii_table_extension : public table_extension<ascii_table_extension, ascii_column_format>
+            {
+            protected:
+                typedef table_extension<ascii_table_extension, ascii_column_format> table_base;
+                friend table_base;
+
+                static std::size_t const block_bytes = 1 << 20; //!size of the blocks of rows parsed by one thread
+
+            public:
+                //!reads and parses the selected columns and rows of the HDU whose header other has just been read from file
+                //!rows are parsed by up to threads threads (0 uses all hardware threads)
+                ascii_table_extension(std::fstream &file, hdu const& other, table_selection const& query = table_selection(),
+                    std::size_t threads = 0) : table_base(other, query)
+                {
+                    set_layout();
+                    this->read_data_unit(file, threads);
+                }
+
+                //!This constructor should be used when the file is memory mapped, offset is the position of data unit in the file
+                //!selected columns are parsed from the mapped file when first accessed
+                ascii_table_extension(std::shared_ptr<mapped_file const> const& file, std::size_t offset, hdu const& other,
+                    table_selection const& query = table_selection()) : table_base(file, offset, other, query)
+                {
+                    set_layout();
+                }
+
+                //!This constructor should be used when data unit is read on demand, offset is the position of data unit in path
+                //!selected columns are read from the file on the first access or on the call to load_data()
+                ascii_table_extension(std::string const& path, std::size_t offset, hdu const& other,
+                    table_selection const& query = table_selection()) : table_base(path, offset, other, query)
+                {
+                    set_layout();
+                }
+
+            protected:
+                //!reads the number and size of rows and the format of every field (TFORMn, TBCOLn, TTYPEn, TNULLn) from the header
+                void set_layout()
+                {
+                    this->row_size = this->naxis(1);
+                    this->rows = this->naxis(2);
+                    this->formats = read_ascii_column_formats(*this);
+                    this->resolve(this->selection);
+                }
+
+                //!parses the selected columns straight from the mapped data unit
+                void load_mapped(std::size_t threads) const
+                {
+                    char const* unit = this->data_unit.get();
+                    load_columns([unit](char* buffer, std::size_t size, std::uint64_t offset)
+                    {
+                        std::memcpy(buffer, unit + offset, size);
+                    }, threads);
+                }
+
+                //!reads the selected rows through read(buffer, size, offset in data unit) block by block and parses
+                //!the selected fields of every block, blocks are read and parsed by up to threads threads
+                template <typename Read>
+                void load_columns(Read const& read, std::size_t threads) const
+                {
+                    std::vector<std::size_t> indices = this->resolve(this->selection);
+                    std::size_t const first = (std::min)(this->selection.first_row, this->rows);
+                    std::size_t const count = this->selection.rows_in(this->rows);
+
+                    std::vector<table_column> result;
+                    result.reserve(indices.size());
+                    for (std::size_t index : indices)
+                    {
+                        result.emplace_back(this->formats[index].stored_format(), count);
+                    }
+
+                    std::size_t const width = this->row_size;
+                    std::size_t const block_rows = (std::max)(std::size_t(1), block_bytes / (std::max)(width, std::size_t(1)));
+                    boost::astronomy::detail::parallel_for((count + block_rows - 1) / block_rows, [&](std::size_t block)
+                    {
+                        std::size_t const target = block * block_rows;
+                        std::size_t const block_count = (std::min)(block_rows, count - target);
+                        std::vector<char> buffer(block_count * width);
+                        read(buffer.data(), buffer.size(), static_cast<std::uint64_t>(first + target) * width);
+
+                        for (std::size_t i = 0; i < result.size(); i++)
+                        {
+                            parse_field(this->formats[indices[i]], buffer.data(), width, block_count, result[i], target);
+                        }
+                    }, threads);
+
+                    this->columns.swap(result);
+                    this->column_indices.swap(indices);
+                    this->loaded = true;
+                }
+
+                //!returns true if the field [begin, end) without surrounding spaces is the null value of format
+                static bool is_null(ascii_column_format const& format, char const* begin, char const* end)
+                {
+                    if (format.null.empty())
+                    {
+                        return false;
+                    }
+                    while (begin != end && *begin == ' ')
+                    {
+                        ++begin;
+                    }
+                    while (begin != end && end[-1] == ' ')
+                    {
+                        --end;
+                    }
+                    return static_cast<std::size_t>(end - begin) == format.null.size() &&
+                        std::equal(begin, end, format.null.begin());
+                }
+
+                //!parses the field of format in count rows of block (rows of width characters) into column from row target
+                static void parse_field(ascii_column_format const& format, char const* block, std::size_t width,
+                    std::size_t count, table_column& column, std::size_t target)
+                {
+                    char const* field = block + format.offset;
+                    if (format.type == 'A')
+                    {
+                        char* output = column.data<char>() + target * format.width;
+                        for (std::size_t i = 0; i < count; i++, field += width, output += format.width)
+                        {
+                            std::memcpy(output, field, format.width);
+                        }
+                    }
+                    else if (format.type == 'I')
+                    {
+                        std::int64_t* output = column.data<std::int64_t>() + target;
+                        for (std::size_t i = 0; i < count; i++, field += width)
+                        {
+                            if (!boost::astronomy::detail::parse_integer(field, field + format.width, output[i]))
+                            {
+                                if (!is_null(format, field, field + format.width))
+                                {
+                                    throw invalid_table_field_exception();
+                                }
+                                output[i] = 0;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        double* output = column.data<double>() + target;
+                        for (std::size_t i = 0; i < count; i++, field += width)
+                        {
+                            if (is_null(format, field, field + format.width))
+                            {
+                                output[i] = std::numeric_limits<double>::quiet_NaN();
+                            }
+                            else if (!boost::astronomy::detail::parse_real(field, field + format.width, format.decimals, output[i]))
+                            {
+                                throw invalid_table_field_exception();
+                            }
+                        }
+                    }
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_ASCII_TABLE_EXTENSION_HPP
@@ -0,0 +1,305 @@
+#ifndef BOOST_ASTRONOMY_IO_BINARY_TABLE_EXTENSION_HPP
+#define BOOST_ASTRONOMY_IO_BINARY_TABLE_EXTENSION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <algorithm>
+
+#include <boost/astronomy/io/hdu.hpp>
+#include <boost/astronomy/io/column_format.hpp>
+#include <boost/astronomy/io/table_column.hpp>
+#include <boost/astronomy/io/table_extension.hpp>
+#include <boost/astronomy/io/table_selection.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!binary table extension (XTENSION = 'BINTABLE') whose fields are stored column by column
+            //!every column is one contiguous array in native byte order, rows are converted in blocks by a pool of threads
+            //!a table_selection restricts the columns and rows read, the bytes of other fields are neither read nor converted
+            struct binary_table_extension : public table_extension<binary_table_extension, column_format>
+            {
+            protected:
+                typedef table_extension<binary_table_extension, column_format> table_base;
+                friend table_base;
+
+                //!bytes [begin, end) of a row which are read together, compact is their position in the rows read
+                struct row_span
+                {
+                    std::size_t begin;
+                    std::size_t end;
+                    std::size_t compact;
+                };
+
+                std::uint64_t heap_offset = 0; //!THEAP, position of the heap from the start of data unit
+
+                static std::size_t const block_bytes = 1 << 20; //!size of the blocks of rows converted by one thread
+                static std::size_t const gap_bytes = 4096; //!fields closer than this are read with the bytes between them
+
+            public:
+                //!reads the selected columns and rows of the HDU whose header other has just been read from file
+                //!the columns are converted by up to threads threads (0 uses all hardware threads)
+                binary_table_extension(std::fstream &file, hdu const& other, table_selection const& query = table_selection(),
+                    std::size_t threads = 0) : table_base(other, query)
+                {
+                    set_layout();
+                    this->read_data_unit(file, threads);
+                }
+
+                //!This constructor should be used when the file is memory mapped, offset is the position of data unit in the file
+                //!selected columns are converted from the mapped file when first accessed
+                binary_table_extension(std::shared_ptr<mapped_file const> const& file, std::size_t offset, hdu const& other,
+                    table_selection const& query = table_selection()) : table_base(file, offset, other, query)
+                {
+                    set_layout();
+                }
+
+                //!This constructor should be used when data unit is read on demand, offset is the position of data unit in path
+                //!selected columns are read from the file on the first access or on the call to load_data()
+                binary_table_extension(std::string const& path, std::size_t offset, hdu const& other,
+                    table_selection const& query = table_selection()) : table_base(path, offset, other, query)
+                {
+                    set_layout();
+                }
+
+                //!reads the columns and rows of query from a mapped or deferred HDU without changing the stored columns
+                //!columns are returned in the order of query.columns, throws fits_exception for HDUs read from a stream
+                std::vector<table_column> read_columns(table_selection const& query, std::size_t threads = 0) const
+                {
+                    std::vector<std::size_t> indices = this->resolve(query);
+                    if (this->data_unit)
+                    {
+                        return gather(this->data_unit.get(), indices, query, threads);
+                    }
+                    if (this->file_path.empty())
+                    {
+                        throw fits_exception();
+                    }
+
+                    boost::astronomy::detail::positional_file file(this->file_path);
+                    return read_selected(reader_of(file), indices, query, threads);
+                }
+
+            protected:
+                //!reads the number and size of rows, the position of heap and the format of every field from the header
+                void set_layout()
+                {
+                    this->row_size = this->naxis(1);
+                    this->rows = this->naxis(2);
+                    this->formats = read_column_formats(*this);
+                    this->heap_offset = this->has_key("THEAP") ? this->value_of<std::uint64_t>("THEAP") :
+                        static_cast<std::uint64_t>(this->row_size) * this->rows;
+                    if (this->heap_offset > this->data_size())
+                    {
+                        throw fits_exception();
+                    }
+                    this->resolve(this->selection);
+                }
+
+                //!converts the selected columns straight from the mapped data unit
+                void load_mapped(std::size_t threads) const
+                {
+                    this->column_indices = this->resolve(this->selection);
+                    this->columns = gather(this->data_unit.get(), this->column_indices, this->selection, threads);
+                    this->loaded = true;
+                }
+
+                //!returns the number of rows converted by one thread at a time when rows are stride bytes apart
+                static std::size_t rows_per_block(std::size_t stride)
+                {
+                    return (std::max)(std::size_t(1), block_bytes / (std::max)(stride, std::size_t(1)));
+                }
+
+                //!reads and stores the selected columns through read(buffer, size, offset in data unit)
+                template <typename Read>
+                void load_columns(Read const& read, std::size_t threads) const
+                {
+                    std::vector<std::size_t> indices = this->resolve(this->selection);
+                    this->columns = read_selected(read, indices, this->selection, threads);
+                    this->column_indices.swap(indices);
+                    this->loaded = true;
+                }
+
+                //!converts the columns indices of the rows of query directly from unit (the whole data unit in memory)
+                std::vector<table_column> gather(char const* unit, std::vector<std::size_t> const& indices,
+                    table_selection const& query, std::size_t threads) const
+                {
+                    std::size_t const first = (std::min)(query.first_row, this->rows);
+                    std::size_t const count = query.rows_in(this->rows);
+                    std::vector<table_column> result = make_columns(indices, count);
+
+                    std::size_t const block_rows = rows_per_block(this->row_size);
+                    std::size_t const width = this->row_size;
+                    boost::astronomy::detail::parallel_for((count + block_rows - 1) / block_rows, [&](std::size_t block)
+                    {
+                        std::size_t const target = block * block_rows;
+                        std::size_t const block_count = (std::min)(block_rows, count - target);
+                        for (table_column& column : result)
+                        {
+                            column.assign_rows(unit + (first + target) * width + column.get_format().offset, width,
+                                block_count, target);
+                        }
+                    }, threads);
+
+                    for (table_column& column : result)
+                    {
+                        column.read_heap(unit + this->heap_offset, 0, this->data_size() - this->heap_offset);
+                    }
+                    return result;
+                }
+
+                //!reads only the bytes of the columns indices in the rows of query through read and converts them
+                //!fields of a row which are close together are read at once, rows are read contiguously when the bytes
+                //!skipped in every row are few and with one read per row and group of fields otherwise
+                template <typename Read>
+                std::vector<table_column> read_selected(Read const& read, std::vector<std::size_t> const& indices,
+                    table_selection const& query, std::size_t threads) const
+                {
+                    std::size_t const first = (std::min)(query.first_row, this->rows);
+                    std::size_t const count = query.rows_in(this->rows);
+                    std::vector<table_column> result = make_columns(indices, count);
+                    if (result.empty() || count == 0)
+                    {
+                        read_heaps(read, result);
+                        return result;
+                    }
+
+                    std::vector<row_span> spans = merge_fields(indices);
+                    std::size_t const span_bytes = spans.back().compact + spans.back().end - spans.back().begin;
+                    bool const contiguous = this->row_size - span_bytes < gap_bytes;
+                    std::size_t const stride = contiguous ? this->row_size : span_bytes;
+
+                    //position of the field of every column in the rows read
+                    std::vector<std::size_t> field_offsets;
+                    for (table_column const& column : result)
+                    {
+                        std::size_t const offset = column.get_format().offset;
+                        if (contiguous)
+                        {
+                            field_offsets.push_back(offset - spans.front().begin);
+                            continue;
+                        }
+                        for (row_span const& span : spans)
+                        {
+                            if (offset >= span.begin && offset + column.get_format().size <= span.end)
+                            {
+                                field_offsets.push_back(span.compact + offset - span.begin);
+                                break;
+                            }
+                        }
+                    }
+
+                    std::size_t const block_rows = rows_per_block(stride);
+                    std::size_t const width = this->row_size;
+                    boost::astronomy::detail::parallel_for((count + block_rows - 1) / block_rows, [&](std::size_t block)
+                    {
+                        std::size_t const target = block * block_rows;
+                        std::size_t const block_count = (std::min)(block_rows, count - target);
+                        std::uint64_t const row_offset = static_cast<std::uint64_t>(first + target) * width;
+                        std::vector<char> buffer;
+
+                        if (contiguous)
+                        {
+                            std::size_t const bytes = spans.back().end - spans.front().begin;
+                            buffer.resize((block_count - 1) * width + bytes);
+                            read(buffer.data(), buffer.size(), row_offset + spans.front().begin);
+                        }
+                        else
+                        {
+                            buffer.resize(block_count * stride);
+                            for (std::size_t row = 0; row < block_count; row++)
+                            {
+                                for (row_span const& span : spans)
+                                {
+                                    read(buffer.data() + row * stride + span.compact, span.end - span.begin,
+                                        row_offset + row * width + span.begin);
+                                }
+                            }
+                        }
+
+                        for (std::size_t i = 0; i < result.size(); i++)
+                        {
+                            result[i].assign_rows(buffer.data() + field_offsets[i], stride, block_count, target);
+                        }
+                    }, threads);
+
+                    read_heaps(read, result);
+                    return result;
+                }
+
+                //!reads the part of the heap holding the variable length arrays of every column
+                template <typename Read>
+                void read_heaps(Read const& read, std::vector<table_column>& result) const
+                {
+                    std::vector<char> heap;
+                    for (table_column& column : result)
+                    {
+                        std::pair<std::uint64_t, std::uint64_t> range = column.heap_range();
+                        if (this->heap_offset + range.second > this->data_size())
+                        {
+                            throw fits_exception();
+                        }
+                        heap.resize(static_cast<std::size_t>(range.second - range.first));
+                        if (!heap.empty())
+                        {
+                            read(heap.data(), heap.size(), this->heap_offset + range.first);
+                        }
+                        column.read_heap(heap.data(), range.first, heap.size());
+                    }
+                }
+
+                std::vector<table_column> make_columns(std::vector<std::size_t> const& indices, std::size_t count) const
+                {
+                    std::vector<table_column> result;
+                    result.reserve(indices.size());
+                    for (std::size_t index : indices)
+                    {
+                        result.emplace_back(this->formats[index], count);
+                    }
+                    return result;
+                }
+
+                //!returns the bytes of a row holding the fields indices, fields less than gap_bytes apart are merged
+                std::vector<row_span> merge_fields(std::vector<std::size_t> const& indices) const
+                {
+                    std::vector<row_span> fields;
+                    for (std::size_t index : indices)
+                    {
+                        row_span span = {this->formats[index].offset, this->formats[index].offset + this->formats[index].size, 0};
+                        fields.push_back(span);
+                    }
+                    std::sort(fields.begin(), fields.end(), [](row_span const& a, row_span const& b)
+                    {
+                        return a.begin < b.begin;
+                    });
+
+                    std::vector<row_span> spans;
+                    for (row_span const& field : fields)
+                    {
+                        if (!spans.empty() && field.begin < spans.back().end + gap_bytes)
+                        {
+                            spans.back().end = (std::max)(spans.back().end, field.end);
+                            continue;
+                        }
+                        row_span span = {field.begin, field.end, spans.empty() ? 0 : spans.back().compact + spans.back().end - spans.back().begin};
+                        spans.push_back(span);
+                    }
+                    return spans;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_BINARY_TABLE_EXTENSION_HPP
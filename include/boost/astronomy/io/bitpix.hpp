@@ -1,6 +1,10 @@
 #ifndef BOOST_ASTRONOMY_IO_BITPIX_HPP
 #define BOOST_ASTRONOMY_IO_BITPIX_HPP
 
+#include <cstddef>
+
+#include <boost/astronomy/exception/fits_exception.hpp>
+
 namespace boost
 {
     namespace astronomy
@@ -16,6 +20,61 @@ namespace boost
                 _B32, //! 32-bit IEEE single precesion floating point
                 _B64 //! 64-bit IEEE double precesion floating point
             };
+
+            //! returns the size in bytes of one value of the given bitpix
+            inline std::size_t element_size(bitpix value)
+            {
+                switch (value)
+                {
+                case B8:
+                    return 1;
+                case B16:
+                    return 2;
+                case B32:
+                case _B32:
+                    return 4;
+                default:
+                    return 8;
+                }
+            }
+
+            //! returns the bitpix for the value of BITPIX keyword, throws fits_exception for invalid values
+            inline bitpix to_bitpix(int value)
+            {
+                switch (value)
+                {
+                case 8:
+                    return B8;
+                case 16:
+                    return B16;
+                case 32:
+                    return B32;
+                case -32:
+                    return _B32;
+                case -64:
+                    return _B64;
+                default:
+                    throw fits_exception();
+                }
+            }
+
+            //! returns the value of BITPIX keyword for the given bitpix
+            inline int header_value(bitpix value)
+            {
+                switch (value)
+                {
+                case B8:
+                    return 8;
+                case B16:
+                    return 16;
+                case B32:
+                    return 32;
+                case _B32:
+                    return -32;
+                default:
+                    return -64;
+                }
+            }
         }
     }
 }
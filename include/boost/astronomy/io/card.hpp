@@ -3,11 +3,17 @@
 
 #include <string>
 #include <sstream>
+#include <atomic>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
-#include <boost/algorithm/string/trim.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/utility/string_view.hpp>
 
 #include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/io/card_value.hpp>
 
 namespace boost
 {
@@ -19,36 +25,158 @@ namespace boost
             struct card
             {
             private:
-                std::string card_;
+                std::string storage; //!characters of the card if the card owns them (empty for cards referring to a header buffer)
+                boost::string_view card_; //!the 80 chars of card, either storage or a part of an external header buffer
+                mutable card_value cached; //!value parsed on the first call to value(), valid when state is parsed
+                mutable std::atomic<unsigned char> state; //!unparsed, parsing or parsed
 
-            public:
-                card()
+                static unsigned char const unparsed = 0;
+                static unsigned char const parsing = 1;
+                static unsigned char const parsed = 2;
+
+                void assign(std::string const& str)
+                {
+                    this->storage = str;
+                    this->card_ = boost::string_view(this->storage);
+                    this->state.store(unparsed, std::memory_order_relaxed);
+                }
+
+                //!copies the parsed value of other if it has one, the text of the value is stored as a position so it stays valid
+                void copy_value(card const& other)
+                {
+                    if (other.state.load(std::memory_order_acquire) == parsed)
+                    {
+                        this->cached = other.cached;
+                        this->state.store(parsed, std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        this->state.store(unparsed, std::memory_order_relaxed);
+                    }
+                }
+
+                static boost::string_view trim(boost::string_view str)
+                {
+                    while (!str.empty() && str.front() == ' ')
+                    {
+                        str.remove_prefix(1);
+                    }
+                    while (!str.empty() && str.back() == ' ')
+                    {
+                        str.remove_suffix(1);
+                    }
+                    return str;
+                }
+
+                template <typename ReturnType>
+                struct type_tag {};
+
+                //!integral values must be integers in the range of ReturnType
+                template <typename ReturnType>
+                ReturnType convert(card_value const& typed, type_tag<ReturnType>,
+                    typename std::enable_if<std::is_integral<ReturnType>::value>::type* = 0) const
+                {
+                    if (typed.type != card_value::integer)
+                    {
+                        throw invalid_value_type_exception();
+                    }
+                    std::int64_t const value = typed.integer_value;
+                    bool const below = value < static_cast<std::int64_t>((std::numeric_limits<ReturnType>::min)());
+                    bool const above = value > 0 &&
+                        static_cast<std::uint64_t>(value) > static_cast<std::uint64_t>((std::numeric_limits<ReturnType>::max)());
+                    if (below || above)
+                    {
+                        throw invalid_value_type_exception();
+                    }
+                    return static_cast<ReturnType>(value);
+                }
+
+                //!floating point values can be integers or reals
+                template <typename ReturnType>
+                ReturnType convert(card_value const& typed, type_tag<ReturnType>,
+                    typename std::enable_if<std::is_floating_point<ReturnType>::value>::type* = 0) const
+                {
+                    if (typed.type != card_value::integer && typed.type != card_value::real)
+                    {
+                        throw invalid_value_type_exception();
+                    }
+                    return static_cast<ReturnType>(typed.real_value);
+                }
+
+                //!other types are converted from the text of the value
+                template <typename ReturnType>
+                ReturnType convert(card_value const& typed, type_tag<ReturnType>,
+                    typename std::enable_if<!std::is_arithmetic<ReturnType>::value>::type* = 0) const
+                {
+                    boost::string_view val = typed.text(this->card_);
+                    return boost::lexical_cast<ReturnType>(val.data(), val.size());
+                }
+
+                bool convert(card_value const& typed, type_tag<bool>) const
+                {
+                    return typed.type == card_value::logical && typed.logical_value;
+                }
+
+                std::string convert(card_value const& typed, type_tag<std::string>) const
                 {
-                    this->card_.reserve(80);
+                    boost::string_view val = typed.text(this->card_);
+                    return std::string(val.data(), val.size());
                 }
+
+                template <typename Real>
+                std::complex<Real> convert(card_value const& typed, type_tag<std::complex<Real>>) const
+                {
+                    if (typed.type == card_value::complex)
+                    {
+                        return std::complex<Real>(static_cast<Real>(typed.real_value), static_cast<Real>(typed.imaginary_value));
+                    }
+                    return std::complex<Real>(convert(typed, type_tag<Real>()), 0);
+                }
+
+            public:
+                card() : state(unparsed) {}
+
                 //! creating card from const char*
-                //! it will read 80 char from provided pointer
-                card(char const* c) : card()
+                //! it will copy 80 char from provided pointer
+                card(char const* c) : state(unparsed)
                 {
-                    this->card_.assign(c, 80);
+                    this->assign(std::string(c, 80));
+                }
+
+                //! creating card referring to the first 80 chars of an external buffer (e.g. the header buffer of hdu)
+                //! nothing is copied so the buffer must outlive the card
+                explicit card(boost::string_view c) : card_(c.substr(0, 80)), state(unparsed) {}
+
+                card(card const& other) : storage(other.storage),
+                    card_(other.storage.empty() ? other.card_ : boost::string_view(this->storage))
+                {
+                    copy_value(other);
+                }
+
+                card& operator=(card const& other)
+                {
+                    this->storage = other.storage;
+                    this->card_ = other.storage.empty() ? other.card_ : boost::string_view(this->storage);
+                    copy_value(other);
+                    return *this;
                 }
 
                 //!a string is expected with lenght no more than 80 chars 
                 //!this string will be directly stored in the card
                 //!string must follow all the standerd of the key, value and comment for card
-                card(std::string str) : card()
+                card(std::string str) : state(unparsed)
                 {
                     if (str.length() > 80)
                     {
                         throw invalid_card_length_exception();
                     }
-                    this->card_ = str.append(80 - str.length(), ' ');
+                    this->assign(str.append(80 - str.length(), ' '));
                 }
 
                 //!key, value and optional comments are expected
                 //!all the values will be directly stored as provided so necessary spaces befor values must be provided
                 //!spaces after the keyword and value will be taken care implicitly
-                card(std::string const& key, std::string const& value, std::string const& comment = "")
+                card(std::string const& key, std::string const& value, std::string const& comment = "") : state(unparsed)
                 {
                     if (key.length() > 8)
                     {
@@ -65,12 +193,12 @@ namespace boost
 
                     if (comment.length())
                     {
-                        this->card_ = std::string(key).append(8 - key.length(), ' ') + "= " + value + " /" + comment +
-                            std::string("").append(68 - value.length() + comment.length(), ' ');
+                        this->assign(std::string(key).append(8 - key.length(), ' ') + "= " + value + " /" + comment +
+                            std::string("").append(68 - value.length() - comment.length(), ' '));
                     }
                     else
                     {
-                        this->card_ = std::string(key).append(8 - key.length(), ' ') + "= " + std::string(value).append(70 - key.length(), ' ');
+                        this->assign(std::string(key).append(8 - key.length(), ' ') + "= " + std::string(value).append(70 - value.length(), ' '));
                     }
                 }
 
@@ -95,12 +223,12 @@ namespace boost
 
                     if (comment.length())
                     {
-                        this->card_ = std::string(key).append(8 - key.length(), ' ') + "= " + value + " /" + comment +
-                            std::string("").append(68 - value.length() + comment.length(), ' ');
+                        this->assign(std::string(key).append(8 - key.length(), ' ') + "= " + value + " /" + comment +
+                            std::string("").append(68 - value.length() - comment.length(), ' '));
                     }
                     else
                     {
-                        this->card_ = std::string(key).append(8 - key.length(), ' ') + "= " + std::string(value).append(70 - key.length(), ' ');
+                        this->assign(std::string(key).append(8 - key.length(), ' ') + "= " + std::string(value).append(70 - value.length(), ' '));
                     }
                 }
 
@@ -109,11 +237,11 @@ namespace boost
                 {
                     if (value)
                     {
-                        create_card(key, std::string("T").insert(0, ' ', 19), comment);
+                        create_card(key, std::string("T").insert(0, 19, ' '), comment);
                     }
                     else
                     {
-                        create_card(key, std::string("F").insert(0, ' ', 19), comment);
+                        create_card(key, std::string("F").insert(0, 19, ' '), comment);
                     }
                 }
 
@@ -122,16 +250,23 @@ namespace boost
                 void create_card(std::string const& key, Value value, std::string const& comment = "")
                 {
                     std::ostringstream stream;
+                    stream.precision(std::numeric_limits<Value>::max_digits10);
                     stream << value;
 
+                    //fixed format: numbers are right justified to column 30
                     std::string val = stream.str();
-                    val.insert(0, ' ', 20 - val.length());
+                    if (val.length() < 20)
+                    {
+                        val.insert(0, 20 - val.length(), ' ');
+                    }
                     create_card(key, val, comment);
                 }
 
                 //!create card for complex value
+                //!restricted to numbers so that a numeric value followed by a comment does not resolve to it
                 template <typename Real, typename Imaginary>
-                void create_card(std::string const& key, Real real, Imaginary imaginary, std::string const& comment = "")
+                typename std::enable_if<std::is_arithmetic<Imaginary>::value>::type
+                create_card(std::string const& key, Real real, Imaginary imaginary, std::string const& comment = "")
                 {
                     std::ostringstream stream;
                     stream << real << ", " << imaginary;
@@ -154,44 +289,55 @@ namespace boost
                         throw invalid_value_length_exception();
                     }
 
-                    this->card_ = std::string(key).append(8 - key.length(), ' ') + "  " + std::string(value).append(70 - key.length(), ' ');
+                    this->assign(std::string(key).append(8 - key.length(), ' ') + "  " + std::string(value).append(70 - value.length(), ' '));
                 }
 
                 //!if whole value is set to true then string is returned with trailing spaces
                 std::string key(bool whole = false) const
                 {
-                    if (whole)
-                    {
-                        return this->card_.substr(0, 8);
-                    }
-                    return boost::algorithm::trim_copy(this->card_.substr(0, 8));
+                    boost::string_view key = whole ? this->card_.substr(0, 8) : trim(this->card_.substr(0, 8));
+                    return std::string(key.data(), key.size());
                 }
 
-                //!return types can be int, float, double, bool, string (date and complex numbers are returned as string surrounded in single quotes or in brackets)
+                //!return types can be int, float, double, bool, std::complex, string (strings and complex numbers are returned surrounded in single quotes or in brackets)
+                //!the value is parsed on the first call and the parsed value is used by the following calls
+                //!throws invalid_value_type_exception if the value is not a number of the range of an arithmetic ReturnType
                 template <typename ReturnType>
                 ReturnType value() const
                 {
-                    std::string val = boost::algorithm::trim_copy(this->card_.substr(10, this->card_.find('/')-10));
-                    return boost::lexical_cast<ReturnType>(val);
+                    return convert(parsed_value(), type_tag<ReturnType>());
                 }
 
-                ///@cond INTERNAL
-                template <>
-                bool value<bool>() const
+                //!returns the value of the card parsed once, the first thread parsing it stores it for the following calls
+                card_value parsed_value() const
                 {
-                    std::string val = boost::algorithm::trim_copy(this->card_.substr(10, this->card_.find('/') - 10));
-                    if (val == "T") 
+                    unsigned char current = this->state.load(std::memory_order_acquire);
+                    if (current == parsed)
+                    {
+                        return this->cached;
+                    }
+
+                    card_value result = card_value::parse(this->card_);
+                    current = unparsed;
+                    if (this->state.compare_exchange_strong(current, parsing, std::memory_order_acquire))
                     {
-                        return true;
+                        this->cached = result;
+                        this->state.store(parsed, std::memory_order_release);
                     }
-                    return false;
+                    return result;
                 }
-                ///@endcond
 
                 //!returns value portion of card with comment as std::string 
                 std::string value_with_comment() const
                 {
-                    return this->card_.substr(10);
+                    boost::string_view val = this->card_.substr(10);
+                    return std::string(val.data(), val.size());
+                }
+
+                //!returns all the 80 chars of the card
+                boost::string_view raw() const
+                {
+                    return this->card_;
                 }
 
                 //!set value of current card
@@ -205,7 +351,7 @@ namespace boost
                     {
                         throw invalid_value_length_exception();
                     }
-                    this->card_.append(70 - value.length(), ' ');
+                    this->assign(this->key(true) + "= " + std::string(value).append(70 - value.length(), ' '));
                 }
             };
         } //namespace io
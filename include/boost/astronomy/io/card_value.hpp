@@ -0,0 +1,162 @@
+#ifndef BOOST_ASTRONOMY_IO_CARD_VALUE_HPP
+#define BOOST_ASTRONOMY_IO_CARD_VALUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/utility/string_view.hpp>
+
+#include <boost/astronomy/detail/fixed_width_number.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!value of a card parsed once from its 80 chars, tagged with the kind of value found
+            //!the text of the value (strings with their quotes, complex numbers with their brackets) is kept as
+            //!its position in the card so that the parsed value stays valid when the card is copied
+            struct card_value
+            {
+                enum value_type
+                {
+                    undefined, //!no value indicator, blank value or a value which is not recognized
+                    logical, //!T or F
+                    integer, //!integer which fits in std::int64_t
+                    real, //!real number, the exponent may be introduced by E or D
+                    complex, //!(real, imaginary) with integer or real parts
+                    string //!quoted string, '' inside the quotes stands for one quote
+                };
+
+                value_type type = undefined;
+                bool logical_value = false;
+                std::int64_t integer_value = 0;
+                double real_value = 0; //!value of real numbers and real part of complex numbers
+                double imaginary_value = 0;
+                std::size_t offset = 0; //!position of the text of the value in the card
+                std::size_t length = 0; //!number of chars of the text of the value
+
+                //!returns the text of the value inside card (the card this value was parsed from)
+                boost::string_view text(boost::string_view card) const
+                {
+                    return card.substr(this->offset, this->length);
+                }
+
+                //!parses the value of the 80 chars card without allocating
+                //!cards without "= " in columns 9-10 have no value and their text is columns 11-80 without surrounding spaces
+                //!otherwise the value ends at the closing quote of a string, the closing bracket of a complex number
+                //!or at the first space or '/' after other values, so '/' inside quotes does not start the comment
+                static card_value parse(boost::string_view card)
+                {
+                    card_value result;
+                    std::size_t const size = card.size();
+                    if (size < 10)
+                    {
+                        result.set_text(size, size);
+                        return result;
+                    }
+
+                    std::size_t begin = 10;
+                    while (begin < size && card[begin] == ' ')
+                    {
+                        begin++;
+                    }
+
+                    if (card[8] != '=' || card[9] != ' ')
+                    {
+                        std::size_t end = size;
+                        while (end > begin && card[end - 1] == ' ')
+                        {
+                            end--;
+                        }
+                        result.set_text(begin, end);
+                        return result;
+                    }
+                    if (begin == size || card[begin] == '/')
+                    {
+                        result.set_text(begin, begin);
+                        return result;
+                    }
+
+                    std::size_t end = begin + 1;
+                    if (card[begin] == '\'')
+                    {
+                        //closing quote is a quote not followed by another quote
+                        while (end < size && !(card[end] == '\'' && (end + 1 == size || card[end + 1] != '\'')))
+                        {
+                            end += card[end] == '\'' ? 2 : 1;
+                        }
+                        if (end < size)
+                        {
+                            result.type = string;
+                            end++;
+                        }
+                        result.set_text(begin, end);
+                        return result;
+                    }
+
+                    char const* chars = card.data();
+                    if (card[begin] == '(')
+                    {
+                        while (end < size && card[end] != ')')
+                        {
+                            end++;
+                        }
+                        result.set_text(begin, end < size ? end + 1 : size);
+                        if (end == size)
+                        {
+                            return result;
+                        }
+
+                        std::size_t comma = begin + 1;
+                        while (comma < end && card[comma] != ',')
+                        {
+                            comma++;
+                        }
+                        if (comma < end &&
+                            boost::astronomy::detail::parse_real(chars + begin + 1, chars + comma, 0, result.real_value) &&
+                            boost::astronomy::detail::parse_real(chars + comma + 1, chars + end, 0, result.imaginary_value) &&
+                            !boost::astronomy::detail::is_blank(chars + begin + 1, chars + comma) &&
+                            !boost::astronomy::detail::is_blank(chars + comma + 1, chars + end))
+                        {
+                            result.type = complex;
+                        }
+                        return result;
+                    }
+
+                    while (end < size && card[end] != ' ' && card[end] != '/')
+                    {
+                        end++;
+                    }
+                    result.set_text(begin, end);
+
+                    if (end - begin == 1 && (card[begin] == 'T' || card[begin] == 'F'))
+                    {
+                        result.type = logical;
+                        result.logical_value = card[begin] == 'T';
+                    }
+                    else if (boost::astronomy::detail::parse_integer(chars + begin, chars + end, result.integer_value))
+                    {
+                        result.type = integer;
+                        result.real_value = static_cast<double>(result.integer_value);
+                    }
+                    else if (boost::astronomy::detail::parse_real(chars + begin, chars + end, 0, result.real_value))
+                    {
+                        result.type = real;
+                    }
+                    return result;
+                }
+
+            private:
+                void set_text(std::size_t begin, std::size_t end)
+                {
+                    this->offset = begin;
+                    this->length = end - begin;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_CARD_VALUE_HPP
@@ -0,0 +1,257 @@
+#ifndef BOOST_ASTRONOMY_IO_COLUMN_FORMAT_HPP
+#define BOOST_ASTRONOMY_IO_COLUMN_FORMAT_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cctype>
+
+#include <boost/lexical_cast.hpp>
+
+#include <boost/astronomy/io/hdu.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!returns the text of a FITS string value: without the quotes and trailing spaces, '' replaced by '
+            inline std::string string_value(std::string const& value)
+            {
+                std::string::size_type first = value.find('\'');
+                std::string::size_type last = value.rfind('\'');
+                if (first == std::string::npos || last == first)
+                {
+                    return value;
+                }
+
+                std::string result;
+                for (std::string::size_type i = first + 1; i < last; i++)
+                {
+                    result += value[i];
+                    if (value[i] == '\'' && i + 1 < last && value[i + 1] == '\'')
+                    {
+                        i++;
+                    }
+                }
+                return result.erase(result.find_last_not_of(' ') + 1);
+            }
+
+            //!layout of one field of a binary table row as described by TTYPEn and TFORMn (rTa)
+            struct column_format
+            {
+                std::string name; //!value of TTYPEn (empty if not present)
+                char type = 'B'; //!data type code: L, X, B, I, J, K, A, E, D, C, M, P or Q
+                std::size_t repeat = 1; //!number of elements in the field (bits for X)
+                char array_type = 0; //!element type of variable length arrays (P and Q), 0 for other types
+                std::size_t offset = 0; //!position of the field in the row in bytes
+                std::size_t size = 0; //!size of the field in the row in bytes
+
+                //!returns the size in bytes of one element of type, 0 for unknown types
+                static std::size_t element_size(char type)
+                {
+                    switch (type)
+                    {
+                    case 'L':
+                    case 'B':
+                    case 'A':
+                        return 1;
+                    case 'I':
+                        return 2;
+                    case 'J':
+                    case 'E':
+                        return 4;
+                    case 'K':
+                    case 'D':
+                    case 'C':
+                    case 'P':
+                        return 8;
+                    case 'M':
+                    case 'Q':
+                        return 16;
+                    default:
+                        return 0;
+                    }
+                }
+
+                //!parses the value of TFORMn (e.g. 1J, 20A, 1PB(340)), throws fits_exception for invalid formats
+                static column_format parse(std::string const& tform)
+                {
+                    column_format format;
+                    std::size_t i = 0;
+                    while (i < tform.size() && tform[i] == ' ')
+                    {
+                        i++;
+                    }
+
+                    std::size_t digits = i;
+                    while (i < tform.size() && std::isdigit(static_cast<unsigned char>(tform[i])))
+                    {
+                        i++;
+                    }
+                    if (i != digits)
+                    {
+                        format.repeat = boost::lexical_cast<std::size_t>(tform.substr(digits, i - digits));
+                    }
+                    if (i == tform.size())
+                    {
+                        throw fits_exception();
+                    }
+
+                    format.type = tform[i++];
+                    if (format.type == 'P' || format.type == 'Q')
+                    {
+                        if (i == tform.size() || element_size(tform[i]) == 0)
+                        {
+                            throw fits_exception();
+                        }
+                        format.array_type = tform[i];
+                        format.size = format.repeat * element_size(format.type);
+                    }
+                    else if (format.type == 'X')
+                    {
+                        format.size = (format.repeat + 7) / 8;
+                    }
+                    else if (element_size(format.type) != 0)
+                    {
+                        format.size = format.repeat * element_size(format.type);
+                    }
+                    else
+                    {
+                        throw fits_exception();
+                    }
+                    return format;
+                }
+            };
+
+            //!returns the format of every field of the binary table whose header is table (TFIELDS, TTYPEn, TFORMn)
+            //!throws fits_exception if the fields do not add up to NAXIS1
+            inline std::vector<column_format> read_column_formats(hdu& table)
+            {
+                std::size_t fields = table.value_of<std::size_t>("TFIELDS");
+                std::vector<column_format> formats;
+                formats.reserve(fields);
+
+                std::size_t offset = 0;
+                for (std::size_t i = 1; i <= fields; i++)
+                {
+                    std::string const n = boost::lexical_cast<std::string>(i);
+                    formats.push_back(column_format::parse(string_value(table.value_of<std::string>("TFORM" + n))));
+                    if (table.has_key("TTYPE" + n))
+                    {
+                        formats.back().name = string_value(table.value_of<std::string>("TTYPE" + n));
+                    }
+                    formats.back().offset = offset;
+                    offset += formats.back().size;
+                }
+
+                if (offset != table.naxis(1))
+                {
+                    throw fits_exception();
+                }
+                return formats;
+            }
+
+            //!layout of one field of an ASCII table row as described by TTYPEn, TBCOLn and TFORMn (Aw, Iw, Fw.d, Ew.d, Dw.d)
+            struct ascii_column_format
+            {
+                std::string name; //!value of TTYPEn (empty if not present)
+                char type = 'A'; //!data type code: A, I, F, E or D
+                std::size_t width = 0; //!number of characters of the field
+                std::size_t decimals = 0; //!digits of the fraction if the field has no decimal point
+                std::size_t offset = 0; //!position of the field in the row in bytes (TBCOLn - 1)
+                std::string null; //!value of TNULLn without the surrounding spaces (empty if not present)
+
+                //!parses the value of TFORMn (e.g. A10, I8, F12.4, D25.17), throws fits_exception for invalid formats
+                static ascii_column_format parse(std::string const& tform)
+                {
+                    ascii_column_format format;
+                    std::string::size_type first = tform.find_first_not_of(' ');
+                    if (first == std::string::npos || std::string("AIFED").find(tform[first]) == std::string::npos)
+                    {
+                        throw fits_exception();
+                    }
+                    format.type = tform[first];
+
+                    std::string::size_type point = tform.find('.', first);
+                    std::string::size_type last = tform.find_last_not_of(' ');
+                    try
+                    {
+                        format.width = boost::lexical_cast<std::size_t>(tform.substr(first + 1,
+                            (point == std::string::npos ? last + 1 : point) - first - 1));
+                        if (point != std::string::npos)
+                        {
+                            format.decimals = boost::lexical_cast<std::size_t>(tform.substr(point + 1, last - point));
+                        }
+                    }
+                    catch (boost::bad_lexical_cast const&)
+                    {
+                        throw fits_exception();
+                    }
+                    if (format.width == 0)
+                    {
+                        throw fits_exception();
+                    }
+                    return format;
+                }
+
+                //!returns the binary format in which the converted values are stored: Aw as wA, Iw as 1K and
+                //!Fw.d, Ew.d, Dw.d as 1D
+                column_format stored_format() const
+                {
+                    column_format format;
+                    format.name = this->name;
+                    format.offset = this->offset;
+                    if (this->type == 'A')
+                    {
+                        format.type = 'A';
+                        format.repeat = this->width;
+                    }
+                    else
+                    {
+                        format.type = this->type == 'I' ? 'K' : 'D';
+                    }
+                    format.size = format.repeat * column_format::element_size(format.type);
+                    return format;
+                }
+            };
+
+            //!returns the format of every field of the ASCII table whose header is table (TFIELDS, TTYPEn, TBCOLn, TFORMn)
+            //!throws fits_exception if a field does not fit in NAXIS1
+            inline std::vector<ascii_column_format> read_ascii_column_formats(hdu& table)
+            {
+                std::size_t fields = table.value_of<std::size_t>("TFIELDS");
+                std::vector<ascii_column_format> formats;
+                formats.reserve(fields);
+
+                for (std::size_t i = 1; i <= fields; i++)
+                {
+                    std::string const n = boost::lexical_cast<std::string>(i);
+                    formats.push_back(ascii_column_format::parse(string_value(table.value_of<std::string>("TFORM" + n))));
+                    ascii_column_format& format = formats.back();
+                    if (table.has_key("TTYPE" + n))
+                    {
+                        format.name = string_value(table.value_of<std::string>("TTYPE" + n));
+                    }
+                    if (table.has_key("TNULL" + n))
+                    {
+                        format.null = string_value(table.value_of<std::string>("TNULL" + n));
+                        format.null.erase(0, format.null.find_first_not_of(' '));
+                    }
+
+                    std::size_t column = table.value_of<std::size_t>("TBCOL" + n);
+                    if (column == 0 || column - 1 + format.width > table.naxis(1))
+                    {
+                        throw fits_exception();
+                    }
+                    format.offset = column - 1;
+                }
+                return formats;
+            }
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_COLUMN_FORMAT_HPP
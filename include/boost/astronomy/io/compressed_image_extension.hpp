@@ -0,0 +1,679 @@
+#ifndef BOOST_ASTRONOMY_IO_COMPRESSED_IMAGE_EXTENSION_HPP
+#define BOOST_ASTRONOMY_IO_COMPRESSED_IMAGE_EXTENSION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <boost/astronomy/io/hdu.hpp>
+#include <boost/astronomy/io/extension_hdu.hpp>
+#include <boost/astronomy/io/column_format.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/detail/byteswap.hpp>
+#include <boost/astronomy/detail/inflate.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+#include <boost/astronomy/detail/rice.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!image stored with the tiled image compression convention: a BINTABLE with ZIMAGE = T whose rows are
+            //!the compressed tiles of an image of type DataType (ZBITPIX)
+            //!supported compression types are RICE_1, GZIP_1, GZIP_2 (GZIP needs zlib) and NOCOMPRESS, floating point
+            //!images may be quantized (ZSCALE, ZZERO) with NO_DITHER, SUBTRACTIVE_DITHER_1 or SUBTRACTIVE_DITHER_2
+            //!tiles are decompressed in parallel and regions decompress only the tiles covering them
+            template <bitpix DataType>
+            struct compressed_image_extension : public boost::astronomy::io::extension_hdu
+            {
+            public:
+                typedef typename image<DataType>::pixel_type pixel_type;
+
+            protected:
+                enum compression { rice, gzip, gzip_shuffled, no_compression, unsupported };
+                enum quantization { no_dither, subtractive_dither_1, subtractive_dither_2 };
+
+                //!position of the compressed data of a tile in the data unit and its quantization parameters
+                struct tile
+                {
+                    std::uint64_t offset = 0; //!position of COMPRESSED_DATA from the start of data unit
+                    std::uint64_t size = 0; //!size of COMPRESSED_DATA in bytes
+                    std::uint64_t gzip_offset = 0; //!position of GZIP_COMPRESSED_DATA (tiles which could not be quantized)
+                    std::uint64_t gzip_size = 0; //!size of GZIP_COMPRESSED_DATA in bytes
+                    double scale = 1; //!ZSCALE of the tile
+                    double zero = 0; //!ZZERO of the tile
+                    std::int64_t blank = 0; //!integer value marking undefined pixels
+                    bool has_blank = false; //!true if blank is defined
+                };
+
+                std::size_t width = 0; //!ZNAXIS1
+                std::size_t height = 0; //!ZNAXIS2 * ZNAXIS3 * ... * ZNAXISn, higher axes are folded into the height
+                std::size_t plane_height = 1; //!ZNAXIS2
+                std::size_t tile_width = 0; //!ZTILE1
+                std::size_t tile_height = 1; //!ZTILE2
+                std::size_t tiles_across = 0; //!number of tiles in a row of tiles
+                std::size_t tiles_down = 0; //!number of rows of tiles in a plane
+
+                compression method = unsupported; //!ZCMPTYPE
+                std::size_t block_size = 32; //!BLOCKSIZE parameter of RICE_1
+                std::size_t bytes_per_value = 4; //!BYTEPIX parameter of RICE_1
+                bool quantized = false; //!true if floating point pixels are stored as scaled integers
+                quantization dither = no_dither; //!ZQUANTIZ
+                std::int64_t dither_seed = 1; //!ZDITHER0
+
+                std::shared_ptr<char const> data_unit; //!whole data unit if it is in memory (read or mapped)
+                std::string file_path; //!file from which the tiles are read if the data unit is not in memory
+                std::uint64_t data_offset = 0; //!position of data unit in file_path
+
+                mutable std::vector<tile> tiles; //!tiles in the order of the table rows
+                mutable bool tiles_read = false; //!false until the table rows of a deferred HDU are read
+                mutable image<DataType> data; //!decompressed image after the first call to get_data()
+                mutable bool decompressed = false; //!true if data holds the whole image
+
+            public:
+                //!reads the data unit of the HDU whose header other has just been read from file
+                compressed_image_extension(std::fstream &file, hdu const& other) : extension_hdu(other)
+                {
+                    set_tiling();
+                    std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>(this->data_size());
+                    file.read(buffer->data(), static_cast<std::streamsize>(buffer->size()));
+                    if (!file)
+                    {
+                        throw fits_exception();
+                    }
+                    set_unit_end(file);
+                    this->data_unit = std::shared_ptr<char const>(buffer, buffer->data());
+                }
+
+                //!This constructor should be used when the file is memory mapped, offset is the position of data unit in the file
+                //!only the compressed bytes of the tiles which are decompressed are accessed
+                compressed_image_extension(std::shared_ptr<mapped_file const> const& file, std::size_t offset, hdu const& other) :
+                    extension_hdu(other)
+                {
+                    set_tiling();
+                    this->data_unit = std::shared_ptr<char const>(file, file->data() + offset);
+                }
+
+                //!This constructor should be used when data unit is read on demand, offset is the position of data unit in path
+                //!the table rows are read on first access, afterwards only the compressed bytes of the tiles needed are read
+                compressed_image_extension(std::string const& path, std::size_t offset, hdu const& other) :
+                    extension_hdu(other), file_path(path), data_offset(offset)
+                {
+                    set_tiling();
+                }
+
+                //!returns the width of image (ZNAXIS1)
+                std::size_t get_width() const
+                {
+                    return this->width;
+                }
+
+                //!returns the height of image (ZNAXIS2 * ... * ZNAXISn)
+                std::size_t get_height() const
+                {
+                    return this->height;
+                }
+
+                //!returns the width of tiles (ZTILE1), tiles at the right edge may be narrower
+                std::size_t get_tile_width() const
+                {
+                    return this->tile_width;
+                }
+
+                //!returns the height of tiles (ZTILE2), tiles at the bottom edge may be lower
+                std::size_t get_tile_height() const
+                {
+                    return this->tile_height;
+                }
+
+                //!returns the number of tiles
+                std::size_t get_tile_count() const
+                {
+                    return this->tiles_across * this->tiles_down * (this->height / (std::max)(this->plane_height, std::size_t(1)));
+                }
+
+                //!returns the whole image, all the tiles are decompressed by up to threads threads (0 uses all hardware threads)
+                //!on the first call, afterwards the decompressed image is returned
+                image<DataType> get_data(std::size_t threads = 0) const
+                {
+                    if (!this->decompressed)
+                    {
+                        decompress(this->data, 0, 0, this->width, this->height, threads);
+                        this->decompressed = true;
+                    }
+                    return this->data;
+                }
+
+                //!returns the region of image which starts at (x, y) (x is the row and y the column as in image_buffer::operator())
+                //!only the tiles covering the region are read and decompressed
+                image<DataType> get_region(std::size_t x, std::size_t y, std::size_t region_width, std::size_t region_height,
+                    std::size_t threads = 0) const
+                {
+                    if (x > this->height || region_height > this->height - x || y > this->width || region_width > this->width - y)
+                    {
+                        throw boost::astronomy::region_out_of_range_exception();
+                    }
+
+                    image<DataType> result;
+                    if (this->decompressed)
+                    {
+                        result.assign_region(this->data, x, y, region_width, region_height);
+                    }
+                    else
+                    {
+                        decompress(result, x, y, region_width, region_height, threads);
+                    }
+                    return result;
+                }
+
+            protected:
+                template <typename T>
+                static T load_big(char const* bytes)
+                {
+                    T value;
+                    std::memcpy(&value, bytes, sizeof(T));
+                    boost::astronomy::detail::big_to_native_inplace(&value, 1);
+                    return value;
+                }
+
+                //!returns the string value of key without quotes, or default_value if key is not present
+                std::string keyword_string(std::string const& key, std::string const& default_value)
+                {
+                    return this->has_key(key) ? string_value(this->value_of<std::string>(key)) : default_value;
+                }
+
+                //!reads the image and tile dimensions, compression and quantization parameters from the header
+                void set_tiling()
+                {
+                    std::size_t axes = this->value_of<std::size_t>("ZNAXIS");
+                    if (axes == 0)
+                    {
+                        return;
+                    }
+
+                    this->width = this->value_of<std::size_t>("ZNAXIS1");
+                    this->plane_height = axes > 1 ? this->value_of<std::size_t>("ZNAXIS2") : 1;
+                    this->height = this->plane_height;
+                    this->tile_width = this->has_key("ZTILE1") ? this->value_of<std::size_t>("ZTILE1") : this->width;
+                    this->tile_height = axes > 1 && this->has_key("ZTILE2") ? this->value_of<std::size_t>("ZTILE2") : 1;
+                    for (std::size_t i = 3; i <= axes; i++)
+                    {
+                        std::string const n = boost::lexical_cast<std::string>(i);
+                        this->height *= this->value_of<std::size_t>("ZNAXIS" + n);
+                        if (this->has_key("ZTILE" + n) && this->value_of<std::size_t>("ZTILE" + n) != 1)
+                        {
+                            throw unsupported_compression_exception();
+                        }
+                    }
+                    if (this->tile_width == 0 || this->tile_height == 0)
+                    {
+                        throw fits_exception();
+                    }
+                    this->tiles_across = (this->width + this->tile_width - 1) / this->tile_width;
+                    this->tiles_down = (this->plane_height + this->tile_height - 1) / this->tile_height;
+
+                    std::string const type = keyword_string("ZCMPTYPE", "");
+                    if (type == "RICE_1" || type == "RICE_ONE")
+                    {
+                        this->method = rice;
+                    }
+                    else if (type == "GZIP_1")
+                    {
+                        this->method = gzip;
+                    }
+                    else if (type == "GZIP_2")
+                    {
+                        this->method = gzip_shuffled;
+                    }
+                    else if (type == "NOCOMPRESS")
+                    {
+                        this->method = no_compression;
+                    }
+
+                    //compression parameters are given as ZNAMEi = name, ZVALi = value
+                    for (std::size_t i = 1; this->has_key("ZNAME" + boost::lexical_cast<std::string>(i)); i++)
+                    {
+                        std::string const n = boost::lexical_cast<std::string>(i);
+                        std::string const name = string_value(this->value_of<std::string>("ZNAME" + n));
+                        if (name == "BLOCKSIZE")
+                        {
+                            this->block_size = this->value_of<std::size_t>("ZVAL" + n);
+                        }
+                        else if (name == "BYTEPIX")
+                        {
+                            this->bytes_per_value = this->value_of<std::size_t>("ZVAL" + n);
+                        }
+                    }
+
+                    std::string const quantize = keyword_string("ZQUANTIZ", "NO_DITHER");
+                    if (quantize == "SUBTRACTIVE_DITHER_1")
+                    {
+                        this->dither = subtractive_dither_1;
+                    }
+                    else if (quantize == "SUBTRACTIVE_DITHER_2")
+                    {
+                        this->dither = subtractive_dither_2;
+                    }
+                    if (this->has_key("ZDITHER0"))
+                    {
+                        this->dither_seed = this->value_of<std::int64_t>("ZDITHER0");
+                    }
+                }
+
+                //!reads the descriptors and quantization parameters of every tile from the table rows
+                void read_tiles(char const* table)
+                {
+                    std::vector<column_format> columns = read_column_formats(*this);
+                    column_format const* compressed = nullptr;
+                    column_format const* gzip_compressed = nullptr;
+                    column_format const* scale = nullptr;
+                    column_format const* zero = nullptr;
+                    column_format const* blank = nullptr;
+                    for (column_format const& column : columns)
+                    {
+                        if (column.name == "COMPRESSED_DATA")
+                        {
+                            compressed = &column;
+                        }
+                        else if (column.name == "GZIP_COMPRESSED_DATA")
+                        {
+                            gzip_compressed = &column;
+                        }
+                        else if (column.name == "ZSCALE")
+                        {
+                            scale = &column;
+                        }
+                        else if (column.name == "ZZERO")
+                        {
+                            zero = &column;
+                        }
+                        else if (column.name == "ZBLANK")
+                        {
+                            blank = &column;
+                        }
+                    }
+                    if (compressed == nullptr || compressed->array_type == 0)
+                    {
+                        throw fits_exception();
+                    }
+                    this->quantized = std::is_floating_point<pixel_type>::value && scale != nullptr;
+
+                    std::size_t const row_size = this->_naxis[1];
+                    std::size_t const rows = this->_naxis[2];
+                    if (rows != get_tile_count())
+                    {
+                        throw fits_exception();
+                    }
+                    std::uint64_t const heap = this->has_key("THEAP") ? this->value_of<std::uint64_t>("THEAP") :
+                        static_cast<std::uint64_t>(row_size) * rows;
+
+                    bool const has_blank_keyword = this->has_key("ZBLANK");
+                    std::int64_t const blank_keyword = has_blank_keyword ? this->value_of<std::int64_t>("ZBLANK") : 0;
+
+                    this->tiles.assign(rows, tile());
+                    for (std::size_t row = 0; row < rows; row++)
+                    {
+                        char const* fields = table + row * row_size;
+                        tile& current = this->tiles[row];
+
+                        read_descriptor(*compressed, fields, heap, current.offset, current.size);
+                        if (gzip_compressed != nullptr && gzip_compressed->array_type != 0)
+                        {
+                            read_descriptor(*gzip_compressed, fields, heap, current.gzip_offset, current.gzip_size);
+                        }
+                        if (scale != nullptr)
+                        {
+                            current.scale = read_real(*scale, fields);
+                        }
+                        if (zero != nullptr)
+                        {
+                            current.zero = read_real(*zero, fields);
+                        }
+                        if (blank != nullptr)
+                        {
+                            current.blank = blank->type == 'K' ? load_big<std::int64_t>(fields + blank->offset) :
+                                load_big<std::int32_t>(fields + blank->offset);
+                            current.has_blank = true;
+                        }
+                        else
+                        {
+                            current.blank = blank_keyword;
+                            current.has_blank = has_blank_keyword;
+                        }
+                    }
+                    this->tiles_read = true;
+                }
+
+                static void read_descriptor(column_format const& column, char const* fields, std::uint64_t heap,
+                    std::uint64_t& offset, std::uint64_t& size)
+                {
+                    std::uint64_t count;
+                    if (column.type == 'P')
+                    {
+                        count = static_cast<std::uint32_t>(load_big<std::int32_t>(fields + column.offset));
+                        offset = static_cast<std::uint32_t>(load_big<std::int32_t>(fields + column.offset + 4));
+                    }
+                    else
+                    {
+                        count = static_cast<std::uint64_t>(load_big<std::int64_t>(fields + column.offset));
+                        offset = static_cast<std::uint64_t>(load_big<std::int64_t>(fields + column.offset + 8));
+                    }
+                    offset += heap;
+                    size = count * column_format::element_size(column.array_type);
+                }
+
+                static double read_real(column_format const& column, char const* fields)
+                {
+                    return column.type == 'E' ? load_big<float>(fields + column.offset) : load_big<double>(fields + column.offset);
+                }
+
+                //!makes sure tiles are known, the table rows of a deferred HDU are read from file
+                void ensure_tiles(boost::astronomy::detail::positional_file const* file) const
+                {
+                    if (this->tiles_read)
+                    {
+                        return;
+                    }
+
+                    compressed_image_extension& self = const_cast<compressed_image_extension&>(*this);
+                    if (this->data_unit)
+                    {
+                        self.read_tiles(this->data_unit.get());
+                        return;
+                    }
+
+                    std::vector<char> table(this->_naxis[1] * this->_naxis[2]);
+                    file->read(table.data(), table.size(), this->data_offset);
+                    self.read_tiles(table.data());
+                }
+
+                //!returns size bytes at offset of the data unit, from memory or read from file into buffer
+                unsigned char const* read_bytes(boost::astronomy::detail::positional_file const* file, std::uint64_t offset,
+                    std::uint64_t size, std::vector<unsigned char>& buffer) const
+                {
+                    if (offset + size > this->data_size())
+                    {
+                        throw invalid_compressed_data_exception();
+                    }
+                    if (this->data_unit)
+                    {
+                        return reinterpret_cast<unsigned char const*>(this->data_unit.get()) + offset;
+                    }
+
+                    buffer.resize(static_cast<std::size_t>(size));
+                    file->read(reinterpret_cast<char*>(buffer.data()), buffer.size(), this->data_offset + offset);
+                    return buffer.data();
+                }
+
+                //!decompresses the tiles covering the region at (x, y) into result
+                void decompress(image<DataType>& result, std::size_t x, std::size_t y,
+                    std::size_t region_width, std::size_t region_height, std::size_t threads) const
+                {
+                    std::unique_ptr<boost::astronomy::detail::positional_file> file;
+                    if (!this->data_unit)
+                    {
+                        file.reset(new boost::astronomy::detail::positional_file(this->file_path));
+                    }
+                    ensure_tiles(file.get());
+                    result.set_size(region_width, region_height);
+
+                    std::vector<std::size_t> covering;
+                    for (std::size_t t = 0; t < this->tiles.size() && region_width > 0 && region_height > 0; t++)
+                    {
+                        std::size_t row, column, rows, columns;
+                        tile_bounds(t, row, column, rows, columns);
+                        if (row < x + region_height && x < row + rows && column < y + region_width && y < column + columns)
+                        {
+                            covering.push_back(t);
+                        }
+                    }
+
+                    pixel_type* destination = result.raw_data();
+                    boost::astronomy::detail::parallel_for(covering.size(), [&](std::size_t i)
+                    {
+                        std::size_t const t = covering[i];
+                        std::size_t row, column, rows, columns;
+                        tile_bounds(t, row, column, rows, columns);
+
+                        std::vector<pixel_type> pixels(rows * columns);
+                        std::vector<unsigned char> compressed, scratch;
+                        decode_tile(t, file.get(), pixels.data(), pixels.size(), compressed, scratch,
+                            std::is_floating_point<pixel_type>());
+
+                        //copies the part of the tile inside the region
+                        std::size_t const first_row = (std::max)(row, x), last_row = (std::min)(row + rows, x + region_height);
+                        std::size_t const first_column = (std::max)(column, y);
+                        std::size_t const last_column = (std::min)(column + columns, y + region_width);
+                        for (std::size_t r = first_row; r < last_row; r++)
+                        {
+                            std::copy(pixels.begin() + static_cast<std::ptrdiff_t>((r - row) * columns + (first_column - column)),
+                                pixels.begin() + static_cast<std::ptrdiff_t>((r - row) * columns + (last_column - column)),
+                                destination + (r - x) * region_width + (first_column - y));
+                        }
+                    }, threads);
+                }
+
+                //!returns the first row and column of tile t in the image and its size (tiles are stored row of tiles
+                //!by row of tiles, plane by plane)
+                void tile_bounds(std::size_t t, std::size_t& row, std::size_t& column, std::size_t& rows, std::size_t& columns) const
+                {
+                    std::size_t const across = t % this->tiles_across;
+                    std::size_t const down = (t / this->tiles_across) % this->tiles_down;
+                    std::size_t const plane = t / (this->tiles_across * this->tiles_down);
+
+                    column = across * this->tile_width;
+                    columns = (std::min)(this->tile_width, this->width - column);
+                    row = plane * this->plane_height + down * this->tile_height;
+                    rows = (std::min)(this->tile_height, this->plane_height - down * this->tile_height);
+                }
+
+                //!integer image: the pixels are the compressed integers
+                void decode_tile(std::size_t t, boost::astronomy::detail::positional_file const* file, pixel_type* pixels,
+                    std::size_t count, std::vector<unsigned char>& compressed, std::vector<unsigned char>& scratch,
+                    std::false_type) const
+                {
+                    tile const& current = this->tiles[t];
+                    unsigned char const* bytes = read_bytes(file, current.offset, current.size, compressed);
+                    decode_integers(bytes, static_cast<std::size_t>(current.size), pixels, count, scratch);
+                }
+
+                //!floating point image: the pixels are either quantized integers or the floating point values
+                void decode_tile(std::size_t t, boost::astronomy::detail::positional_file const* file, pixel_type* pixels,
+                    std::size_t count, std::vector<unsigned char>& compressed, std::vector<unsigned char>& scratch,
+                    std::true_type) const
+                {
+                    tile const& current = this->tiles[t];
+                    if (current.size == 0 && current.gzip_size != 0)
+                    {
+                        //tile could not be quantized so its values are stored losslessly with GZIP_1
+                        unsigned char const* bytes = read_bytes(file, current.gzip_offset, current.gzip_size, compressed);
+                        decode_raw(gzip, bytes, static_cast<std::size_t>(current.gzip_size), pixels, count, scratch);
+                        return;
+                    }
+
+                    unsigned char const* bytes = read_bytes(file, current.offset, current.size, compressed);
+                    if (!this->quantized)
+                    {
+                        if (this->method == rice)
+                        {
+                            throw unsupported_compression_exception();
+                        }
+                        decode_raw(this->method, bytes, static_cast<std::size_t>(current.size), pixels, count, scratch);
+                        return;
+                    }
+
+                    std::vector<std::int32_t> values(count);
+                    decode_integers(bytes, static_cast<std::size_t>(current.size), values.data(), count, scratch);
+                    unquantize(t, values.data(), pixels, count);
+                }
+
+                //!decodes count integers, RICE_1 values are BYTEPIX wide, GZIP and NOCOMPRESS values are sizeof(Integer) wide
+                template <typename Integer>
+                void decode_integers(unsigned char const* bytes, std::size_t size, Integer* values, std::size_t count,
+                    std::vector<unsigned char>& scratch) const
+                {
+                    if (this->method != rice)
+                    {
+                        decode_raw(this->method, bytes, size, values, count, scratch);
+                        return;
+                    }
+
+                    switch (this->bytes_per_value)
+                    {
+                    case 1:
+                        rice_tile<std::uint8_t>(bytes, size, values, count, scratch);
+                        break;
+                    case 2:
+                        rice_tile<std::uint16_t>(bytes, size, values, count, scratch);
+                        break;
+                    case 4:
+                        rice_tile<std::uint32_t>(bytes, size, values, count, scratch);
+                        break;
+                    default:
+                        throw unsupported_compression_exception();
+                    }
+                }
+
+                template <typename Unsigned, typename Integer>
+                void rice_tile(unsigned char const* bytes, std::size_t size, Integer* values, std::size_t count,
+                    std::vector<unsigned char>& scratch) const
+                {
+                    if (sizeof(Unsigned) == sizeof(Integer))
+                    {
+                        boost::astronomy::detail::rice_decode(bytes, size, reinterpret_cast<Unsigned*>(values), count, this->block_size);
+                        return;
+                    }
+
+                    scratch.resize(count * sizeof(Unsigned));
+                    Unsigned* decoded = reinterpret_cast<Unsigned*>(scratch.data());
+                    boost::astronomy::detail::rice_decode(bytes, size, decoded, count, this->block_size);
+
+                    typedef typename std::make_signed<Unsigned>::type Signed;
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        values[i] = static_cast<Integer>(static_cast<Signed>(decoded[i]));
+                    }
+                }
+
+                //!decodes count big-endian values of type T which are stored (NOCOMPRESS), gzipped (GZIP_1) or gzipped
+                //!after the bytes were shuffled: all first bytes, then all second bytes and so on (GZIP_2)
+                template <typename T>
+                static void decode_raw(compression type, unsigned char const* bytes, std::size_t size, T* values, std::size_t count,
+                    std::vector<unsigned char>& scratch)
+                {
+                    std::size_t const value_bytes = count * sizeof(T);
+                    unsigned char* output = reinterpret_cast<unsigned char*>(values);
+
+                    switch (type)
+                    {
+                    case no_compression:
+                        if (size != value_bytes)
+                        {
+                            throw invalid_compressed_data_exception();
+                        }
+                        std::memcpy(output, bytes, value_bytes);
+                        break;
+                    case gzip:
+                        boost::astronomy::detail::gzip_decompress(bytes, size, output, value_bytes);
+                        break;
+                    case gzip_shuffled:
+                        scratch.resize(value_bytes);
+                        boost::astronomy::detail::gzip_decompress(bytes, size, scratch.data(), value_bytes);
+                        for (std::size_t b = 0; b < sizeof(T); b++)
+                        {
+                            for (std::size_t i = 0; i < count; i++)
+                            {
+                                output[i * sizeof(T) + b] = scratch[b * count + i];
+                            }
+                        }
+                        break;
+                    default:
+                        throw unsupported_compression_exception();
+                    }
+                    boost::astronomy::detail::big_to_native_inplace(values, count);
+                }
+
+                //!returns the random sequence used for dithering (the same 10000 values as in the FITS convention)
+                static std::vector<float> const& dither_values()
+                {
+                    static std::vector<float> const values = []()
+                    {
+                        std::vector<float> random(10000);
+                        double const a = 16807.0, m = 2147483647.0;
+                        double seed = 1;
+                        for (float& value : random)
+                        {
+                            double const product = a * seed;
+                            seed = product - m * static_cast<double>(static_cast<std::int64_t>(product / m));
+                            value = static_cast<float>(seed / m);
+                        }
+                        return random;
+                    }();
+                    return values;
+                }
+
+                //!converts the quantized integers of tile t to floating point values
+                void unquantize(std::size_t t, std::int32_t const* values, pixel_type* pixels, std::size_t count) const
+                {
+                    tile const& current = this->tiles[t];
+                    std::int32_t const zero_value = -2147483646; //!marks 0.0 in SUBTRACTIVE_DITHER_2
+                    pixel_type const nan = std::numeric_limits<pixel_type>::quiet_NaN();
+
+                    if (this->dither == no_dither)
+                    {
+                        for (std::size_t i = 0; i < count; i++)
+                        {
+                            pixels[i] = current.has_blank && values[i] == current.blank ? nan :
+                                static_cast<pixel_type>(values[i] * current.scale + current.zero);
+                        }
+                        return;
+                    }
+
+                    std::vector<float> const& random = dither_values();
+                    std::int64_t const first = (static_cast<std::int64_t>(t) + this->dither_seed - 1) % 10000;
+                    std::size_t seed = static_cast<std::size_t>(first < 0 ? first + 10000 : first);
+                    std::size_t next = static_cast<std::size_t>(random[seed] * 500);
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        if (current.has_blank && values[i] == current.blank)
+                        {
+                            pixels[i] = nan;
+                        }
+                        else if (this->dither == subtractive_dither_2 && values[i] == zero_value)
+                        {
+                            pixels[i] = 0;
+                        }
+                        else
+                        {
+                            pixels[i] = static_cast<pixel_type>((static_cast<double>(values[i]) - random[next] + 0.5) * current.scale +
+                                current.zero);
+                        }
+
+                        if (++next == 10000)
+                        {
+                            seed = (seed + 1) % 10000;
+                            next = static_cast<std::size_t>(random[seed] * 500);
+                        }
+                    }
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_COMPRESSED_IMAGE_EXTENSION_HPP
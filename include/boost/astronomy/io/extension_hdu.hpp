@@ -35,6 +35,12 @@ namespace boost
                     pcount = this->value_of<int>("PCOUNT");
                 }
 
+                extension_hdu(hdu const& other) : hdu(other)
+                {
+                    gcount = this->value_of<int>("GCOUNT");
+                    pcount = this->value_of<int>("PCOUNT");
+                }
+
                 extension_hdu(std::fstream &file, std::streampos pos) : hdu(file, pos)
                 {
                     gcount = this->value_of<int>("GCOUNT");
@@ -4,12 +4,23 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <map>
 #include <memory>
+#include <functional>
+#include <cstddef>
 
 #include <boost/astronomy/io/primary_hdu.hpp>
 #include <boost/astronomy/io/extension_hdu.hpp>
 #include <boost/astronomy/io/image_extension.hpp>
+#include <boost/astronomy/io/compressed_image_extension.hpp>
+#include <boost/astronomy/io/binary_table_extension.hpp>
+#include <boost/astronomy/io/ascii_table_extension.hpp>
+#include <boost/astronomy/io/image_hdu.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
 #include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+#include <boost/astronomy/detail/read_ahead_buffer.hpp>
 
 namespace boost
 {
@@ -19,9 +30,23 @@ namespace boost
         {
             struct fits 
             {
+            public:
+                //!ways in which the data units of a file can be accessed
+                enum read_mode
+                {
+                    stream, //!data units are read through std::fstream into memory
+                    mapped, //!file is memory mapped, data units are not copied and are converted only when accessed
+                    deferred, //!only headers are read, data units are skipped and read on the first call to get_data()
+                    parallel, //!headers are read first and then the image data units are read by a pool of threads
+                    prefetch //!as stream but the file is read ahead into a bounded pool of buffers by a background thread
+                };
+
             protected:
+                std::unique_ptr<boost::astronomy::detail::read_ahead_buffer> read_ahead; //!buffer of fits_file in prefetch mode
                 std::fstream fits_file; //!FITS to be processed
+                std::shared_ptr<mapped_file const> mapping; //!mapping of the file in mapped mode
                 std::vector<std::shared_ptr<hdu>> hdu_; //!Stores all th HDU in file
+                std::vector<image_hdu> images; //!typed reference to every HDU of hdu_ holding an image (empty for other HDUs)
 
             public:
                 fits() {}
@@ -33,76 +58,367 @@ namespace boost
                     //read_extensions();
                 }
 
-                void read_primary_hdu()
+                //!in mapped mode the file is mapped once and all the HDUs are parsed directly from the mapping
+                //!in deferred mode all the headers are read and the position of every data unit is recorded
+                //!in parallel mode the data units are read and converted by threads threads (0 uses all hardware threads)
+                //!in prefetch mode the primary HDU is read as in stream mode and read_extensions() reads the other HDUs
+                //!while the file is read ahead in the background
+                fits(std::string const& file_path, read_mode mode, std::size_t threads = 0)
                 {
-                    hdu_[0] = std::make_shared<hdu>(fits_file);
-                    
-                    switch (hdu_[0]->value_of<int>(std::string("BITPIX")))
+                    if (mode == mapped)
+                    {
+                        read_mapped(file_path);
+                    }
+                    else if (mode == deferred)
+                    {
+                        read_deferred(file_path);
+                    }
+                    else if (mode == parallel)
+                    {
+                        read_deferred(file_path);
+                        load_parallel(file_path, threads);
+                    }
+                    else if (mode == prefetch)
+                    {
+                        read_ahead.reset(new boost::astronomy::detail::read_ahead_buffer(file_path));
+                        static_cast<std::ios&>(fits_file).rdbuf(read_ahead.get());
+                        read_primary_hdu();
+                    }
+                    else
+                    {
+                        fits_file.open(file_path, std::ios_base::in | std::ios_base::binary);
+                        read_primary_hdu();
+                    }
+                }
+
+                //!returns the number of HDUs read
+                std::size_t hdu_count() const
+                {
+                    return this->hdu_.size();
+                }
+
+                //!returns the HDU at index (0 is the primary HDU)
+                std::shared_ptr<hdu> get_hdu(std::size_t index) const
+                {
+                    return this->hdu_.at(index);
+                }
+
+                //!returns the typed reference to the image of the HDU at index, valid as long as this object
+                //!throws fits_exception if the HDU is not a primary HDU, an image extension or a compressed image
+                image_hdu get_image(std::size_t index) const
+                {
+                    image_hdu const& image = this->images.at(index);
+                    if (image.empty())
                     {
-                    case 8:
-                        hdu_[0] = std::make_shared<primary_hdu<B8>>(fits_file, *hdu_[0]);
-                        break;
-                    case 16:
-                        hdu_[0] = std::make_shared<primary_hdu<B16>>(fits_file, *hdu_[0]);
-                        break;
-                    case 32:
-                        hdu_[0] = std::make_shared<primary_hdu<B32>>(fits_file, *hdu_[0]);
-                        break;
-                    case -32:
-                        hdu_[0] = std::make_shared<primary_hdu<_B32>>(fits_file, *hdu_[0]);
-                        break;
-                    case -64:
-                        hdu_[0] = std::make_shared<primary_hdu<_B64>>(fits_file, *hdu_[0]);
-                        break;
-                    default:
                         throw fits_exception();
                     }
+                    return image;
+                }
+
+                void read_primary_hdu()
+                {
+                    hdu header(fits_file);
+                    add_image_hdu<primary_hdu>(header.bitpix(), fits_file, header);
+                }
+
+                //!reads all the extensions following the primary HDU
+                //!only the columns and rows of selection are read from every table (all of them by default),
+                //!so every table must have the columns it names
+                void read_extensions(table_selection const& selection = table_selection())
+                {
+                    read_extension_hdus(std::map<std::string, table_selection>(), selection);
+                }
+
+                //!reads all the extensions following the primary HDU
+                //!only the columns and rows of selections[name] are read from the table whose EXTNAME is name,
+                //!tables whose EXTNAME is not a key of selections are read whole
+                void read_extensions(std::map<std::string, table_selection> const& selections)
+                {
+                    read_extension_hdus(selections, table_selection());
+                }
+
+                //!maps the file and parses all the HDUs from the mapping
+                void read_mapped(std::string const& file_path)
+                {
+                    mapping = std::make_shared<mapped_file const>(file_path);
+                    char const* begin = mapping->data();
+                    std::size_t offset = 0;
+
+                    while (offset < mapping->size())
+                    {
+                        hdu header;
+                        offset += header.read_header(begin + offset, begin + mapping->size(), mapping);
+                        if (offset + header.data_size() > mapping->size())
+                        {
+                            throw fits_exception();
+                        }
+
+                        if (hdu_.empty())
+                        {
+                            add_image_hdu<primary_hdu>(header.bitpix(), mapping, offset, header);
+                        }
+                        else if (header.value_of<std::string>("XTENSION") == "'IMAGE   '")
+                        {
+                            add_image_hdu<image_extension>(header.bitpix(), mapping, offset, header);
+                        }
+                        else if (is_compressed_image(header))
+                        {
+                            add_image_hdu<compressed_image_extension>(compressed_bitpix(header), mapping, offset, header);
+                        }
+                        else if (is_binary_table(header))
+                        {
+                            add_hdu(std::make_shared<binary_table_extension>(mapping, offset, header));
+                        }
+                        else if (header.value_of<std::string>("XTENSION") == "'TABLE   '")
+                        {
+                            add_hdu(std::make_shared<ascii_table_extension>(mapping, offset, header));
+                        }
+                        else
+                        {
+                            add_hdu(std::make_shared<hdu>(header));
+                        }
+
+                        offset += hdu::unit_size(header.data_size());
+                    }
+                }
+
+                //!reads all the headers from file and seeks over the data units
+                //!images of primary and image extension HDUs are read only when first accessed
+                void read_deferred(std::string const& file_path)
+                {
+                    fits_file.open(file_path, std::ios_base::in | std::ios_base::binary);
+
+                    while (fits_file.peek() != std::char_traits<char>::eof())
+                    {
+                        hdu header(fits_file);
+                        std::size_t offset = static_cast<std::size_t>(fits_file.tellg());
+
+                        if (hdu_.empty())
+                        {
+                            add_image_hdu<primary_hdu>(header.bitpix(), file_path, offset, header);
+                        }
+                        else if (header.value_of<std::string>("XTENSION") == "'IMAGE   '")
+                        {
+                            add_image_hdu<image_extension>(header.bitpix(), file_path, offset, header);
+                        }
+                        else if (is_compressed_image(header))
+                        {
+                            add_image_hdu<compressed_image_extension>(compressed_bitpix(header), file_path, offset, header);
+                        }
+                        else if (is_binary_table(header))
+                        {
+                            add_hdu(std::make_shared<binary_table_extension>(file_path, offset, header));
+                        }
+                        else if (header.value_of<std::string>("XTENSION") == "'TABLE   '")
+                        {
+                            add_hdu(std::make_shared<ascii_table_extension>(file_path, offset, header));
+                        }
+                        else
+                        {
+                            add_hdu(std::make_shared<hdu>(header));
+                        }
+
+                        skip_data(header);
+                    }
+                }
+
+                //!reads the images and tables of all the deferred HDUs at the same time using positional reads on file_path
+                //!threads is the maximum number of threads to use (0 uses all hardware threads)
+                void load_parallel(std::string const& file_path, std::size_t threads = 0)
+                {
+                    boost::astronomy::detail::positional_file file(file_path);
+
+                    //HDU types are resolved here so that threads only read and convert data
+                    std::vector<std::function<void()>> tasks;
+                    image_load_task image_task = {file};
+                    for (std::size_t i = 0; i < hdu_.size(); i++)
+                    {
+                        if (!images[i].empty())
+                        {
+                            std::function<void()> task = images[i].visit(image_task);
+                            if (task)
+                            {
+                                tasks.emplace_back(task);
+                            }
+                        }
+                        else if (is_binary_table(*hdu_[i]))
+                        {
+                            tasks.emplace_back(load_task<binary_table_extension>(*hdu_[i], file));
+                        }
+                        else if (hdu_[i]->value_of<std::string>("XTENSION") == "'TABLE   '")
+                        {
+                            tasks.emplace_back(load_task<ascii_table_extension>(*hdu_[i], file));
+                        }
+                    }
+
+                    boost::astronomy::detail::parallel_for(tasks.size(), [&tasks](std::size_t i)
+                    {
+                        tasks[i]();
+                    }, threads);
                 }
 
-                void read_extensions()
+            protected:
+                //!reads the extensions following the primary HDU, tables are read with selection_of(header, selections, selection)
+                void read_extension_hdus(std::map<std::string, table_selection> const& selections,
+                    table_selection const& selection)
                 {
                     //if no extension then return
-                    if (!hdu_[0]->value_of<bool>("EXTEND"))
+                    if (!hdu_[0]->value_of<bool>("EXTEND", true))
                     {
                         return;
                     }
 
-                    while (!fits_file.eof())
+                    while (fits_file.peek() != std::char_traits<char>::eof())
                     {
                         //this statement allows up to read all the cards stored
                         //It gives us the benefit of knowing which kind of data we need to store
-                        hdu_.emplace_back(std::make_shared<hdu>(fits_file));
+                        hdu header(fits_file);
 
-                        if (hdu_.back()->value_of<std::string>("XTENSION") == "'IMAGE   '")
+                        if (header.value_of<std::string>("XTENSION") == "'IMAGE   '")
                         {
-                            switch (hdu_.back()->value_of<int>(std::string("BITPIX")))
-                            {
-                            case 8:
-                                hdu_.back() = std::make_shared<image_extension<B8>>(fits_file, *hdu_.back());
-                                break;
-                            case 16:
-                                hdu_.back() = std::make_shared<image_extension<B16>>(fits_file, *hdu_.back());
-                                break;
-                            case 32:
-                                hdu_.back() = std::make_shared<image_extension<B32>>(fits_file, *hdu_.back());
-                                break;
-                            case -32:
-                                hdu_.back() = std::make_shared<image_extension<_B32>>(fits_file, *hdu_.back());
-                                break;
-                            case -64:
-                                hdu_.back() = std::make_shared<image_extension<_B64>>(fits_file, *hdu_.back());
-                                break;
-                            default:
-                                throw fits_exception();
-                                break;
-                            }
+                            add_image_hdu<image_extension>(header.bitpix(), fits_file, header);
+                        }
+                        else if (is_compressed_image(header))
+                        {
+                            add_image_hdu<compressed_image_extension>(compressed_bitpix(header), fits_file, header);
+                        }
+                        else if (is_binary_table(header))
+                        {
+                            add_hdu(std::make_shared<binary_table_extension>(fits_file, header,
+                                selection_of(header, selections, selection)));
                         }
-                        else if (hdu_.back()->value_of<std::string>("XTENSION") == "'TABLE   '")
+                        else if (header.value_of<std::string>("XTENSION") == "'TABLE   '")
                         {
+                            add_hdu(std::make_shared<ascii_table_extension>(fits_file, header,
+                                selection_of(header, selections, selection)));
+                        }
+                        else
+                        {
+                            //unknown extensions are skipped
+                            add_hdu(std::make_shared<hdu>(header));
+                            skip_data(header);
+                        }
+                    }
+                }
 
+                //!returns the selection of the table whose header is table: selections[EXTNAME] if there is one, else selection
+                static table_selection const& selection_of(hdu const& table, std::map<std::string, table_selection> const& selections,
+                    table_selection const& selection)
+                {
+                    if (!selections.empty() && table.has_key("EXTNAME"))
+                    {
+                        std::map<std::string, table_selection>::const_iterator const found =
+                            selections.find(string_value(table.value_of<std::string>("EXTNAME")));
+                        if (found != selections.end())
+                        {
+                            return found->second;
                         }
-                        
                     }
+                    return selection;
+                }
+
+                //!returns the function which loads the image of a primary HDU or an image extension from file
+                //!compressed images are decompressed on access so they have no task
+                struct image_load_task
+                {
+                    typedef std::function<void()> result_type;
+
+                    boost::astronomy::detail::positional_file const& file;
+
+                    template <bitpix DataType>
+                    result_type operator()(primary_hdu<DataType>& typed) const
+                    {
+                        return load_task<primary_hdu<DataType>>(typed, this->file);
+                    }
+
+                    template <bitpix DataType>
+                    result_type operator()(image_extension<DataType>& typed) const
+                    {
+                        return load_task<image_extension<DataType>>(typed, this->file);
+                    }
+
+                    template <bitpix DataType>
+                    result_type operator()(compressed_image_extension<DataType>&) const
+                    {
+                        return result_type();
+                    }
+                };
+
+                template <typename TypedHdu>
+                static std::function<void()> load_task(hdu& header, boost::astronomy::detail::positional_file const& file)
+                {
+                    TypedHdu* typed = static_cast<TypedHdu*>(&header);
+                    return [typed, &file]()
+                    {
+                        typed->load_data(file);
+                    };
+                }
+
+                //!appends an HDU which holds no image
+                void add_hdu(std::shared_ptr<hdu> const& header)
+                {
+                    hdu_.push_back(header);
+                    images.emplace_back();
+                }
+
+                //!appends the HDU of type HduType<type> created from the arguments and its typed reference
+                //!this is the only place where the type of the pixels is resolved at run time
+                template <template <bitpix> class HduType, typename... Args>
+                void add_image_hdu(bitpix type, Args&&... args)
+                {
+                    switch (type)
+                    {
+                    case B8:
+                        add_typed_hdu<HduType<B8>>(args...);
+                        break;
+                    case B16:
+                        add_typed_hdu<HduType<B16>>(args...);
+                        break;
+                    case B32:
+                        add_typed_hdu<HduType<B32>>(args...);
+                        break;
+                    case _B32:
+                        add_typed_hdu<HduType<_B32>>(args...);
+                        break;
+                    case _B64:
+                        add_typed_hdu<HduType<_B64>>(args...);
+                        break;
+                    default:
+                        throw fits_exception();
+                    }
+                }
+
+                template <typename TypedHdu, typename... Args>
+                void add_typed_hdu(Args&... args)
+                {
+                    std::shared_ptr<TypedHdu> typed = std::make_shared<TypedHdu>(args...);
+                    hdu_.push_back(typed);
+                    images.emplace_back(typed.get());
+                }
+
+                //!returns true if header is a binary table holding a tile compressed image (ZIMAGE = T)
+                static bool is_compressed_image(hdu& header)
+                {
+                    return header.value_of<std::string>("XTENSION") == "'BINTABLE'" && header.has_key("ZIMAGE") &&
+                        header.value_of<bool>("ZIMAGE");
+                }
+
+                //!returns true if header is a binary table which does not hold a compressed image
+                static bool is_binary_table(hdu& header)
+                {
+                    return header.value_of<std::string>("XTENSION") == "'BINTABLE'" && !is_compressed_image(header);
+                }
+
+                //!returns the type of the pixels of a tile compressed image (ZBITPIX)
+                static bitpix compressed_bitpix(hdu& header)
+                {
+                    return to_bitpix(header.value_of<int>("ZBITPIX"));
+                }
+
+                //!moves the file cursor past the data unit of the HDU whose header has just been read
+                void skip_data(hdu const& header)
+                {
+                    fits_file.seekg(static_cast<std::streamoff>(hdu::unit_size(header.data_size())), std::ios_base::cur);
                 }
             };
         } //namespace io
@@ -0,0 +1,253 @@
+#ifndef BOOST_ASTRONOMY_IO_FITS_WRITER_HPP
+#define BOOST_ASTRONOMY_IO_FITS_WRITER_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/align/aligned_allocator.hpp>
+
+#include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/card.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/image_stream.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/detail/byteswap.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!writes a FITS file HDU by HDU: write_header() followed by any number of write_data() calls for every HDU
+            //!everything goes through one large buffer which is a whole number of 2880 byte blocks, so the file is
+            //!written in few large block aligned writes; pixels are converted to big-endian while being copied into it
+            struct fits_writer
+            {
+            protected:
+                std::ofstream file; //!file being written, unbuffered as all the writes come from buffer
+                std::vector<char, boost::alignment::aligned_allocator<char, 64>> buffer; //!bytes not yet written
+                std::size_t used; //!number of bytes in buffer
+                std::uint64_t position; //!number of bytes written so far including those in buffer
+
+                //!number of bytes converted at once, the copy and the byte swap both run in L1 cache
+                static std::size_t const swap_chunk = 1 << 15;
+
+            public:
+                //!buffer_size is rounded up to a multiple of 2880 bytes
+                explicit fits_writer(std::string const& file_path, std::size_t buffer_size = std::size_t(4) << 20) :
+                    buffer(((std::max)(buffer_size, std::size_t(1)) + 2879) / 2880 * 2880), used(0), position(0)
+                {
+                    this->file.rdbuf()->pubsetbuf(nullptr, 0);
+                    this->file.open(file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+                    if (!this->file)
+                    {
+                        throw fits_exception();
+                    }
+                }
+
+                fits_writer(fits_writer const&) = delete;
+                fits_writer& operator=(fits_writer const&) = delete;
+
+                ~fits_writer()
+                {
+                    try
+                    {
+                        close();
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+
+                //!starts a new HDU: pads the previous data unit with zeros, writes cards followed by END card and
+                //!pads the header with spaces
+                void write_header(std::vector<card> const& cards)
+                {
+                    pad_unit('\0');
+                    for (card const& header_card : cards)
+                    {
+                        boost::string_view raw = header_card.raw();
+                        if (raw.size() != 80)
+                        {
+                            throw invalid_card_length_exception();
+                        }
+                        put(raw.data(), raw.size());
+                    }
+                    put(end_card().data(), 80);
+                    pad_unit(' ');
+                }
+
+                //!appends count pixels to the current data unit in big-endian byte order
+                template <typename PixelType>
+                void write_data(PixelType const* pixels, std::size_t count)
+                {
+                    unsigned char const* bytes = reinterpret_cast<unsigned char const*>(pixels);
+                    std::size_t size = count * sizeof(PixelType);
+                    std::size_t const chunk_limit = swap_chunk;
+                    while (size > 0)
+                    {
+                        if (this->buffer.size() - this->used < sizeof(PixelType))
+                        {
+                            flush_buffer();
+                        }
+
+                        std::size_t chunk = (std::min)(size, (std::min)(chunk_limit, this->buffer.size() - this->used));
+                        chunk -= chunk % sizeof(PixelType);
+                        unsigned char* out = reinterpret_cast<unsigned char*>(this->buffer.data()) + this->used;
+                        std::memcpy(out, bytes, chunk);
+                        if (boost::endian::order::native == boost::endian::order::little)
+                        {
+                            boost::astronomy::detail::reverse_bytes<sizeof(PixelType)>(out, chunk / sizeof(PixelType));
+                        }
+
+                        this->used += chunk;
+                        this->position += chunk;
+                        bytes += chunk;
+                        size -= chunk;
+                    }
+                }
+
+                //!appends all the pixels of data to the current data unit, rows in order
+                template <typename PixelType>
+                void write_data(image_buffer<PixelType> const& data)
+                {
+                    write_data(data.raw_data(), data.get_width() * data.get_height());
+                }
+
+                //!writes a primary HDU containing data, cards are added to the header after the mandatory ones
+                template <bitpix DataType>
+                void write_primary_hdu(image<DataType> const& data, std::vector<card> const& cards = std::vector<card>())
+                {
+                    write_header(append_cards(primary_header(DataType, data.get_width(), data.get_height()), cards));
+                    write_data(data);
+                }
+
+                //!writes an IMAGE extension containing data, cards are added to the header after the mandatory ones
+                template <bitpix DataType>
+                void write_image_extension(image<DataType> const& data, std::vector<card> const& cards = std::vector<card>())
+                {
+                    write_header(append_cards(image_extension_header(DataType, data.get_width(), data.get_height()), cards));
+                    write_data(data);
+                }
+
+                //!writes an IMAGE extension containing all the remaining strips of stream
+                //!only the strips of stream are held in memory, so any size of image can be copied
+                template <bitpix DataType>
+                void write_image_extension(image_stream<DataType>& stream, std::vector<card> const& cards = std::vector<card>())
+                {
+                    write_header(append_cards(image_extension_header(DataType, stream.get_width(), stream.get_height()), cards));
+                    stream.for_each_strip([this](image<DataType> const& strip, std::size_t)
+                    {
+                        this->write_data(strip);
+                    });
+                }
+
+                //!pads the last data unit and writes everything to the file
+                void close()
+                {
+                    if (!this->file.is_open())
+                    {
+                        return;
+                    }
+                    pad_unit('\0');
+                    flush_buffer();
+                    this->file.close();
+                    if (!this->file)
+                    {
+                        throw fits_exception();
+                    }
+                }
+
+                //!returns the number of bytes written so far
+                std::uint64_t size() const
+                {
+                    return this->position;
+                }
+
+                //!returns the mandatory cards of a primary HDU with a 2 dimensional image
+                static std::vector<card> primary_header(bitpix type, std::size_t width, std::size_t height)
+                {
+                    std::vector<card> cards(6);
+                    cards[0].create_card("SIMPLE", true, " file conforms to FITS standard");
+                    cards[1].create_card("BITPIX", header_value(type), " number of bits per data pixel");
+                    cards[2].create_card("NAXIS", 2, " number of data axes");
+                    cards[3].create_card("NAXIS1", width, " length of data axis 1");
+                    cards[4].create_card("NAXIS2", height, " length of data axis 2");
+                    cards[5].create_card("EXTEND", true, " extensions may be present");
+                    return cards;
+                }
+
+                //!returns the mandatory cards of an IMAGE extension with a 2 dimensional image
+                static std::vector<card> image_extension_header(bitpix type, std::size_t width, std::size_t height)
+                {
+                    std::vector<card> cards(7);
+                    cards[0].create_card("XTENSION", std::string("'IMAGE   '"), " image extension");
+                    cards[1].create_card("BITPIX", header_value(type), " number of bits per data pixel");
+                    cards[2].create_card("NAXIS", 2, " number of data axes");
+                    cards[3].create_card("NAXIS1", width, " length of data axis 1");
+                    cards[4].create_card("NAXIS2", height, " length of data axis 2");
+                    cards[5].create_card("PCOUNT", 0, " required keyword; must = 0");
+                    cards[6].create_card("GCOUNT", 1, " required keyword; must = 1");
+                    return cards;
+                }
+
+            protected:
+                static std::string const& end_card()
+                {
+                    static std::string const end = std::string("END").append(77, ' ');
+                    return end;
+                }
+
+                static std::vector<card> append_cards(std::vector<card> header, std::vector<card> const& cards)
+                {
+                    header.insert(header.end(), cards.begin(), cards.end());
+                    return header;
+                }
+
+                void put(char const* bytes, std::size_t size)
+                {
+                    while (size > 0)
+                    {
+                        if (this->used == this->buffer.size())
+                        {
+                            flush_buffer();
+                        }
+                        std::size_t chunk = (std::min)(size, this->buffer.size() - this->used);
+                        std::memcpy(this->buffer.data() + this->used, bytes, chunk);
+                        this->used += chunk;
+                        this->position += chunk;
+                        bytes += chunk;
+                        size -= chunk;
+                    }
+                }
+
+                //!fills the rest of the current 2880 byte block with fill
+                void pad_unit(char fill)
+                {
+                    std::size_t padding = static_cast<std::size_t>((2880 - this->position % 2880) % 2880);
+                    char block[2880];
+                    std::memset(block, fill, padding);
+                    put(block, padding);
+                }
+
+                void flush_buffer()
+                {
+                    this->file.write(this->buffer.data(), static_cast<std::streamsize>(this->used));
+                    if (!this->file)
+                    {
+                        throw fits_exception();
+                    }
+                    this->used = 0;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_FITS_WRITER_HPP
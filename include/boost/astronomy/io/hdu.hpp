@@ -5,14 +5,19 @@
 #include <fstream>
 #include <vector>
 #include <cstddef>
-#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/utility/string_view.hpp>
 #include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/value_scaling.hpp>
 
 #include <boost/astronomy/exception/fits_exception.hpp>
 #include <boost/astronomy/io/card.hpp>
+#include <boost/astronomy/detail/keyword_index.hpp>
 
 namespace boost
 {
@@ -25,8 +30,9 @@ namespace boost
             protected:
                 boost::astronomy::io::bitpix bitpix_value; //! stores the BITPIX value (enum bitpix)
                 std::vector<std::size_t> _naxis; //! values of all naxis (NAXIS, NAXIS1, NAXIS2...)
+                std::shared_ptr<char const> header_buffer; //! all the header blocks of the unit, cards refer into it
                 std::vector<card> cards; //! Stores the each card in header unit (80 char key value pair)
-                std::unordered_map<std::string, std::size_t> key_index; //! stores the card-key index (used for faster searching)
+                boost::astronomy::detail::keyword_index key_index; //! positions of the cards by keyword (used for faster searching)
 
             public:
                 hdu() {}
@@ -56,61 +62,74 @@ namespace boost
                 }
 
                 //!Starts reading the header from current streampos of file
+                //!header is read block by block (2880 bytes) into one buffer and the cards refer into that buffer
                 void read_header(std::fstream &file)
                 {
-                    cards.reserve(36); //reserves the space of atleast 1 HDU unit 
-                    char _80_char_from_file[80]; //used as buffer to read a card consisting of 80 char
+                    std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>();
+                    std::size_t card_count = 0;
 
-                    //reading file card by card until END card is found
-                    while (true)
+                    //reading file block by block until the block with END card is found
+                    while (card_count == 0)
                     {
-                        //read from file and create push card into the vector
-                        file.read(_80_char_from_file, 80);
-                        cards.emplace_back(_80_char_from_file);
+                        std::size_t block = buffer->size();
+                        buffer->resize(block + 2880);
+                        file.read(buffer->data() + block, 2880);
+                        if (!file)
+                        {
+                            throw fits_exception();
+                        }
 
-                        //store the index of the card in map
-                        this->key_index[this->cards.back().key()] = this->cards.size() - 1;
+                        std::size_t end = find_end_card(buffer->data() + block);
+                        if (end != 0)
+                        {
+                            card_count = block / 80 + end;
+                        }
+                    }
+
+                    this->header_buffer = std::shared_ptr<char const>(buffer, buffer->data());
+                    set_cards(card_count);
+                    set_header_values();
+                }
+
+                //!parses the header stored in memory starting at begin (e.g. a mapped file) without reading past end
+                //!if owner is provided then it must keep the memory alive and the cards refer directly into it
+                //!otherwise the header blocks are copied
+                //!returns the size of the header unit in bytes including the padding
+                std::size_t read_header(char const* begin, char const* end,
+                    std::shared_ptr<void const> const& owner = std::shared_ptr<void const>())
+                {
+                    std::size_t card_count = 0;
+                    std::size_t size = 0;
+
+                    //scanning block by block until the block with END card is found
+                    while (card_count == 0)
+                    {
+                        if (end - (begin + size) < 2880)
+                        {
+                            throw fits_exception();
+                        }
 
-                        //check if end card is found
-                        if(this->cards.back().key(true) == "END     ")
+                        std::size_t found = find_end_card(begin + size);
+                        if (found != 0)
                         {
-                            break;
+                            card_count = size / 80 + found;
                         }
+                        size += 2880;
                     }
-                    set_unit_end(file);    //set cursor to the end of the HDU unit
 
-                    //finding and storing bitpix value
-                    
-                    switch (cards[key_index["BITPIX"]].value<int>())
+                    if (owner)
                     {
-                    case 8:
-                        this->bitpix_value = boost::astronomy::io::B8;
-                        break;
-                    case 16:
-                        this->bitpix_value = boost::astronomy::io::B16;
-                        break;
-                    case 32:
-                        this->bitpix_value = boost::astronomy::io::B32;
-                        break;
-                    case -32:
-                        this->bitpix_value = boost::astronomy::io::_B32;
-                        break;
-                    case -64:
-                        this->bitpix_value = boost::astronomy::io::_B64;
-                        break;
-                    default:
-                        throw fits_exception();
-                        break;
+                        this->header_buffer = std::shared_ptr<char const>(owner, begin);
                     }
-                    
-                    //setting naxis values
-                    _naxis.emplace_back(cards[key_index["NAXIS"]].value<std::size_t>());
-                    _naxis.reserve(_naxis[0]);
-                    
-                    for (std::size_t i = 1; i <= _naxis[0]; i++)
+                    else
                     {
-                        _naxis.emplace_back(cards[key_index["NAXIS" + boost::lexical_cast<std::string>(i)]].value<std::size_t>());
+                        std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>(begin, begin + size);
+                        this->header_buffer = std::shared_ptr<char const>(buffer, buffer->data());
                     }
+
+                    set_cards(card_count);
+                    set_header_values();
+                    return size;
                 }
 
                 //!starts reading file from the position specified
@@ -132,22 +151,191 @@ namespace boost
                     return this->_naxis;
                 }
 
+                //!returns NAXIS1, NAXIS2 ... NAXISn, the shape of the N dimensional image stored in data unit
+                std::vector<std::size_t> get_shape() const
+                {
+                    return this->_naxis.empty() ? std::vector<std::size_t>() :
+                        std::vector<std::size_t>(this->_naxis.begin() + 1, this->_naxis.end());
+                }
+
                 //!returns the value of particular naxis
                 std::size_t naxis(std::size_t n = 0)
                 {
                     return this->_naxis[n];
                 }
 
-                //!returns the value of perticular key 
+                //!returns NAXIS1, the width of image stored in data unit (0 if there is no data)
+                std::size_t image_width() const
+                {
+                    return this->_naxis.size() > 1 ? this->_naxis[1] : 0;
+                }
+
+                //!returns NAXIS2 * NAXIS3 * ... * NAXISn, all the axis after NAXIS1 are folded into the height of image
+                std::size_t image_height() const
+                {
+                    if (this->_naxis.size() < 2)
+                    {
+                        return 0;
+                    }
+
+                    std::size_t height = 1;
+                    for (std::size_t i = 2; i < this->_naxis.size(); i++)
+                    {
+                        height *= this->_naxis[i];
+                    }
+                    return height;
+                }
+
+                //!returns true if the header contains a card with key
+                bool has_key(boost::string_view key) const
+                {
+                    return this->key_index.find(key) != boost::astronomy::detail::keyword_index::npos;
+                }
+
+                //!returns the number of cards with key (commentary keywords such as HISTORY may be repeated)
+                std::size_t key_count(boost::string_view key) const
+                {
+                    return this->key_index.count(key);
+                }
+
+                //!returns the value of perticular key, the last card is used if key is repeated
+                //!throws key_not_defined_exception if there is no card with key
+                template <typename ReturnType>
+                ReturnType value_of(boost::string_view key) const
+                {
+                    std::size_t index = this->key_index.find(key);
+                    if (index == boost::astronomy::detail::keyword_index::npos)
+                    {
+                        throw key_not_defined_exception();
+                    }
+                    return this->cards[index].value<ReturnType>();
+                }
+
+                //!returns the value of key or default_value if there is no card with key
                 template <typename ReturnType>
-                ReturnType value_of(std::string const& key)// const
+                ReturnType value_of(boost::string_view key, ReturnType const& default_value) const
+                {
+                    std::size_t index = this->key_index.find(key);
+                    return index == boost::astronomy::detail::keyword_index::npos ?
+                        default_value : this->cards[index].value<ReturnType>();
+                }
+
+                //!returns the text (columns 9-80 without trailing spaces) of every card with key in the order of header
+                //!used for commentary keywords such as HISTORY and COMMENT
+                std::vector<std::string> commentary(boost::string_view key) const
                 {
-                    return this->cards[key_index[key]].value<ReturnType>();
+                    std::vector<std::string> texts;
+                    std::pair<boost::astronomy::detail::keyword_index::entry const*,
+                        boost::astronomy::detail::keyword_index::entry const*> range = this->key_index.equal_range(key);
+                    for (; range.first != range.second; ++range.first)
+                    {
+                        boost::string_view text = this->cards[range.first->card].raw().substr(8);
+                        while (!text.empty() && text.back() == ' ')
+                        {
+                            text.remove_suffix(1);
+                        }
+                        texts.emplace_back(text.data(), text.size());
+                    }
+                    return texts;
+                }
+
+                //!returns the scaling from stored to physical values (BSCALE, BZERO and BLANK)
+                //!missing keywords leave stored values unchanged
+                value_scaling get_scaling() const
+                {
+                    value_scaling scaling(value_of<double>("BSCALE", 1.0), value_of<double>("BZERO", 0.0));
+                    if (has_key("BLANK"))
+                    {
+                        scaling.has_blank = true;
+                        scaling.blank = value_of<std::int64_t>("BLANK");
+                    }
+                    return scaling;
+                }
+
+                //!returns the size of data unit in bytes excluding the padding
+                //!size = |BITPIX|/8 * GCOUNT * (PCOUNT + NAXIS1 * NAXIS2 * ... * NAXISm)
+                std::size_t data_size() const
+                {
+                    if (this->_naxis.empty() || this->_naxis[0] == 0)
+                    {
+                        return 0;
+                    }
+
+                    std::size_t elements = 1;
+                    for (std::size_t i = 1; i < this->_naxis.size(); i++)
+                    {
+                        elements *= this->_naxis[i];
+                    }
+
+                    std::size_t gcount = value_of<std::size_t>("GCOUNT", 1);
+                    std::size_t pcount = value_of<std::size_t>("PCOUNT", 0);
+
+                    return element_size(this->bitpix_value) * gcount * (pcount + elements);
+                }
+
+                //!returns size rounded up to the next multiple of 2880 (the size of a FITS block)
+                static std::size_t unit_size(std::size_t size)
+                {
+                    return ((size + 2879) / 2880) * 2880;
                 }
 
                 void set_unit_end(std::fstream &file) const
                 {
-                    file.seekg((file.tellg() + (2880 - (file.tellg() % 2880))));    //set cursor to the end of the HDU unit
+                    if (file.tellg() % 2880 != 0)
+                    {
+                        file.seekg((file.tellg() + (2880 - (file.tellg() % 2880))));    //set cursor to the end of the HDU unit
+                    }
+                }
+
+            protected:
+                //!returns the number of cards up to and including END card in a block of 36 cards (0 if there is no END card)
+                //!first 8 chars of every card are compared with "END     " as one 64 bit word
+                static std::size_t find_end_card(char const* block)
+                {
+                    static char const end_key[8] = {'E', 'N', 'D', ' ', ' ', ' ', ' ', ' '};
+                    std::uint64_t end_word;
+                    std::memcpy(&end_word, end_key, 8);
+
+                    for (std::size_t i = 0; i < 36; i++)
+                    {
+                        std::uint64_t key_word;
+                        std::memcpy(&key_word, block + i * 80, 8);
+                        if (key_word == end_word)
+                        {
+                            return i + 1;
+                        }
+                    }
+                    return 0;
+                }
+
+                //!creates count cards referring to header_buffer and indexes their raw keywords
+                void set_cards(std::size_t count)
+                {
+                    this->cards.clear();
+                    this->_naxis.clear();
+                    this->cards.reserve(count);
+
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        this->cards.emplace_back(boost::string_view(this->header_buffer.get() + i * 80, 80));
+                    }
+                    this->key_index.assign(this->header_buffer.get(), count);
+                }
+
+                //!sets bitpix and naxis values from the cards read
+                void set_header_values()
+                {
+                    //finding and storing bitpix value
+                    this->bitpix_value = to_bitpix(value_of<int>("BITPIX"));
+                    
+                    //setting naxis values
+                    _naxis.emplace_back(value_of<std::size_t>("NAXIS"));
+                    _naxis.reserve(_naxis[0]);
+                    
+                    for (std::size_t i = 1; i <= _naxis[0]; i++)
+                    {
+                        _naxis.emplace_back(value_of<std::size_t>("NAXIS" + boost::lexical_cast<std::string>(i)));
+                    }
                 }
             };
         } //namespace io
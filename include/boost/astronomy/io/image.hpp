@@ -3,16 +3,26 @@
 
 
 #include <valarray>
+#include <vector>
 #include <fstream>
 #include <cstddef>
 #include <algorithm>
 #include <iterator>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <cmath>
 #include <numeric>
 
 #include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/image_statistics.hpp>
+#include <boost/astronomy/io/pixel_conversion.hpp>
+#include <boost/astronomy/io/value_scaling.hpp>
+#include <boost/astronomy/detail/byteswap.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/detail/percentile.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
 #include <boost/endian/conversion.hpp>
 #include <boost/cstdfloat.hpp>
 
@@ -26,22 +36,80 @@ namespace boost
             template <typename PixelType>
             struct image_buffer
             {
+            public:
+                typedef PixelType pixel_type;
+
             protected:
                 std::valarray<PixelType> data; //! stores the image
                 std::size_t width; //! width of image 
                 std::size_t height; //! height of image
                 //std::fstream image_file; //! image file
 
-                //! Used purly for Type punning
-                union pixel_data
+                //! reads data.size() big-endian pixels from the current position of file
+                //! data is read in large chunks and each chunk is converted to native byte order while it is still in cache
+                void read_data(std::istream &file)
+                {
+                    std::size_t const chunk_size = (std::size_t(1) << 20) / sizeof(PixelType); //pixels per chunk (1 MiB)
+                    for (std::size_t i = 0; i < this->data.size(); i += chunk_size)
+                    {
+                        std::size_t count = (std::min)(chunk_size, this->data.size() - i);
+                        file.read(reinterpret_cast<char*>(&this->data[i]), count * sizeof(PixelType));
+                        boost::astronomy::detail::big_to_native_inplace(&this->data[i], count);
+                    }
+                }
+
+                //! reads data.size() big-endian pixels starting at offset of file with positional reads
+                //! data is read in large chunks and each chunk is converted to native byte order while it is still in cache
+                void read_data(boost::astronomy::detail::positional_file const& file, std::uint64_t offset)
+                {
+                    std::size_t const chunk_size = (std::size_t(1) << 20) / sizeof(PixelType); //pixels per chunk (1 MiB)
+                    for (std::size_t i = 0; i < this->data.size(); i += chunk_size)
+                    {
+                        std::size_t count = (std::min)(chunk_size, this->data.size() - i);
+                        file.read(reinterpret_cast<char*>(&this->data[i]), count * sizeof(PixelType), offset + i * sizeof(PixelType));
+                        boost::astronomy::detail::big_to_native_inplace(&this->data[i], count);
+                    }
+                }
+
+                //! copies data.size() big-endian pixels starting at bytes and converts them to native byte order
+                void read_data(char const* bytes)
                 {
-                    PixelType pixel;
-                    std::uint8_t byte[sizeof(PixelType)];
-                    //char byte[sizeof(PixelType)];
-                };
+                    if (this->data.size() == 0)
+                    {
+                        return;
+                    }
+                    std::memcpy(&this->data[0], bytes, this->data.size() * sizeof(PixelType));
+                    boost::astronomy::detail::big_to_native_inplace(&this->data[0], this->data.size());
+                }
+
+                //! sets the size of image to region_width x region_height and reads every row of the region
+                //! with read_row(source_row, destination) as big-endian pixels, all rows are converted together at the end
+                template <typename RowReader>
+                void read_region(std::size_t x, std::size_t region_width, std::size_t region_height, RowReader read_row)
+                {
+                    set_size(region_width, region_height);
+
+                    for (std::size_t row = 0; row < region_height && region_width > 0; row++)
+                    {
+                        read_row(x + row, reinterpret_cast<char*>(&this->data[row * region_width]));
+                    }
+                    if (this->data.size() != 0)
+                    {
+                        boost::astronomy::detail::big_to_native_inplace(&this->data[0], this->data.size());
+                    }
+                }
+
+                static void check_region(std::size_t image_width, std::size_t image_height, std::size_t x, std::size_t y,
+                    std::size_t region_width, std::size_t region_height)
+                {
+                    if (x > image_height || region_height > image_height - x || y > image_width || region_width > image_width - y)
+                    {
+                        throw boost::astronomy::region_out_of_range_exception();
+                    }
+                }
 
             public:
-                image_buffer() {}
+                image_buffer() : width(0), height(0) {}
 
                 image_buffer(std::size_t width, std::size_t height) : width(width), height(height)
                 {
@@ -50,6 +118,192 @@ namespace boost
 
                 virtual ~image_buffer() {}
 
+                //! sets the size of image, storage is reallocated only if the number of pixels changes
+                //! so that an image can be reused as a buffer without allocating or clearing memory
+                void set_size(std::size_t image_width, std::size_t image_height)
+                {
+                    this->width = image_width;
+                    this->height = image_height;
+                    if (this->data.size() != image_width * image_height)
+                    {
+                        this->data.resize(image_width * image_height);
+                    }
+                }
+
+                //! copies image_width*image_height big-endian pixels from memory (e.g. a mapped file) into the image
+                void assign_big_endian(char const* bytes, std::size_t image_width, std::size_t image_height)
+                {
+                    set_size(image_width, image_height);
+                    read_data(bytes);
+                }
+
+                //! reads image_width*image_height big-endian pixels starting at offset of file into the image
+                //! any number of images can be read from the same file by different threads at the same time
+                void assign_big_endian(boost::astronomy::detail::positional_file const& file, std::uint64_t offset,
+                    std::size_t image_width, std::size_t image_height)
+                {
+                    set_size(image_width, image_height);
+                    read_data(file, offset);
+                }
+
+                //! copies the region of source image which starts at source(x, y) (x is the row and y the column as in operator())
+                //! and is region_width pixels wide and region_height pixels high
+                void assign_region(image_buffer const& source, std::size_t x, std::size_t y,
+                    std::size_t region_width, std::size_t region_height)
+                {
+                    check_region(source.width, source.height, x, y, region_width, region_height);
+                    set_size(region_width, region_height);
+
+                    for (std::size_t row = 0; row < region_height; row++)
+                    {
+                        std::copy_n(&source.data[(x + row) * source.width + y], region_width, &this->data[row * region_width]);
+                    }
+                }
+
+                //! reads the region which starts at (x, y) of a big-endian image of image_width x image_height stored in memory
+                //! only the pixels inside the region are copied and converted
+                void assign_region_big_endian(char const* bytes, std::size_t image_width, std::size_t image_height,
+                    std::size_t x, std::size_t y, std::size_t region_width, std::size_t region_height)
+                {
+                    check_region(image_width, image_height, x, y, region_width, region_height);
+                    read_region(x, region_width, region_height, [&](std::size_t row, char* destination)
+                    {
+                        std::memcpy(destination, bytes + (row * image_width + y) * sizeof(PixelType), region_width * sizeof(PixelType));
+                    });
+                }
+
+                //! reads the region which starts at (x, y) of a big-endian image of image_width x image_height stored at offset of file
+                //! only the rows covered by the region are read, one positional read per row
+                void assign_region_big_endian(boost::astronomy::detail::positional_file const& file, std::uint64_t offset,
+                    std::size_t image_width, std::size_t image_height,
+                    std::size_t x, std::size_t y, std::size_t region_width, std::size_t region_height)
+                {
+                    check_region(image_width, image_height, x, y, region_width, region_height);
+                    if (region_width == image_width)
+                    {
+                        //rows of the region are contiguous in file
+                        set_size(region_width, region_height);
+                        read_data(file, offset + x * image_width * sizeof(PixelType));
+                        return;
+                    }
+
+                    read_region(x, region_width, region_height, [&](std::size_t row, char* destination)
+                    {
+                        file.read(destination, region_width * sizeof(PixelType), offset + (row * image_width + y) * sizeof(PixelType));
+                    });
+                }
+
+                //! stores the physical values of image_width*image_height big-endian values of type Stored from memory
+                //! (e.g. a mapped file), the byte order conversion and the scaling are done in the same pass
+                template <typename Stored>
+                void assign_physical(char const* bytes, std::size_t image_width, std::size_t image_height,
+                    value_scaling const& scaling)
+                {
+                    set_size(image_width, image_height);
+                    if (this->data.size() != 0)
+                    {
+                        scaling.template apply_big_endian<Stored>(bytes, this->data.size(), &this->data[0]);
+                    }
+                }
+
+                //! reads image_width*image_height big-endian values of type Stored starting at offset of file
+                //! and stores their physical values, every chunk read is converted and scaled while it is still in cache
+                template <typename Stored>
+                void assign_physical(boost::astronomy::detail::positional_file const& file, std::uint64_t offset,
+                    std::size_t image_width, std::size_t image_height, value_scaling const& scaling)
+                {
+                    set_size(image_width, image_height);
+                    std::size_t const chunk_size = (std::size_t(1) << 20) / sizeof(Stored); //values per chunk (1 MiB)
+                    std::vector<char> chunk((std::min)(chunk_size, this->data.size()) * sizeof(Stored));
+                    for (std::size_t i = 0; i < this->data.size(); i += chunk_size)
+                    {
+                        std::size_t count = (std::min)(chunk_size, this->data.size() - i);
+                        file.read(chunk.data(), count * sizeof(Stored), offset + i * sizeof(Stored));
+                        scaling.template apply_big_endian<Stored>(chunk.data(), count, &this->data[i]);
+                    }
+                }
+
+                //! stores the physical values of the pixels of source, an image of stored values in native byte order
+                template <typename Stored>
+                void assign_physical(image_buffer<Stored> const& source, value_scaling const& scaling)
+                {
+                    set_size(source.get_width(), source.get_height());
+                    if (this->data.size() != 0)
+                    {
+                        scaling.apply(source.raw_data(), this->data.size(), &this->data[0]);
+                    }
+                }
+
+                //! stores the pixels of source converted to PixelType (see convert_pixels() for saturation and rounding)
+                //! e.g. a B16 frame as float or a _B64 frame as float, large images are converted by up to threads threads
+                template <typename Source>
+                void assign_converted(image_buffer<Source> const& source,
+                    rounding_policy rounding = rounding_policy::nearest, std::size_t threads = 0)
+                {
+                    set_size(source.get_width(), source.get_height());
+                    if (this->data.size() != 0)
+                    {
+                        convert_pixels(source.raw_data(), this->data.size(), &this->data[0], rounding, threads);
+                    }
+                }
+
+                //! stores image_width*image_height big-endian values of type Stored from memory (e.g. a mapped file)
+                //! converted to PixelType, the byte order conversion and the conversion of type are done in the same pass
+                template <typename Stored>
+                void assign_converted(char const* bytes, std::size_t image_width, std::size_t image_height,
+                    rounding_policy rounding = rounding_policy::nearest, std::size_t threads = 0)
+                {
+                    set_size(image_width, image_height);
+                    if (this->data.size() != 0)
+                    {
+                        convert_big_endian<PixelType, Stored>(bytes, this->data.size(), &this->data[0], rounding, threads);
+                    }
+                }
+
+                //! reads image_width*image_height big-endian values of type Stored starting at offset of file and stores
+                //! them converted to PixelType, chunks are read and converted by up to threads threads
+                template <typename Stored>
+                void assign_converted(boost::astronomy::detail::positional_file const& file, std::uint64_t offset,
+                    std::size_t image_width, std::size_t image_height,
+                    rounding_policy rounding = rounding_policy::nearest, std::size_t threads = 0)
+                {
+                    set_size(image_width, image_height);
+                    std::size_t const chunk_size = (std::size_t(1) << 20) / sizeof(Stored); //values per chunk (1 MiB)
+                    std::size_t const size = this->data.size();
+                    boost::astronomy::detail::parallel_for((size + chunk_size - 1) / chunk_size, [&](std::size_t chunk_index)
+                    {
+                        std::size_t const first = chunk_index * chunk_size;
+                        std::size_t const count = (std::min)(chunk_size, size - first);
+                        std::vector<char> chunk(count * sizeof(Stored));
+                        file.read(chunk.data(), chunk.size(), offset + first * sizeof(Stored));
+                        convert_big_endian<PixelType, Stored>(chunk.data(), count, &this->data[first], rounding, 1);
+                    }, threads);
+                }
+
+                //! returns width of image
+                std::size_t get_width() const
+                {
+                    return this->width;
+                }
+
+                //! returns height of image
+                std::size_t get_height() const
+                {
+                    return this->height;
+                }
+
+                //! returns pointer to the first pixel, pixels are stored row by row in native byte order
+                PixelType const* raw_data() const
+                {
+                    return this->data.size() == 0 ? nullptr : &this->data[0];
+                }
+
+                //! returns pointer to the first pixel for writing the pixels directly
+                PixelType* raw_data()
+                {
+                    return this->data.size() == 0 ? nullptr : &this->data[0];
+                }
+
                 //! returns the maximum value of all the pixels in the image
                 PixelType max() const
                 {
@@ -62,46 +316,49 @@ namespace boost
                     return this->data.min();
                 }
 
-                //! returns the mean value of all the pixels in image
-                double mean() const
+                //! returns count, sum, minimum, maximum, mean and variance of all the pixels computed in one pass
+                //! the image is split between up to threads threads (0 uses all hardware threads)
+                image_statistics statistics(std::size_t threads = 0) const
                 {
                     if (this->data.size() == 0)
                     {
-                        return 0;
+                        return image_statistics();
                     }
 
-                    return (std::accumulate(std::begin(this->data), std::end(this->data), 0.0) / this->data.size());
+                    return image_statistics::compute(&this->data[0], this->data.size(), threads);
                 }
 
-                //! returns the median of all the pixel values in the image 
-                //! Note: uses additional space of order O(n) where n is the number of total pixels
-                PixelType median() const
+                //! returns the mean value of all the pixels in image
+                double mean() const
                 {
-                    std::valarray<PixelType> soreted_array = this->data;
-                    std::nth_element(std::begin(soreted_array), std::begin(soreted_array) + soreted_array.size() / 2, std::end(soreted_array));
+                    return this->statistics().mean;
+                }
 
-                    return soreted_array[soreted_array.size() / 2];
+                //! returns the median of all the pixel values in the image (the upper one for even number of pixels)
+                //! Note: NaN pixels are ignored, uses no additional space proportional to the number of pixels
+                PixelType median(std::size_t threads = 0) const
+                {
+                    return this->percentile(50, threads);
                 }
 
-                //! returns the standard deviation of all the pixel values in the image 
-                //! Note: uses additional space of order O(n) where n is the number of total pixels
-                double std_dev() const
+                //! returns the pixel value at percentile q in [0, 100], which is the pixel of rank floor(q * n / 100)
+                //! among the n pixels in increasing order, throws invalid_percentile_exception for other values of q
+                PixelType percentile(double q, std::size_t threads = 0) const
                 {
-                    if (this->data.size() == 0)
-                    {
-                        return 0;
-                    }
+                    return this->percentiles(std::vector<double>(1, q), threads)[0];
+                }
 
-                    double avg = this->mean();
+                //! returns the pixel values at every percentile in q, all found by the same passes over the image
+                //! 8 and 16 bit images take one counting pass, wider pixel types a pass for every 16 bits
+                std::vector<PixelType> percentiles(std::vector<double> const& q, std::size_t threads = 0) const
+                {
+                    return boost::astronomy::detail::percentiles(this->raw_data(), this->data.size(), q, threads);
+                }
 
-                    std::valarray<double> diff(this->data.size());
-                    for (size_t i = 0; i < diff.size(); i++)
-                    {
-                        diff[i] = this->data[i] - avg;
-                    }
-                    
-                    diff *= diff;
-                    return std::sqrt(diff.sum() / (diff.size() - 1));
+                //! returns the standard deviation of all the pixel values in the image
+                double std_dev() const
+                {
+                    return this->statistics().std_dev();
                 }
 
                 PixelType operator() (std::size_t x, std::size_t y)
@@ -124,7 +381,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start) :
                     image_buffer<std::uint8_t>(width, height)
                 {   
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     image_file.seekg(start);
                     read_image_logic(image_file);
                     image_file.close();
@@ -133,7 +390,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height) :
                     image_buffer<std::uint8_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     read_image_logic(image_file);
                     image_file.close();
                 }
@@ -150,13 +407,14 @@ namespace boost
 
                 void read_image_logic(std::fstream &image_file)
                 {
-                    image_file.read((char*)std::begin(data), width*height);
-                    //std::copy_n(std::istreambuf_iterator<char>(file.rdbuf()), width*height, std::begin(data));
+                    this->read_data(image_file);
                 }
 
                 void read_image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     image_file.seekg(start);
 
@@ -172,6 +430,8 @@ namespace boost
 
                 void read_image(std::fstream &file, std::size_t width, std::size_t height, std::streamoff start)
                 {
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     file.seekg(start);
 
@@ -194,7 +454,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start) :
                     image_buffer<std::int16_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     image_file.seekg(start);
                     read_image_logic(image_file);
                     image_file.close();
@@ -203,7 +463,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height) :
                     image_buffer<std::int16_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     read_image_logic(image_file);
                     image_file.close();
                 }
@@ -220,17 +480,14 @@ namespace boost
 
                 void read_image_logic(std::fstream &image_file)
                 {
-                    for (std::size_t i = 0; i < height*width; i++)
-                    {
-                        image_file.read((char*)&data[i], 2);
-                        data[i] = boost::endian::big_to_native(data[i]);
-                    }
+                    this->read_data(image_file);
                 }
 
                 void read_image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start)
                 {
-                    std::fstream image_file(file);
-                    image_file.open(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     image_file.seekg(start);
 
@@ -246,6 +503,8 @@ namespace boost
 
                 void read_image(std::fstream &file, std::size_t width, std::size_t height, std::streamoff start)
                 {
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     file.seekg(start);
 
@@ -268,7 +527,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start) :
                     image_buffer<std::int32_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     image_file.seekg(start);
                     read_image_logic(image_file);
                     image_file.close();
@@ -277,7 +536,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height) :
                     image_buffer<std::int32_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     read_image_logic(image_file);
                     image_file.close();
                 }
@@ -294,17 +553,15 @@ namespace boost
 
                 void read_image_logic(std::fstream &image_file)
                 {
-                    for (std::size_t i = 0; i < height*width; i++)
-                    {
-                        image_file.read((char*)&data[i], 4);
-                        data[i] = boost::endian::big_to_native(data[i]);
-                    }
+                    this->read_data(image_file);
                 }
 
                 //!reads image
                 void read_image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     image_file.seekg(start);
 
@@ -320,6 +577,8 @@ namespace boost
 
                 void read_image(std::fstream &file, std::size_t width, std::size_t height, std::streamoff start)
                 {
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     file.seekg(start);
 
@@ -342,7 +601,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start) :
                     image_buffer<boost::float32_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     image_file.seekg(start);
                     read_image_logic(image_file);
                     image_file.close();
@@ -351,7 +610,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height) :
                     image_buffer<boost::float32_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     read_image_logic(image_file);
                     image_file.close();
                 }
@@ -368,18 +627,14 @@ namespace boost
 
                 void read_image_logic(std::fstream &image_file)
                 {
-                    pixel_data single_pixel;
-                    for (std::size_t i = 0; i < height*width; i++)
-                    {
-                        image_file.read((char*)single_pixel.byte, 4);
-                        data[i] = (single_pixel.byte[3] << 0) | (single_pixel.byte[2] << 8) |
-                            (single_pixel.byte[1] << 16) | (single_pixel.byte[0] << 24);
-                    }
+                    this->read_data(image_file);
                 }
 
                 void read_image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     image_file.seekg(start);
 
@@ -394,6 +649,8 @@ namespace boost
 
                 void read_image(std::fstream &file, std::size_t width, std::size_t height, std::streamoff start)
                 {
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     file.seekg(start);
 
@@ -416,7 +673,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start) :
                     image_buffer<boost::float64_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     image_file.seekg(start);
                     read_image_logic(image_file);
                     image_file.close();
@@ -425,7 +682,7 @@ namespace boost
                 image(std::string const& file, std::size_t width, std::size_t height) :
                     image_buffer<boost::float64_t>(width, height)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
                     read_image_logic(image_file);
                     image_file.close();
                 }
@@ -442,20 +699,14 @@ namespace boost
 
                 void read_image_logic(std::fstream &image_file)
                 {
-                    pixel_data single_pixel;
-                    for (std::size_t i = 0; i < height*width; i++)
-                    {
-                        image_file.read((char*)single_pixel.byte, 8);
-                        data[i] = (single_pixel.byte[7] << 0) | (single_pixel.byte[6] << 8) |
-                            (single_pixel.byte[5] << 16) | (single_pixel.byte[4] << 24) |
-                            (single_pixel.byte[3] << 32) | (single_pixel.byte[2] << 40) |
-                            (single_pixel.byte[1] << 48) | (single_pixel.byte[0] << 56);
-                    }
+                    this->read_data(image_file);
                 }
 
                 void read_image(std::string const& file, std::size_t width, std::size_t height, std::streamoff start)
                 {
-                    std::fstream image_file(file);
+                    std::fstream image_file(file, std::ios_base::in | std::ios_base::binary);
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     image_file.seekg(start);
 
@@ -471,6 +722,8 @@ namespace boost
 
                 void read_image(std::fstream &file, std::size_t width, std::size_t height, std::streamoff start)
                 {
+                    this->width = width;
+                    this->height = height;
                     data.resize(width*height);
                     file.seekg(start);
 
@@ -0,0 +1,397 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_BACKGROUND_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_BACKGROUND_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <boost/cstdfloat.hpp>
+
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/detail/sigma_clip.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!statistic taken as the background level of a box after sigma clipping
+            enum class background_statistic
+            {
+                median, //!median of the values kept
+                mode //!2.5 * median - 1.5 * mean of the values kept, the median if the box is crowded
+                     //!(the mean differs from the median by more than 0.3 standard deviations)
+            };
+
+            //!parameters of image_background
+            struct background_options
+            {
+                std::size_t box_width = 64; //!largest number of columns of a box of the mesh
+                std::size_t box_height = 64; //!largest number of rows of a box of the mesh
+                std::size_t filter_width = 3; //!boxes of the median filter along a row of the mesh (1 for none)
+                std::size_t filter_height = 3; //!boxes of the median filter along a column of the mesh (1 for none)
+                background_statistic statistic = background_statistic::mode;
+                double sigma = 3; //!clipping threshold in standard deviations around the median
+                std::size_t max_iterations = 10; //!maximum number of clipping iterations
+                double min_valid_fraction = 0.5; //!boxes with fewer values left (NaN pixels and clipped values)
+                                                 //!are replaced by the median of their neighbours
+                std::size_t threads = 0; //!number of threads (0 uses all hardware threads)
+            };
+
+            //!smooth estimate of the sky background and its noise: the image is divided in a mesh of boxes,
+            //!the sigma-clipped level and standard deviation of every box are median filtered over the mesh
+            //!and interpolated back to every pixel with a bicubic (Catmull-Rom) spline through the box centres
+            //!the boxes are spread evenly over the image, so their sizes differ by one pixel at most
+            class image_background
+            {
+            protected:
+                std::size_t width = 0;
+                std::size_t height = 0;
+                std::size_t mesh_width = 0;
+                std::size_t mesh_height = 0;
+                std::vector<boost::float32_t> level; //!background of every box, row by row
+                std::vector<boost::float32_t> rms; //!standard deviation of every box, row by row
+
+            public:
+                image_background() {}
+
+                //!estimates the background of frame, NaN pixels are left out
+                //!throws fits_exception for an empty image or box
+                template <typename PixelType>
+                explicit image_background(image_buffer<PixelType> const& frame,
+                    background_options const& options = background_options())
+                {
+                    this->estimate(frame, options);
+                }
+
+                //!estimates the background of frame, NaN pixels are left out
+                //!throws fits_exception for an empty image or box
+                template <typename PixelType>
+                void estimate(image_buffer<PixelType> const& frame, background_options const& options = background_options())
+                {
+                    if (frame.get_width() == 0 || frame.get_height() == 0 || options.box_width == 0 || options.box_height == 0)
+                    {
+                        throw boost::astronomy::fits_exception();
+                    }
+
+                    this->width = frame.get_width();
+                    this->height = frame.get_height();
+                    this->mesh_width = (this->width + options.box_width - 1) / options.box_width;
+                    this->mesh_height = (this->height + options.box_height - 1) / options.box_height;
+                    this->level.assign(this->mesh_width * this->mesh_height, 0);
+                    this->rms.assign(this->mesh_width * this->mesh_height, 0);
+
+                    PixelType const* pixels = frame.raw_data();
+                    std::vector<char> valid(this->level.size(), 0);
+                    boost::astronomy::detail::parallel_for(this->level.size(), [&](std::size_t box)
+                    {
+                        valid[box] = this->measure_box(pixels, box, options);
+                    }, options.threads);
+
+                    this->fill_invalid(valid);
+                    median_filter(this->level, this->mesh_width, this->mesh_height, options);
+                    median_filter(this->rms, this->mesh_width, this->mesh_height, options);
+                }
+
+                //!returns the number of boxes along a row of the mesh
+                std::size_t get_mesh_width() const
+                {
+                    return this->mesh_width;
+                }
+
+                //!returns the number of boxes along a column of the mesh
+                std::size_t get_mesh_height() const
+                {
+                    return this->mesh_height;
+                }
+
+                //!returns the filtered background of the box in row mesh_row and column mesh_column of the mesh
+                boost::float32_t level_at(std::size_t mesh_row, std::size_t mesh_column) const
+                {
+                    return this->level[mesh_row * this->mesh_width + mesh_column];
+                }
+
+                //!returns the filtered standard deviation of the box in row mesh_row and column mesh_column of the mesh
+                boost::float32_t rms_at(std::size_t mesh_row, std::size_t mesh_column) const
+                {
+                    return this->rms[mesh_row * this->mesh_width + mesh_column];
+                }
+
+                //!returns the background of every pixel, interpolated by up to threads threads (0 uses all hardware threads)
+                image_buffer<boost::float32_t> get_background(std::size_t threads = 0) const
+                {
+                    return this->interpolate(this->level, threads);
+                }
+
+                //!returns the background noise of every pixel, interpolated by up to threads threads
+                image_buffer<boost::float32_t> get_rms(std::size_t threads = 0) const
+                {
+                    return this->interpolate(this->rms, threads);
+                }
+
+            protected:
+                //!sigma clips the pixels of a box, returns false if too few values are left
+                template <typename PixelType>
+                bool measure_box(PixelType const* pixels, std::size_t box, background_options const& options)
+                {
+                    std::size_t const mesh_row = box / this->mesh_width, mesh_column = box % this->mesh_width;
+                    std::size_t const first_row = box_start(mesh_row, this->height, this->mesh_height);
+                    std::size_t const first_column = box_start(mesh_column, this->width, this->mesh_width);
+                    std::size_t const rows = box_start(mesh_row + 1, this->height, this->mesh_height) - first_row;
+                    std::size_t const columns = box_start(mesh_column + 1, this->width, this->mesh_width) - first_column;
+
+                    std::vector<boost::float32_t> values;
+                    values.reserve(rows * columns);
+                    for (std::size_t row = first_row; row < first_row + rows; row++)
+                    {
+                        PixelType const* pixel = pixels + row * this->width + first_column;
+                        for (std::size_t column = 0; column < columns; column++)
+                        {
+                            boost::float32_t const value = static_cast<boost::float32_t>(pixel[column]);
+                            if (!std::isnan(value))
+                            {
+                                values.push_back(value);
+                            }
+                        }
+                    }
+
+                    boost::float32_t* first = values.data();
+                    boost::float32_t* last = values.data() + values.size();
+                    boost::astronomy::detail::clipped_statistics const kept = boost::astronomy::detail::sigma_clip_unsorted(
+                        first, last, options.sigma, options.sigma, options.max_iterations);
+                    if (kept.count == 0 ||
+                        static_cast<double>(kept.count) < options.min_valid_fraction * static_cast<double>(rows * columns))
+                    {
+                        return false;
+                    }
+
+                    double background = kept.median;
+                    if (options.statistic == background_statistic::mode &&
+                        std::abs(kept.mean - kept.median) <= 0.3 * kept.sigma)
+                    {
+                        background = 2.5 * kept.median - 1.5 * kept.mean;
+                    }
+                    this->level[box] = static_cast<boost::float32_t>(background);
+                    this->rms[box] = static_cast<boost::float32_t>(kept.sigma);
+                    return true;
+                }
+
+                //!replaces every invalid box by the median of its valid neighbours, growing the valid region
+                //!one box at a time, the mesh is 0 if no box is valid
+                void fill_invalid(std::vector<char>& valid)
+                {
+                    std::vector<boost::float32_t> levels, deviations;
+                    std::vector<std::size_t> filled;
+                    bool any_invalid = true;
+                    while (any_invalid)
+                    {
+                        any_invalid = false;
+                        filled.clear();
+                        for (std::size_t box = 0; box < valid.size(); box++)
+                        {
+                            if (valid[box])
+                            {
+                                continue;
+                            }
+                            any_invalid = true;
+
+                            std::size_t const row = box / this->mesh_width, column = box % this->mesh_width;
+                            levels.clear();
+                            deviations.clear();
+                            for (std::size_t r = (row == 0 ? 0 : row - 1); r <= row + 1 && r < this->mesh_height; r++)
+                            {
+                                for (std::size_t c = (column == 0 ? 0 : column - 1); c <= column + 1 && c < this->mesh_width; c++)
+                                {
+                                    if (valid[r * this->mesh_width + c])
+                                    {
+                                        levels.push_back(this->level[r * this->mesh_width + c]);
+                                        deviations.push_back(this->rms[r * this->mesh_width + c]);
+                                    }
+                                }
+                            }
+                            if (!levels.empty())
+                            {
+                                this->level[box] = median_of(levels);
+                                this->rms[box] = median_of(deviations);
+                                filled.push_back(box);
+                            }
+                        }
+
+                        if (any_invalid && filled.empty())
+                        {
+                            return;
+                        }
+                        for (std::size_t box : filled)
+                        {
+                            valid[box] = 1;
+                        }
+                    }
+                }
+
+                //!median of the boxes in a filter_width x filter_height window centred on every box of the mesh
+                //!the window is cut at the edges of the mesh
+                static void median_filter(std::vector<boost::float32_t>& mesh, std::size_t columns, std::size_t rows,
+                    background_options const& options)
+                {
+                    std::size_t const half_width = options.filter_width / 2, half_height = options.filter_height / 2;
+                    if (half_width == 0 && half_height == 0)
+                    {
+                        return;
+                    }
+
+                    std::vector<boost::float32_t> const source = mesh;
+                    std::vector<boost::float32_t> window;
+                    for (std::size_t row = 0; row < rows; row++)
+                    {
+                        for (std::size_t column = 0; column < columns; column++)
+                        {
+                            window.clear();
+                            std::size_t const last_row = (std::min)(rows - 1, row + half_height);
+                            std::size_t const last_column = (std::min)(columns - 1, column + half_width);
+                            for (std::size_t r = (row < half_height ? 0 : row - half_height); r <= last_row; r++)
+                            {
+                                for (std::size_t c = (column < half_width ? 0 : column - half_width); c <= last_column; c++)
+                                {
+                                    window.push_back(source[r * columns + c]);
+                                }
+                            }
+                            mesh[row * columns + column] = median_of(window);
+                        }
+                    }
+                }
+
+                //!mean of the two middle values for an even count, values are reordered
+                static boost::float32_t median_of(std::vector<boost::float32_t>& values)
+                {
+                    std::size_t const middle = values.size() / 2;
+                    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle), values.end());
+                    if (values.size() % 2 == 1)
+                    {
+                        return values[middle];
+                    }
+                    double const lower = *std::max_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle));
+                    return static_cast<boost::float32_t>((lower + values[middle]) / 2);
+                }
+
+                //!returns the first pixel of box number box of the boxes spread over size pixels
+                static std::size_t box_start(std::size_t box, std::size_t size, std::size_t boxes)
+                {
+                    return box * size / boxes;
+                }
+
+                //!taps of the cubic spline at every output position along an axis of size pixels with a node
+                //!at the centre of every box
+                struct spline_taps
+                {
+                    std::vector<std::size_t> index; //!4 node indices for every position
+                    std::vector<boost::float32_t> weight; //!4 weights for every position
+
+                    spline_taps(std::size_t size, std::size_t nodes) : index(4 * size), weight(4 * size)
+                    {
+                        std::size_t node = 0;
+                        for (std::size_t i = 0; i < size; i++)
+                        {
+                            //the background is constant beyond the first and the last node
+                            double const position = static_cast<double>(i) + 0.5;
+                            while (node + 2 < nodes && centre(node + 1, size, nodes) <= position)
+                            {
+                                node++;
+                            }
+                            double t = 0;
+                            if (nodes > 1)
+                            {
+                                double const left = centre(node, size, nodes), right = centre(node + 1, size, nodes);
+                                t = (std::max)(0.0, (std::min)(1.0, (position - left) / (right - left)));
+                            }
+
+                            double cubic[4] = {((2 - t) * t - 1) * t / 2, ((3 * t - 5) * t * t + 2) / 2,
+                                ((4 - 3 * t) * t + 1) * t / 2, (t - 1) * t * t / 2};
+                            //the nodes beyond the ends are extrapolated linearly (2 * end - next to end),
+                            //so a tilted background stays straight up to the last node
+                            if (node == 0 && nodes > 1)
+                            {
+                                cubic[1] += 2 * cubic[0];
+                                cubic[2] -= cubic[0];
+                                cubic[0] = 0;
+                            }
+                            if (node + 2 == nodes)
+                            {
+                                cubic[2] += 2 * cubic[3];
+                                cubic[1] -= cubic[3];
+                                cubic[3] = 0;
+                            }
+                            for (std::size_t k = 0; k < 4; k++)
+                            {
+                                std::size_t const tap = node + k;
+                                this->index[4 * i + k] = tap == 0 ? 0 : (std::min)(tap - 1, nodes - 1);
+                                this->weight[4 * i + k] = static_cast<boost::float32_t>(cubic[k]);
+                            }
+                        }
+                    }
+
+                    static double centre(std::size_t box, std::size_t size, std::size_t boxes)
+                    {
+                        return static_cast<double>(box_start(box, size, boxes) + box_start(box + 1, size, boxes)) / 2;
+                    }
+                };
+
+                //!interpolates mesh to every pixel in two separable passes: every mesh row is interpolated
+                //!along the columns, then every image row is a weighted sum of 4 of those rows
+                //!which is a straight loop over contiguous memory that the compiler vectorizes
+                image_buffer<boost::float32_t> interpolate(std::vector<boost::float32_t> const& mesh, std::size_t threads) const
+                {
+                    image_buffer<boost::float32_t> result(this->width, this->height);
+                    if (mesh.empty())
+                    {
+                        return result;
+                    }
+
+                    spline_taps const across(this->width, this->mesh_width);
+                    spline_taps const down(this->height, this->mesh_height);
+
+                    std::vector<boost::float32_t> rows(this->mesh_height * this->width);
+                    boost::astronomy::detail::parallel_for(this->mesh_height, [&](std::size_t mesh_row)
+                    {
+                        boost::float32_t const* nodes = mesh.data() + mesh_row * this->mesh_width;
+                        boost::float32_t* output = rows.data() + mesh_row * this->width;
+                        for (std::size_t x = 0; x < this->width; x++)
+                        {
+                            std::size_t const* index = &across.index[4 * x];
+                            boost::float32_t const* weight = &across.weight[4 * x];
+                            output[x] = weight[0] * nodes[index[0]] + weight[1] * nodes[index[1]] +
+                                weight[2] * nodes[index[2]] + weight[3] * nodes[index[3]];
+                        }
+                    }, threads);
+
+                    boost::float32_t* output = result.raw_data();
+                    std::size_t const part_rows = (std::max)(std::size_t(1), (std::size_t(1) << 18) / this->width);
+                    boost::astronomy::detail::parallel_for((this->height + part_rows - 1) / part_rows, [&](std::size_t part)
+                    {
+                        std::size_t const last_row = (std::min)(this->height, (part + 1) * part_rows);
+                        for (std::size_t y = part * part_rows; y < last_row; y++)
+                        {
+                            boost::float32_t const* row0 = rows.data() + down.index[4 * y] * this->width;
+                            boost::float32_t const* row1 = rows.data() + down.index[4 * y + 1] * this->width;
+                            boost::float32_t const* row2 = rows.data() + down.index[4 * y + 2] * this->width;
+                            boost::float32_t const* row3 = rows.data() + down.index[4 * y + 3] * this->width;
+                            boost::float32_t const w0 = down.weight[4 * y], w1 = down.weight[4 * y + 1];
+                            boost::float32_t const w2 = down.weight[4 * y + 2], w3 = down.weight[4 * y + 3];
+                            boost::float32_t* out = output + y * this->width;
+                            for (std::size_t x = 0; x < this->width; x++)
+                            {
+                                out[x] = w0 * row0[x] + w1 * row1[x] + w2 * row2[x] + w3 * row3[x];
+                            }
+                        }
+                    }, threads);
+                    return result;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_BACKGROUND_HPP
@@ -0,0 +1,361 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_CUBE_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_CUBE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <boost/astronomy/detail/byteswap.hpp>
+#include <boost/astronomy/detail/hyperslab.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+#include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!strided view of the pixels of an N dimensional image, axis 0 is NAXIS1 (the fastest varying axis of
+            //!a data unit), the view does not own the pixels and slicing or selecting a range of any axis only changes
+            //!the first pixel, the shape and the strides so nothing is copied
+            //!PixelType is const for read only views
+            template <typename PixelType>
+            class cube_view
+            {
+            public:
+                typedef typename std::remove_const<PixelType>::type pixel_type;
+
+            protected:
+                PixelType* origin; //!first pixel of the view
+                std::vector<std::size_t> shape; //!number of pixels along every axis
+                std::vector<std::ptrdiff_t> strides; //!distance in pixels between neighbours along every axis
+
+            public:
+                cube_view() : origin(nullptr) {}
+
+                //!view of contiguous pixels stored with axis 0 varying fastest
+                cube_view(PixelType* first_pixel, std::vector<std::size_t> const& view_shape) :
+                    origin(first_pixel), shape(view_shape), strides(view_shape.size(), 1)
+                {
+                    for (std::size_t axis = 1; axis < this->shape.size(); axis++)
+                    {
+                        this->strides[axis] = this->strides[axis - 1] * static_cast<std::ptrdiff_t>(this->shape[axis - 1]);
+                    }
+                }
+
+                cube_view(PixelType* first_pixel, std::vector<std::size_t> const& view_shape,
+                    std::vector<std::ptrdiff_t> const& view_strides) :
+                    origin(first_pixel), shape(view_shape), strides(view_strides) {}
+
+                //!read only view of the pixels of a writable view
+                template <typename OtherPixel, typename = typename std::enable_if<
+                    std::is_same<OtherPixel const, PixelType>::value && !std::is_same<OtherPixel, PixelType>::value>::type>
+                cube_view(cube_view<OtherPixel> const& other) :
+                    origin(other.data()), shape(other.get_shape()), strides(other.get_strides()) {}
+
+                //!returns the number of axis
+                std::size_t rank() const
+                {
+                    return this->shape.size();
+                }
+
+                //!returns the number of pixels along every axis
+                std::vector<std::size_t> const& get_shape() const
+                {
+                    return this->shape;
+                }
+
+                //!returns the distance in pixels between neighbours along every axis
+                std::vector<std::ptrdiff_t> const& get_strides() const
+                {
+                    return this->strides;
+                }
+
+                //!returns total number of pixels
+                std::size_t size() const
+                {
+                    return boost::astronomy::detail::element_count(this->shape);
+                }
+
+                //!returns the first pixel of the view
+                PixelType* data() const
+                {
+                    return this->origin;
+                }
+
+                //!returns the pixel at index (one coordinate per axis, axis 0 first), index is not checked
+                PixelType& operator() (std::vector<std::size_t> const& index) const
+                {
+                    std::ptrdiff_t position = 0;
+                    for (std::size_t axis = 0; axis < index.size(); axis++)
+                    {
+                        position += static_cast<std::ptrdiff_t>(index[axis]) * this->strides[axis];
+                    }
+                    return this->origin[position];
+                }
+
+                //!returns the view of the hyperplane at index along axis, which is removed from the shape
+                //!(e.g. slice(2, k) is plane k of a spectral cube and slice(0, x).slice(0, y) the spectrum of pixel (x, y))
+                cube_view slice(std::size_t axis, std::size_t index) const
+                {
+                    if (axis >= this->shape.size() || index >= this->shape[axis])
+                    {
+                        throw region_out_of_range_exception();
+                    }
+
+                    cube_view result(this->origin + static_cast<std::ptrdiff_t>(index) * this->strides[axis],
+                        this->shape, this->strides);
+                    result.shape.erase(result.shape.begin() + static_cast<std::ptrdiff_t>(axis));
+                    result.strides.erase(result.strides.begin() + static_cast<std::ptrdiff_t>(axis));
+                    return result;
+                }
+
+                //!returns the view of count pixels starting at first along axis, the rank is kept
+                cube_view range(std::size_t axis, std::size_t first, std::size_t count) const
+                {
+                    if (axis >= this->shape.size() || first > this->shape[axis] || count > this->shape[axis] - first)
+                    {
+                        throw region_out_of_range_exception();
+                    }
+
+                    cube_view result(this->origin + static_cast<std::ptrdiff_t>(first) * this->strides[axis],
+                        this->shape, this->strides);
+                    result.shape[axis] = count;
+                    return result;
+                }
+
+                //!returns the view of the hyperslab which starts at first and has count pixels along every axis
+                cube_view hyperslab(std::vector<std::size_t> const& first, std::vector<std::size_t> const& count) const
+                {
+                    boost::astronomy::detail::check_hyperslab(this->shape, first, count);
+                    cube_view result(*this);
+                    for (std::size_t axis = 0; axis < this->shape.size(); axis++)
+                    {
+                        result.origin += static_cast<std::ptrdiff_t>(first[axis]) * this->strides[axis];
+                        result.shape[axis] = count[axis];
+                    }
+                    return result;
+                }
+
+                //!true if the pixels of the view are stored contiguously with axis 0 varying fastest
+                bool is_contiguous() const
+                {
+                    std::ptrdiff_t expected = 1;
+                    for (std::size_t axis = 0; axis < this->shape.size(); axis++)
+                    {
+                        if (this->shape[axis] != 1 && this->strides[axis] != expected)
+                        {
+                            return false;
+                        }
+                        expected *= static_cast<std::ptrdiff_t>(this->shape[axis]);
+                    }
+                    return true;
+                }
+
+                //!copies the size() pixels of the view to output with axis 0 varying fastest
+                void copy_to(pixel_type* output) const
+                {
+                    if (size() == 0)
+                    {
+                        return;
+                    }
+                    if (is_contiguous())
+                    {
+                        std::memcpy(output, this->origin, size() * sizeof(pixel_type));
+                        return;
+                    }
+
+                    std::size_t const rank = this->shape.size();
+                    std::size_t const width = this->shape[0];
+                    std::ptrdiff_t const step = this->strides[0];
+                    std::vector<std::size_t> index(rank, 0);
+                    PixelType* row = this->origin;
+                    while (true)
+                    {
+                        for (std::size_t i = 0; i < width; i++)
+                        {
+                            output[i] = row[static_cast<std::ptrdiff_t>(i) * step];
+                        }
+                        output += width;
+
+                        std::size_t axis = 1;
+                        while (axis < rank && ++index[axis] == this->shape[axis])
+                        {
+                            row -= static_cast<std::ptrdiff_t>(this->shape[axis] - 1) * this->strides[axis];
+                            index[axis] = 0;
+                            axis++;
+                        }
+                        if (axis >= rank)
+                        {
+                            return;
+                        }
+                        row += this->strides[axis];
+                    }
+                }
+            };
+
+            //!N dimensional image stored contiguously in native byte order with axis 0 (NAXIS1) varying fastest
+            //!as in the data unit, so that cubes are not folded into 2 dimensional images
+            template <bitpix DataType>
+            class image_cube
+            {
+            public:
+                typedef typename image<DataType>::pixel_type pixel_type;
+
+            protected:
+                std::vector<pixel_type> data; //!stores the pixels
+                std::vector<std::size_t> shape; //!number of pixels along every axis
+
+            public:
+                image_cube() {}
+
+                //!creates a cube of cube_shape filled with zeros
+                explicit image_cube(std::vector<std::size_t> const& cube_shape) :
+                    data(boost::astronomy::detail::element_count(cube_shape)), shape(cube_shape) {}
+
+                //!returns the number of axis
+                std::size_t rank() const
+                {
+                    return this->shape.size();
+                }
+
+                //!returns the number of pixels along every axis
+                std::vector<std::size_t> const& get_shape() const
+                {
+                    return this->shape;
+                }
+
+                //!returns total number of pixels
+                std::size_t size() const
+                {
+                    return this->data.size();
+                }
+
+                //!returns pointer to the first pixel
+                pixel_type const* raw_data() const
+                {
+                    return this->data.empty() ? nullptr : this->data.data();
+                }
+
+                //!returns pointer to the first pixel for writing the pixels directly
+                pixel_type* raw_data()
+                {
+                    return this->data.empty() ? nullptr : this->data.data();
+                }
+
+                //!returns the pixel at index (one coordinate per axis, axis 0 first)
+                pixel_type operator() (std::vector<std::size_t> const& index) const
+                {
+                    return get_view()(index);
+                }
+
+                //!returns a reference to the pixel at index
+                pixel_type& operator() (std::vector<std::size_t> const& index)
+                {
+                    return get_view()(index);
+                }
+
+                //!returns the view of all the pixels
+                cube_view<pixel_type const> get_view() const
+                {
+                    return cube_view<pixel_type const>(raw_data(), this->shape);
+                }
+
+                //!returns the view of all the pixels for writing
+                cube_view<pixel_type> get_view()
+                {
+                    return cube_view<pixel_type>(raw_data(), this->shape);
+                }
+
+                //!returns the view of the hyperplane at index along axis (see cube_view::slice())
+                cube_view<pixel_type const> slice(std::size_t axis, std::size_t index) const
+                {
+                    return get_view().slice(axis, index);
+                }
+
+                //!changes the shape without moving pixels, throws fits_exception if the number of pixels changes
+                void reshape(std::vector<std::size_t> const& cube_shape)
+                {
+                    if (boost::astronomy::detail::element_count(cube_shape) != this->data.size())
+                    {
+                        throw fits_exception();
+                    }
+                    this->shape = cube_shape;
+                }
+
+                //!copies the pixels of source (e.g. a slice of another cube), the cube gets the shape of source
+                void assign(cube_view<pixel_type const> const& source)
+                {
+                    this->shape = source.get_shape();
+                    this->data.resize(source.size());
+                    source.copy_to(raw_data());
+                }
+
+                //!copies the hyperslab which starts at first and has count pixels along every axis of a big-endian
+                //!image of image_shape stored in memory (e.g. a mapped file), only the pixels of the hyperslab are touched
+                void assign_big_endian(char const* bytes, std::vector<std::size_t> const& image_shape,
+                    std::vector<std::size_t> const& first, std::vector<std::size_t> const& count)
+                {
+                    read_hyperslab(image_shape, first, count,
+                        [&](std::size_t source, std::size_t destination, std::size_t length)
+                    {
+                        std::memcpy(&this->data[destination], bytes + source * sizeof(pixel_type), length * sizeof(pixel_type));
+                    });
+                }
+
+                //!reads the hyperslab of a big-endian image of image_shape stored at offset of file with one positional
+                //!read per run of contiguous pixels, so a plane of a cube is one read and the spectrum of a pixel reads
+                //!one pixel per plane, any number of cubes can be read from the same file by different threads at the same time
+                void assign_big_endian(boost::astronomy::detail::positional_file const& file, std::uint64_t offset,
+                    std::vector<std::size_t> const& image_shape,
+                    std::vector<std::size_t> const& first, std::vector<std::size_t> const& count)
+                {
+                    read_hyperslab(image_shape, first, count,
+                        [&](std::size_t source, std::size_t destination, std::size_t length)
+                    {
+                        file.read(reinterpret_cast<char*>(&this->data[destination]), length * sizeof(pixel_type),
+                            offset + static_cast<std::uint64_t>(source) * sizeof(pixel_type));
+                    });
+                }
+
+                //!returns the pixels as a 2 dimensional image of NAXIS1 x (NAXIS2 * ... * NAXISn) pixels
+                image<DataType> to_image() const
+                {
+                    image<DataType> result;
+                    std::size_t const width = this->shape.empty() ? 0 : this->shape[0];
+                    std::size_t const height = width == 0 ? 0 : this->data.size() / width;
+                    result.set_size(width, height);
+                    if (!this->data.empty())
+                    {
+                        std::memcpy(result.raw_data(), raw_data(), this->data.size() * sizeof(pixel_type));
+                    }
+                    return result;
+                }
+
+            protected:
+                //!sets the shape to count and copies every run of the hyperslab with copy_run as big-endian pixels,
+                //!all the pixels are converted to native byte order together at the end
+                template <typename CopyRun>
+                void read_hyperslab(std::vector<std::size_t> const& image_shape, std::vector<std::size_t> const& first,
+                    std::vector<std::size_t> const& count, CopyRun copy_run)
+                {
+                    boost::astronomy::detail::check_hyperslab(image_shape, first, count);
+                    this->shape = count;
+                    this->data.resize(boost::astronomy::detail::element_count(count));
+                    boost::astronomy::detail::for_each_run(image_shape, first, count, copy_run);
+                    if (!this->data.empty())
+                    {
+                        boost::astronomy::detail::big_to_native_inplace(this->data.data(), this->data.size());
+                    }
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_CUBE_HPP
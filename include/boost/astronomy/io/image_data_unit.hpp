@@ -0,0 +1,321 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_DATA_UNIT_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_DATA_UNIT_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+
+#include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/hdu.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/image_cube.hpp>
+#include <boost/astronomy/io/image_view.hpp>
+#include <boost/astronomy/io/image_stream.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
+#include <boost/astronomy/io/pixel_conversion.hpp>
+#include <boost/astronomy/io/value_scaling.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!image data unit of primary_hdu and image_extension: the image is read with the header, accessed through
+            //!a mapped file or read on demand from file_path, Hdu is the HDU class deriving from it (CRTP) whose header
+            //!gives the shape and the scaling of the image
+            template <typename Hdu, bitpix DataType>
+            struct image_data_unit
+            {
+            protected:
+                mutable image<DataType> data; //!stores the image if it is in memory
+                image_view<DataType> view; //!view of the image inside the mapped file if the HDU is mapped
+                bool mapped = false; //!true if the image is accessed through view
+                std::string file_path; //!file from which the image is read on first access if the HDU is deferred
+                std::size_t data_offset = 0; //!position of data unit in file_path
+                mutable bool loaded = true; //!false until the image of a deferred HDU is read
+
+                image_data_unit() {}
+
+                //!the image is accessed in the mapped file, offset is the position of data unit in the file
+                image_data_unit(std::shared_ptr<mapped_file const> const& file, std::size_t offset, hdu const& header) :
+                    view(file, offset, header.image_width(), header.image_height()), mapped(true) {}
+
+                //!the image is read on demand, offset is the position of data unit in path
+                image_data_unit(std::string const& path, std::size_t offset, hdu const& header) :
+                    file_path(path), data_offset(offset), loaded(header.data_size() == 0) {}
+
+                Hdu& header()
+                {
+                    return static_cast<Hdu&>(*this);
+                }
+
+                Hdu const& header() const
+                {
+                    return static_cast<Hdu const&>(*this);
+                }
+
+                //!reads the image from the current position of file according to the dimensions given by NAXISn
+                void read_data_unit(std::fstream &file)
+                {
+                    switch (header().naxis())
+                    {
+                    case 0:
+                        break;
+                    case 1:
+                        data.read_image(file, header().naxis(1), 1);
+                        break;
+                    case 2:
+                        data.read_image(file, header().naxis(1), header().naxis(2));
+                        break;
+                    default:
+                        data.read_image(file, header().naxis(1), header().image_height());
+                        break;
+                    }
+                }
+
+            public:
+                //!returnes the stored data
+                //!if HDU is mapped then the image is converted from the mapped file on every call
+                //!if HDU is deferred then the image is read from file on the first call
+                image<DataType> get_data() const
+                {
+                    if (this->mapped)
+                    {
+                        return this->view.to_image();
+                    }
+                    load_data();
+                    return this->data;
+                }
+
+                //!returns the physical values of the image (BSCALE * stored + BZERO, BLANK pixels are NaN) as Physical pixels
+                //!Physical is float or double, or an integer type of the size of the stored values when BZERO is an offset
+                //!such as 32768 for std::uint16_t (see value_scaling::apply()), throws fits_exception for other types
+                //!mapped HDUs and deferred HDUs not loaded yet are scaled in the pass converting the byte order
+                template <typename Physical>
+                image_buffer<Physical> get_physical_data() const
+                {
+                    typedef typename image<DataType>::pixel_type stored_type;
+                    value_scaling const scaling = header().get_scaling();
+                    image_buffer<Physical> result;
+                    if (this->mapped)
+                    {
+                        result.template assign_physical<stored_type>(this->view.raw_data(), header().image_width(),
+                            header().image_height(), scaling);
+                    }
+                    else if (!this->loaded)
+                    {
+                        boost::astronomy::detail::positional_file file(this->file_path);
+                        result.template assign_physical<stored_type>(file, this->data_offset, header().image_width(),
+                            header().image_height(), scaling);
+                    }
+                    else
+                    {
+                        result.assign_physical(this->data, scaling);
+                    }
+                    return result;
+                }
+
+                //!returns the stored values of the image converted to the pixels of Target, e.g. get_data_as<_B32>() of a B16
+                //!image (see convert_pixels() for saturation and rounding, BSCALE and BZERO are applied by get_physical_data())
+                //!mapped HDUs and deferred HDUs not loaded yet are decoded straight into Target by up to threads threads
+                template <bitpix Target>
+                image<Target> get_data_as(rounding_policy rounding = rounding_policy::nearest, std::size_t threads = 0) const
+                {
+                    typedef typename image<DataType>::pixel_type stored_type;
+                    image<Target> result;
+                    if (this->mapped)
+                    {
+                        result.template assign_converted<stored_type>(this->view.raw_data(), header().image_width(),
+                            header().image_height(), rounding, threads);
+                    }
+                    else if (!this->loaded)
+                    {
+                        boost::astronomy::detail::positional_file file(this->file_path);
+                        result.template assign_converted<stored_type>(file, this->data_offset, header().image_width(),
+                            header().image_height(), rounding, threads);
+                    }
+                    else
+                    {
+                        result.assign_converted(this->data, rounding, threads);
+                    }
+                    return result;
+                }
+
+                //!reads the image of a deferred HDU if it is not read yet
+                void load_data() const
+                {
+                    if (!this->loaded)
+                    {
+                        this->data.read_image(this->file_path, header().image_width(), header().image_height(),
+                            static_cast<std::streamoff>(this->data_offset));
+                        this->loaded = true;
+                    }
+                }
+
+                //!reads the image of a deferred HDU using positional reads on file if it is not read yet
+                //!different HDUs can be loaded from the same file by different threads at the same time
+                void load_data(boost::astronomy::detail::positional_file const& file) const
+                {
+                    if (!this->loaded)
+                    {
+                        this->data.assign_big_endian(file, this->data_offset, header().image_width(), header().image_height());
+                        this->loaded = true;
+                    }
+                }
+
+                //!returns the region of image which starts at (x, y) (x is the row and y the column as in image_buffer::operator())
+                //!if the image is not in memory then only the pixels (mapped) or rows (deferred) of the region are read and converted
+                image<DataType> get_region(std::size_t x, std::size_t y, std::size_t region_width, std::size_t region_height) const
+                {
+                    if (this->mapped || this->loaded)
+                    {
+                        return region_in_memory(x, y, region_width, region_height);
+                    }
+
+                    boost::astronomy::detail::positional_file file(this->file_path);
+                    return get_region(file, x, y, region_width, region_height);
+                }
+
+                //!same as get_region(x, y, region_width, region_height) but rows of a deferred HDU are read from file
+                //!which should be opened once when many regions are read
+                image<DataType> get_region(boost::astronomy::detail::positional_file const& file,
+                    std::size_t x, std::size_t y, std::size_t region_width, std::size_t region_height) const
+                {
+                    if (this->mapped || this->loaded)
+                    {
+                        return region_in_memory(x, y, region_width, region_height);
+                    }
+
+                    image<DataType> result;
+                    result.assign_region_big_endian(file, this->data_offset, header().image_width(), header().image_height(),
+                        x, y, region_width, region_height);
+                    return result;
+                }
+
+                //!returns a stream which reads the image of a deferred HDU as strips of strip_height rows
+                //!so that images larger than the memory can be processed, throws fits_exception for other HDUs
+                std::unique_ptr<image_stream<DataType>> get_stream(std::size_t strip_height, bool prefetch = true) const
+                {
+                    if (this->file_path.empty())
+                    {
+                        throw fits_exception();
+                    }
+                    return std::unique_ptr<image_stream<DataType>>(new image_stream<DataType>(this->file_path, this->data_offset,
+                        header().image_width(), header().image_height(), strip_height, prefetch));
+                }
+
+                //!returns the hyperslab of the N dimensional image which starts at first and has count pixels along
+                //!every axis (axis 0 is NAXIS1), e.g. first = {x, y, 0} and count = {1, 1, NAXIS3} for the spectrum of
+                //!pixel (x, y) of a spectral cube, if the image is not in memory then only the hyperslab is read and converted
+                image_cube<DataType> get_cube(std::vector<std::size_t> const& first, std::vector<std::size_t> const& count) const
+                {
+                    if (this->mapped || this->loaded)
+                    {
+                        return cube_in_memory(first, count);
+                    }
+
+                    boost::astronomy::detail::positional_file file(this->file_path);
+                    return get_cube(file, first, count);
+                }
+
+                //!same as get_cube(first, count) but the hyperslab of a deferred HDU is read from file
+                //!which should be opened once when many hyperslabs are read
+                image_cube<DataType> get_cube(boost::astronomy::detail::positional_file const& file,
+                    std::vector<std::size_t> const& first, std::vector<std::size_t> const& count) const
+                {
+                    if (this->mapped || this->loaded)
+                    {
+                        return cube_in_memory(first, count);
+                    }
+
+                    image_cube<DataType> result;
+                    result.assign_big_endian(file, this->data_offset, header().get_shape(), first, count);
+                    return result;
+                }
+
+                //!returns the whole image with the shape NAXIS1 x NAXIS2 x ... x NAXISn
+                image_cube<DataType> get_cube() const
+                {
+                    std::vector<std::size_t> const shape = header().get_shape();
+                    return get_cube(std::vector<std::size_t>(shape.size(), 0), shape);
+                }
+
+                //!returns the hyperplane at index along axis, which is removed from the shape
+                //!(e.g. get_slice(2, k) is plane k of a spectral cube), only the pixels of the hyperplane are read
+                //!the slice of a one dimensional image is its pixel at index with the shape {1}
+                image_cube<DataType> get_slice(std::size_t axis, std::size_t index) const
+                {
+                    std::vector<std::size_t> shape = header().get_shape();
+                    if (axis >= shape.size())
+                    {
+                        throw region_out_of_range_exception();
+                    }
+
+                    std::vector<std::size_t> first(shape.size(), 0);
+                    first[axis] = index;
+                    shape[axis] = 1;
+                    image_cube<DataType> result = get_cube(first, shape);
+                    if (shape.size() > 1)
+                    {
+                        shape.erase(shape.begin() + static_cast<std::ptrdiff_t>(axis));
+                        result.reshape(shape);
+                    }
+                    return result;
+                }
+
+                //!false if the image of a deferred HDU has not been read yet
+                bool is_loaded() const
+                {
+                    return this->loaded;
+                }
+
+                //!returns the view of image inside the mapped file (empty view if HDU is not mapped)
+                image_view<DataType> get_view() const
+                {
+                    return this->view;
+                }
+
+                //!true if image is accessed from a mapped file
+                bool is_mapped() const
+                {
+                    return this->mapped;
+                }
+
+            protected:
+                image<DataType> region_in_memory(std::size_t x, std::size_t y, std::size_t region_width, std::size_t region_height) const
+                {
+                    if (this->mapped)
+                    {
+                        return this->view.region(x, y, region_width, region_height);
+                    }
+
+                    image<DataType> result;
+                    result.assign_region(this->data, x, y, region_width, region_height);
+                    return result;
+                }
+
+                image_cube<DataType> cube_in_memory(std::vector<std::size_t> const& first, std::vector<std::size_t> const& count) const
+                {
+                    image_cube<DataType> result;
+                    if (this->mapped)
+                    {
+                        result.assign_big_endian(this->view.raw_data(), header().get_shape(), first, count);
+                        return result;
+                    }
+
+                    typedef typename image<DataType>::pixel_type pixel_type;
+                    cube_view<pixel_type const> whole(this->data.raw_data(), header().get_shape());
+                    result.assign(whole.hyperslab(first, count));
+                    return result;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_DATA_UNIT_HPP
@@ -0,0 +1,440 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_EXPRESSION_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_EXPRESSION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <boost/astronomy/detail/convert_pixels.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!base of the nodes of lazy image expressions such as (raw - bias - t * dark) / flat
+            //!building an expression only records its operands, every pixel is computed once by evaluate()
+            //!in one pass over the images without intermediate images
+            //!nodes refer to the pixels of the images, which must outlive the expression
+            struct image_expression_base
+            {
+                bool sized = false; //!false if the expression has no image (a scalar), it then fits any size
+                std::size_t width = 0; //!width of the images of the expression
+                std::size_t height = 0; //!height of the images of the expression
+
+            protected:
+                //!takes the size of the operands, throws image_size_mismatch_exception if two images differ
+                void set_size(image_expression_base const& left, image_expression_base const& right)
+                {
+                    if (left.sized && right.sized && (left.width != right.width || left.height != right.height))
+                    {
+                        throw image_size_mismatch_exception();
+                    }
+                    *this = left.sized ? left : right;
+                }
+            };
+
+            //!leaf of an expression reading the pixels of an image
+            template <typename PixelType>
+            struct image_terminal : public image_expression_base
+            {
+                typedef PixelType value_type;
+
+                PixelType const* pixels;
+
+                explicit image_terminal(image_buffer<PixelType> const& source) : pixels(source.raw_data())
+                {
+                    this->sized = true;
+                    this->width = source.get_width();
+                    this->height = source.get_height();
+                }
+
+                value_type operator[](std::size_t index) const
+                {
+                    return this->pixels[index];
+                }
+            };
+
+            //!leaf of an expression with the same value for every pixel
+            template <typename T>
+            struct scalar_terminal : public image_expression_base
+            {
+                typedef T value_type;
+
+                T value;
+
+                explicit scalar_terminal(T scalar) : value(scalar) {}
+
+                value_type operator[](std::size_t) const
+                {
+                    return this->value;
+                }
+            };
+
+            //!operation applied to every pixel of an expression
+            template <typename Operation, typename Operand>
+            struct unary_expression : public image_expression_base
+            {
+                typedef decltype(Operation::apply(std::declval<typename Operand::value_type>())) value_type;
+
+                Operand operand;
+
+                explicit unary_expression(Operand const& argument) : operand(argument)
+                {
+                    static_cast<image_expression_base&>(*this) = argument;
+                }
+
+                value_type operator[](std::size_t index) const
+                {
+                    return Operation::apply(this->operand[index]);
+                }
+            };
+
+            //!operation applied to the pixels at the same position of two expressions
+            //!pixel types combine with the usual arithmetic conversions, e.g. B16 - B16 is int and B16 * double is double
+            template <typename Operation, typename Left, typename Right>
+            struct binary_expression : public image_expression_base
+            {
+                typedef decltype(Operation::apply(std::declval<typename Left::value_type>(),
+                    std::declval<typename Right::value_type>())) value_type;
+
+                Left left;
+                Right right;
+
+                binary_expression(Left const& left_operand, Right const& right_operand) :
+                    left(left_operand), right(right_operand)
+                {
+                    set_size(left_operand, right_operand);
+                }
+
+                value_type operator[](std::size_t index) const
+                {
+                    return Operation::apply(this->left[index], this->right[index]);
+                }
+            };
+
+            //!pixels of if_true where condition is true (non zero for masks stored as images) and of if_false elsewhere
+            template <typename Condition, typename IfTrue, typename IfFalse>
+            struct select_expression : public image_expression_base
+            {
+                typedef typename std::common_type<typename IfTrue::value_type,
+                    typename IfFalse::value_type>::type value_type;
+
+                Condition condition;
+                IfTrue if_true;
+                IfFalse if_false;
+
+                select_expression(Condition const& mask, IfTrue const& true_operand, IfFalse const& false_operand) :
+                    condition(mask), if_true(true_operand), if_false(false_operand)
+                {
+                    set_size(true_operand, false_operand);
+                    set_size(mask, *this);
+                }
+
+                value_type operator[](std::size_t index) const
+                {
+                    return this->condition[index] ? this->if_true[index] : this->if_false[index];
+                }
+            };
+
+            ///@cond INTERNAL
+            namespace expression_operation
+            {
+                struct plus
+                {
+                    template <typename L, typename R>
+                    static auto apply(L l, R r) -> decltype(l + r) { return l + r; }
+                };
+
+                struct minus
+                {
+                    template <typename L, typename R>
+                    static auto apply(L l, R r) -> decltype(l - r) { return l - r; }
+                };
+
+                struct multiplies
+                {
+                    template <typename L, typename R>
+                    static auto apply(L l, R r) -> decltype(l * r) { return l * r; }
+                };
+
+                struct divides
+                {
+                    template <typename L, typename R>
+                    static auto apply(L l, R r) -> decltype(l / r) { return l / r; }
+                };
+
+                struct less
+                {
+                    template <typename L, typename R>
+                    static bool apply(L l, R r) { return l < r; }
+                };
+
+                struct greater
+                {
+                    template <typename L, typename R>
+                    static bool apply(L l, R r) { return l > r; }
+                };
+
+                struct less_equal
+                {
+                    template <typename L, typename R>
+                    static bool apply(L l, R r) { return l <= r; }
+                };
+
+                struct greater_equal
+                {
+                    template <typename L, typename R>
+                    static bool apply(L l, R r) { return l >= r; }
+                };
+
+                struct logical_and
+                {
+                    template <typename L, typename R>
+                    static bool apply(L l, R r) { return l && r; }
+                };
+
+                struct logical_or
+                {
+                    template <typename L, typename R>
+                    static bool apply(L l, R r) { return l || r; }
+                };
+
+                struct minimum
+                {
+                    template <typename L, typename R>
+                    static auto apply(L l, R r) -> decltype(l + r) { return r < l ? r : l; }
+                };
+
+                struct maximum
+                {
+                    template <typename L, typename R>
+                    static auto apply(L l, R r) -> decltype(l + r) { return l < r ? r : l; }
+                };
+
+                struct negate
+                {
+                    template <typename T>
+                    static auto apply(T value) -> decltype(-value) { return -value; }
+                };
+
+                struct logical_not
+                {
+                    template <typename T>
+                    static bool apply(T value) { return !value; }
+                };
+
+                template <typename Target>
+                struct cast
+                {
+                    template <typename T>
+                    static Target apply(T value) { return static_cast<Target>(value); }
+                };
+            } //namespace expression_operation
+            ///@endcond
+
+            //!returns the expression reading the pixels of an image
+            template <typename PixelType>
+            image_terminal<PixelType> as_expression(image_buffer<PixelType> const& source)
+            {
+                return image_terminal<PixelType>(source);
+            }
+
+            //!returns a copy of an expression
+            template <typename Expression>
+            typename std::enable_if<std::is_base_of<image_expression_base, Expression>::value, Expression>::type
+            as_expression(Expression const& expression)
+            {
+                return expression;
+            }
+
+            //!returns the expression with the value of a scalar for every pixel
+            template <typename T>
+            typename std::enable_if<std::is_arithmetic<T>::value, scalar_terminal<T>>::type
+            as_expression(T value)
+            {
+                return scalar_terminal<T>(value);
+            }
+
+            ///@cond INTERNAL
+            template <typename T>
+            struct always_void
+            {
+                typedef void type;
+            };
+
+            //!type of the expression of an image, an expression or a scalar, no type for anything else
+            template <typename T, typename Enable = void>
+            struct expression_of {};
+
+            template <typename T>
+            struct expression_of<T, typename always_void<decltype(as_expression(std::declval<T const&>()))>::type>
+            {
+                typedef decltype(as_expression(std::declval<T const&>())) type;
+            };
+
+            //!node combining Left and Right with Operation if at least one of them is an image or an expression
+            template <typename Operation, typename Left, typename Right>
+            using binary_node = typename std::enable_if<!std::is_arithmetic<Left>::value || !std::is_arithmetic<Right>::value,
+                binary_expression<Operation, typename expression_of<Left>::type, typename expression_of<Right>::type>>::type;
+
+            template <typename Operation, typename Operand>
+            using unary_node = typename std::enable_if<!std::is_arithmetic<Operand>::value,
+                unary_expression<Operation, typename expression_of<Operand>::type>>::type;
+
+            template <typename Operation, typename Left, typename Right>
+            binary_node<Operation, Left, Right> make_binary(Left const& left, Right const& right)
+            {
+                return binary_node<Operation, Left, Right>(as_expression(left), as_expression(right));
+            }
+            ///@endcond
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::plus, Left, Right> operator+(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::plus>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::minus, Left, Right> operator-(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::minus>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::multiplies, Left, Right> operator*(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::multiplies>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::divides, Left, Right> operator/(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::divides>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::less, Left, Right> operator<(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::less>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::greater, Left, Right> operator>(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::greater>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::less_equal, Left, Right> operator<=(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::less_equal>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::greater_equal, Left, Right> operator>=(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::greater_equal>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::logical_and, Left, Right> operator&&(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::logical_and>(left, right);
+            }
+
+            template <typename Left, typename Right>
+            binary_node<expression_operation::logical_or, Left, Right> operator||(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::logical_or>(left, right);
+            }
+
+            template <typename Operand>
+            unary_node<expression_operation::negate, Operand> operator-(Operand const& operand)
+            {
+                return unary_node<expression_operation::negate, Operand>(as_expression(operand));
+            }
+
+            template <typename Operand>
+            unary_node<expression_operation::logical_not, Operand> operator!(Operand const& operand)
+            {
+                return unary_node<expression_operation::logical_not, Operand>(as_expression(operand));
+            }
+
+            //!smaller of the pixels of left and right at every position (e.g. minimum(frame, 65535.0) clips a frame)
+            template <typename Left, typename Right>
+            binary_node<expression_operation::minimum, Left, Right> minimum(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::minimum>(left, right);
+            }
+
+            //!larger of the pixels of left and right at every position
+            template <typename Left, typename Right>
+            binary_node<expression_operation::maximum, Left, Right> maximum(Left const& left, Right const& right)
+            {
+                return make_binary<expression_operation::maximum>(left, right);
+            }
+
+            //!pixels of operand converted to Target with static_cast, e.g. to compute B16 differences as float
+            template <typename Target, typename Operand>
+            unary_node<expression_operation::cast<Target>, Operand> pixel_cast(Operand const& operand)
+            {
+                return unary_node<expression_operation::cast<Target>, Operand>(as_expression(operand));
+            }
+
+            //!pixels of if_true where condition is true and of if_false elsewhere, condition is a comparison
+            //!(e.g. where(flat > 0.1, frame / flat, 0.0)) or a mask image whose non zero pixels are true
+            template <typename Condition, typename IfTrue, typename IfFalse>
+            select_expression<typename expression_of<Condition>::type, typename expression_of<IfTrue>::type,
+                typename expression_of<IfFalse>::type>
+            where(Condition const& condition, IfTrue const& if_true, IfFalse const& if_false)
+            {
+                return select_expression<typename expression_of<Condition>::type, typename expression_of<IfTrue>::type,
+                    typename expression_of<IfFalse>::type>(as_expression(condition), as_expression(if_true),
+                    as_expression(if_false));
+            }
+
+            //!computes every pixel of expression into result, which gets the size of the images of the expression
+            //!(result keeps its size if the expression has no image), the pixels are computed in one pass by up to
+            //!threads threads (0 uses all hardware threads) and converted as by convert_pixels() (integer pixels saturate)
+            //!result may be one of the images of the expression
+            template <typename PixelType, typename Expression>
+            void evaluate(Expression const& expression, image_buffer<PixelType>& result, std::size_t threads = 0)
+            {
+                typename expression_of<Expression>::type const root = as_expression(expression);
+                if (root.sized)
+                {
+                    result.set_size(root.width, root.height);
+                }
+
+                std::size_t const size = result.get_width() * result.get_height();
+                std::size_t const part_size = std::size_t(1) << 18;
+                PixelType* const output = result.raw_data();
+                boost::astronomy::detail::parallel_for((size + part_size - 1) / part_size, [&](std::size_t part)
+                {
+                    std::size_t const end = (std::min)(size, (part + 1) * part_size);
+                    for (std::size_t i = part * part_size; i < end; i++)
+                    {
+                        output[i] = boost::astronomy::detail::convert_value<PixelType>(root[i], true);
+                    }
+                }, threads);
+            }
+
+            //!returns the pixels of expression computed as PixelType, e.g. evaluate<float>((raw - bias) / flat)
+            template <typename PixelType, typename Expression>
+            image_buffer<PixelType> evaluate(Expression const& expression, std::size_t threads = 0)
+            {
+                image_buffer<PixelType> result;
+                evaluate(expression, result, threads);
+                return result;
+            }
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_EXPRESSION_HPP
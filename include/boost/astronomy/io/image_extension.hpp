@@ -2,13 +2,14 @@
 #define BOOST_ASTRONOMY_IO_IMAGE_EXTENSION_HDU_HPP
 
 #include <string>
-#include <vector>
 #include <cstddef>
-#include <valarray>
+#include <fstream>
+#include <memory>
 
 #include <boost/astronomy/io/hdu.hpp>
 #include <boost/astronomy/io/extension_hdu.hpp>
-#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/image_data_unit.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
 
 namespace boost
 {
@@ -17,75 +18,43 @@ namespace boost
         namespace io
         {
             template <bitpix DataType>
-            struct image_extension : public boost::astronomy::io::extension_hdu
+            struct image_extension : public boost::astronomy::io::extension_hdu,
+                public boost::astronomy::io::image_data_unit<image_extension<DataType>, DataType>
             {
             protected:
-                image<DataType> data;
+                typedef boost::astronomy::io::image_data_unit<image_extension<DataType>, DataType> data_unit;
 
             public:
                 image_extension(std::fstream &file) : extension_hdu(file)
                 {
-                    //read image according to dimension specified by naxis
-                    switch (this->naxis())
-                    {
-                    case 0:
-                        break;
-                    case 1:
-                        data.read_image(file, this->naxis(1), 1);
-                        break;
-                    case 2:
-                        data.read_image(file, this->naxis(1), this->naxis(2));
-                        break;
-                    default:
-                        data.read_image(file, this->naxis(1), std::accumulate(this->_naxis.begin() + 1, this->_naxis.end(), 0, std::multiplies<std::size_t>()));
-                        break;
-                    }
+                    this->read_data_unit(file);
                     set_unit_end(file);
                 }
 
                 image_extension(std::fstream &file, hdu const& other) : extension_hdu(file, other)
                 {
-                    //read image according to dimension specified by naxis
-                    switch (this->naxis())
-                    {
-                    case 0:
-                        break;
-                    case 1:
-                        data.read_image(file, this->naxis(1), 1);
-                        break;
-                    case 2:
-                        data.read_image(file, this->naxis(1), this->naxis(2));
-                        break;
-                    default:
-                        data.read_image(file, this->naxis(1), std::accumulate(this->_naxis.begin() + 1, this->_naxis.end(), 0, std::multiplies<std::size_t>()));
-                        break;
-                    }
+                    this->read_data_unit(file);
                     set_unit_end(file);
                 }
 
                 image_extension(std::fstream &file, std::streampos pos) : extension_hdu(file, pos)
                 {
-                    //read image according to dimension specified by naxis
-                    switch (this->naxis())
-                    {
-                    case 0:
-                        break;
-                    case 1:
-                        data.read_image(file, this->naxis(1), 1);
-                        break;
-                    case 2:
-                        data.read_image(file, this->naxis(1), this->naxis(2));
-                        break;
-                    default:
-                        data.read_image(file, this->naxis(1), std::accumulate(this->_naxis.begin() + 1, this->_naxis.end(), 0, std::multiplies<std::size_t>()));
-                        break;
-                    }
+                    this->read_data_unit(file);
                     set_unit_end(file);
                 }
+
+                //!This constructor should be used when the file is memory mapped, offset is the position of data unit in the file
+                //!image data is not copied, it is converted only when accessed through get_view() or get_data()
+                image_extension(std::shared_ptr<mapped_file const> const& file, std::size_t offset, hdu const& other) :
+                    extension_hdu(other), data_unit(file, offset, other) {}
+
+                //!This constructor should be used when data unit is read on demand, offset is the position of data unit in path
+                //!image is read from the file on the first call to get_data() or load_data()
+                image_extension(std::string const& path, std::size_t offset, hdu const& other) :
+                    extension_hdu(other), data_unit(path, offset, other) {}
             };
         } //namespace io
     } //namespace astronomy
 } //namespace boost
 
 #endif // !BOOST_ASTRONOMY_IO_IMAGE_EXTENSION_HDU_HPP
-
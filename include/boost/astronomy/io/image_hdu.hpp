@@ -0,0 +1,152 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_HDU_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_HDU_HPP
+
+#include <boost/blank.hpp>
+#include <boost/variant/variant.hpp>
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/hdu.hpp>
+#include <boost/astronomy/io/primary_hdu.hpp>
+#include <boost/astronomy/io/image_extension.hpp>
+#include <boost/astronomy/io/compressed_image_extension.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!typed reference to an HDU holding an image: a primary HDU, an image extension or a tile compressed image
+            //!of any BITPIX, so that code working on pixels is instantiated for every pixel type and the type of the
+            //!HDU is resolved once per visit instead of by downcasts and switches on BITPIX
+            //!the reference does not own the HDU, which must outlive it (e.g. the fits object the HDU was read from)
+            class image_hdu
+            {
+            public:
+                typedef boost::variant<boost::blank,
+                    primary_hdu<B8>*, primary_hdu<B16>*, primary_hdu<B32>*, primary_hdu<_B32>*, primary_hdu<_B64>*,
+                    image_extension<B8>*, image_extension<B16>*, image_extension<B32>*, image_extension<_B32>*,
+                    image_extension<_B64>*,
+                    compressed_image_extension<B8>*, compressed_image_extension<B16>*, compressed_image_extension<B32>*,
+                    compressed_image_extension<_B32>*, compressed_image_extension<_B64>*> variant_type;
+
+            private:
+                variant_type typed; //!boost::blank if the reference is empty
+
+                //!calls visitor with a reference to the typed HDU
+                template <typename Visitor>
+                struct hdu_visitor : public boost::static_visitor<typename Visitor::result_type>
+                {
+                    Visitor& visitor;
+
+                    explicit hdu_visitor(Visitor& target) : visitor(target) {}
+
+                    typename Visitor::result_type operator()(boost::blank) const
+                    {
+                        throw fits_exception();
+                    }
+
+                    template <typename TypedHdu>
+                    typename Visitor::result_type operator()(TypedHdu* typed) const
+                    {
+                        return this->visitor(*typed);
+                    }
+                };
+
+                //!calls visitor with the image of the typed HDU
+                template <typename Visitor>
+                struct data_visitor
+                {
+                    typedef typename Visitor::result_type result_type;
+
+                    Visitor& visitor;
+
+                    template <typename TypedHdu>
+                    result_type operator()(TypedHdu const& typed) const
+                    {
+                        return this->visitor(typed.get_data());
+                    }
+                };
+
+                struct header_visitor : public boost::static_visitor<hdu*>
+                {
+                    hdu* operator()(boost::blank) const
+                    {
+                        return nullptr;
+                    }
+
+                    template <typename TypedHdu>
+                    hdu* operator()(TypedHdu* typed) const
+                    {
+                        return typed;
+                    }
+                };
+
+            public:
+                //!creates an empty reference
+                image_hdu() {}
+
+                //!creates the reference to hdu_pointer, a primary_hdu, image_extension or compressed_image_extension
+                template <template <boost::astronomy::io::bitpix> class HduType, boost::astronomy::io::bitpix DataType>
+                explicit image_hdu(HduType<DataType>* hdu_pointer) : typed(hdu_pointer) {}
+
+                //!returns true if the reference refers to no HDU
+                bool empty() const
+                {
+                    return this->typed.which() == 0;
+                }
+
+                //!returns the header of the HDU, throws fits_exception if the reference is empty
+                hdu& get_header() const
+                {
+                    hdu* header = boost::apply_visitor(header_visitor(), this->typed);
+                    if (header == nullptr)
+                    {
+                        throw fits_exception();
+                    }
+                    return *header;
+                }
+
+                //!returns the type of the pixels of the image, throws fits_exception if the reference is empty
+                //!(ZBITPIX for compressed images, the BITPIX of their header describes the compressed table)
+                boost::astronomy::io::bitpix bitpix() const
+                {
+                    if (empty())
+                    {
+                        throw fits_exception();
+                    }
+                    return static_cast<boost::astronomy::io::bitpix>((this->typed.which() - 1) % 5);
+                }
+
+                //!calls visitor(typed) with a reference to the typed HDU, e.g. image_extension<B16>&
+                //!Visitor must define result_type (e.g. by deriving from boost::static_visitor<>) and its call operator
+                //!is a template so that it is instantiated for every type of HDU, throws fits_exception if the reference is empty
+                template <typename Visitor>
+                typename Visitor::result_type visit(Visitor& visitor) const
+                {
+                    hdu_visitor<Visitor> dispatch(visitor);
+                    return boost::apply_visitor(dispatch, this->typed);
+                }
+
+                //!calls visitor(image) with the image of the HDU (image<DataType>, as returned by get_data())
+                template <typename Visitor>
+                typename Visitor::result_type visit_data(Visitor& visitor) const
+                {
+                    data_visitor<Visitor> dispatch = {visitor};
+                    return visit(dispatch);
+                }
+
+                //!returns the variant holding the typed HDU
+                variant_type const& get_variant() const
+                {
+                    return this->typed;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_HDU_HPP
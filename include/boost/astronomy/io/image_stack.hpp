@@ -0,0 +1,334 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_STACK_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_STACK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/cstdfloat.hpp>
+
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/detail/sigma_clip.hpp>
+#include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/fits.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/image_hdu.hpp>
+#include <boost/astronomy/io/pixel_conversion.hpp>
+#include <boost/astronomy/io/value_scaling.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!how the values of a pixel in all the frames of a stack are combined, NaN values are always left out
+            enum class combine_method
+            {
+                mean, //!mean of the values
+                median, //!middle value, the mean of the two middle values for an even number of values
+                sigma_clipped_mean, //!mean of the values left after iteratively rejecting the values farther than
+                                    //!sigma_low (below) or sigma_high (above) standard deviations from the median
+                minmax_rejected_mean //!mean of the values left after rejecting the reject_low lowest and the
+                                     //!reject_high highest values (the median if no value would be left)
+            };
+
+            //!parameters of image_stack::combine()
+            struct stack_options
+            {
+                combine_method method = combine_method::median;
+                double sigma_low = 3; //!rejection threshold below the median for sigma_clipped_mean
+                double sigma_high = 3; //!rejection threshold above the median for sigma_clipped_mean
+                std::size_t max_iterations = 5; //!maximum number of clipping iterations for sigma_clipped_mean
+                std::size_t reject_low = 1; //!number of lowest values rejected by minmax_rejected_mean
+                std::size_t reject_high = 1; //!number of highest values rejected by minmax_rejected_mean
+                std::size_t memory_budget = std::size_t(256) << 20; //!bytes of the strip buffers of all the threads
+                std::size_t threads = 0; //!number of threads (0 uses all hardware threads)
+            };
+
+            //!frame of a stack: reads any rows of an image as physical values (BSCALE and BZERO applied, BLANK is NaN)
+            //!without reading the rest of the image
+            class stack_frame
+            {
+            public:
+                //!reads rows rows starting at first_row into output (rows * width values)
+                typedef std::function<void(std::size_t first_row, std::size_t rows, boost::float32_t* output)> row_reader;
+
+            protected:
+                std::size_t width; //!width of image
+                std::size_t height; //!height of image
+                row_reader reader;
+
+                //!creates the frames of HDUs, the HDU must outlive the frame
+                struct hdu_frame
+                {
+                    typedef stack_frame result_type;
+
+                    //!primary HDUs and image extensions read the rows of mapped or deferred images only
+                    template <template <boost::astronomy::io::bitpix> class HduType, boost::astronomy::io::bitpix DataType>
+                    stack_frame operator()(HduType<DataType> const& typed) const
+                    {
+                        HduType<DataType> const* source = &typed;
+                        value_scaling const scaling = typed.get_scaling();
+                        std::size_t const image_width = typed.image_width();
+                        return stack_frame(image_width, typed.image_height(),
+                            [source, scaling, image_width](std::size_t first_row, std::size_t rows, boost::float32_t* output)
+                        {
+                            image<DataType> strip = source->get_region(first_row, 0, image_width, rows);
+                            scaling.apply(strip.raw_data(), image_width * rows, output);
+                        });
+                    }
+
+                    //!tile compressed images decompress the tiles covering the rows only
+                    template <boost::astronomy::io::bitpix DataType>
+                    stack_frame operator()(compressed_image_extension<DataType> const& typed) const
+                    {
+                        compressed_image_extension<DataType> const* source = &typed;
+                        std::size_t const image_width = typed.get_width();
+                        //reads the table of tiles now so that rows can be decompressed by different threads
+                        typed.get_region(0, 0, 0, 0, 1);
+                        return stack_frame(image_width, typed.get_height(),
+                            [source, image_width](std::size_t first_row, std::size_t rows, boost::float32_t* output)
+                        {
+                            image<DataType> strip = source->get_region(first_row, 0, image_width, rows, 1);
+                            convert_pixels(strip.raw_data(), image_width * rows, output, rounding_policy::nearest, 1);
+                        });
+                    }
+                };
+
+            public:
+                stack_frame(std::size_t image_width, std::size_t image_height, row_reader const& rows_of_image) :
+                    width(image_width), height(image_height), reader(rows_of_image) {}
+
+                //!frame of an image in memory, which must outlive the frame
+                template <typename PixelType>
+                explicit stack_frame(image_buffer<PixelType> const& source) :
+                    width(source.get_width()), height(source.get_height())
+                {
+                    PixelType const* pixels = source.raw_data();
+                    std::size_t const image_width = this->width;
+                    this->reader = [pixels, image_width](std::size_t first_row, std::size_t rows, boost::float32_t* output)
+                    {
+                        convert_pixels(pixels + first_row * image_width, rows * image_width, output, rounding_policy::nearest, 1);
+                    };
+                }
+
+                //!frame of the image of an HDU (primary HDU, image extension or tile compressed image of any BITPIX)
+                //!which must outlive the frame, e.g. fits::get_image() of a mapped or deferred file
+                explicit stack_frame(image_hdu const& source) :
+                    stack_frame(make_hdu_frame(source)) {}
+
+                //!frame of the image in HDU index of the file at file_path, the headers are read now and the rows
+                //!of the frame are read from the file when they are combined
+                explicit stack_frame(std::string const& file_path, std::size_t index = 0) :
+                    width(0), height(0)
+                {
+                    std::shared_ptr<fits> file = std::make_shared<fits>(file_path, fits::deferred);
+                    stack_frame const frame = make_hdu_frame(file->get_image(index));
+                    row_reader const read_rows = frame.reader;
+                    this->width = frame.width;
+                    this->height = frame.height;
+                    //the reader keeps the fits object and its HDUs alive
+                    this->reader = [file, read_rows](std::size_t first_row, std::size_t rows, boost::float32_t* output)
+                    {
+                        read_rows(first_row, rows, output);
+                    };
+                }
+
+                std::size_t get_width() const
+                {
+                    return this->width;
+                }
+
+                std::size_t get_height() const
+                {
+                    return this->height;
+                }
+
+                //!reads rows rows starting at first_row into output, different threads may read different rows
+                void read_rows(std::size_t first_row, std::size_t rows, boost::float32_t* output) const
+                {
+                    this->reader(first_row, rows, output);
+                }
+
+            private:
+                static stack_frame make_hdu_frame(image_hdu const& source)
+                {
+                    hdu_frame visitor;
+                    return source.visit(visitor);
+                }
+            };
+
+            //!combines frames of the same size pixel by pixel (e.g. bias, dark or flat frames into a master frame)
+            //!the frames are read in strips of rows, every thread reads the same strip of all the frames and combines
+            //!it, so memory is set by stack_options::memory_budget instead of the number of frames times their size
+            class image_stack
+            {
+            protected:
+                std::vector<stack_frame> frames;
+
+            public:
+                //!adds a frame, see stack_frame for the sources which can be combined
+                void add(stack_frame const& frame)
+                {
+                    if (!this->frames.empty() && (frame.get_width() != this->frames[0].get_width() ||
+                        frame.get_height() != this->frames[0].get_height()))
+                    {
+                        throw image_size_mismatch_exception();
+                    }
+                    this->frames.push_back(frame);
+                }
+
+                //!number of frames
+                std::size_t size() const
+                {
+                    return this->frames.size();
+                }
+
+                //!returns the number of rows of the strips and sets threads to the number of threads used by combine()
+                //!every thread holds a strip of every frame and of stored values read before scaling, threads are
+                //!reduced if the budget cannot hold one row per thread and strips have at least one row
+                std::size_t strip_height(stack_options const& options, std::size_t& threads) const
+                {
+                    if (this->frames.empty())
+                    {
+                        threads = 1;
+                        return 0;
+                    }
+
+                    std::size_t const width = (std::max)(this->frames[0].get_width(), std::size_t(1));
+                    std::size_t const height = (std::max)(this->frames[0].get_height(), std::size_t(1));
+                    std::size_t const row_bytes = width * (this->frames.size() * sizeof(boost::float32_t) + sizeof(double));
+                    std::size_t const budget_rows = (std::max)(options.memory_budget / row_bytes, std::size_t(1));
+
+                    threads = (std::min)((std::min)(boost::astronomy::detail::thread_count(options.threads), budget_rows), height);
+                    return (std::min)((std::max)(budget_rows / threads, std::size_t(1)), height);
+                }
+
+                //!returns the frames combined pixel by pixel with options.method
+                //!pixels without any value which is not NaN are NaN, throws fits_exception if the stack is empty
+                image_buffer<boost::float32_t> combine(stack_options const& options = stack_options()) const
+                {
+                    if (this->frames.empty())
+                    {
+                        throw fits_exception();
+                    }
+
+                    std::size_t threads = 1;
+                    std::size_t const rows = strip_height(options, threads);
+                    std::size_t const width = this->frames[0].get_width();
+                    std::size_t const height = this->frames[0].get_height();
+                    std::size_t const strips = (height + rows - 1) / rows;
+
+                    image_buffer<boost::float32_t> result(width, height);
+                    boost::float32_t* const output = result.raw_data();
+                    std::atomic<std::size_t> next_strip(0);
+                    boost::astronomy::detail::parallel_for(threads, [&](std::size_t)
+                    {
+                        std::size_t const count = this->frames.size();
+                        std::vector<boost::float32_t> strip(count * rows * width);
+                        std::vector<boost::float32_t> values;
+                        values.reserve(count);
+
+                        for (std::size_t s = next_strip++; s < strips; s = next_strip++)
+                        {
+                            std::size_t const first_row = s * rows;
+                            std::size_t const strip_rows = (std::min)(rows, height - first_row);
+                            std::size_t const strip_size = strip_rows * width;
+                            for (std::size_t f = 0; f < count; f++)
+                            {
+                                this->frames[f].read_rows(first_row, strip_rows, &strip[f * strip_size]);
+                            }
+
+                            for (std::size_t i = 0; i < strip_size; i++)
+                            {
+                                values.clear();
+                                for (std::size_t f = 0; f < count; f++)
+                                {
+                                    boost::float32_t const value = strip[f * strip_size + i];
+                                    if (!std::isnan(value))
+                                    {
+                                        values.push_back(value);
+                                    }
+                                }
+                                output[first_row * width + i] = combine_values(values, options);
+                            }
+                        }
+                    }, threads);
+                    return result;
+                }
+
+                //!combines the values of one pixel (without NaN) with options.method, values are reordered
+                static boost::float32_t combine_values(std::vector<boost::float32_t>& values, stack_options const& options)
+                {
+                    if (values.empty())
+                    {
+                        return std::numeric_limits<boost::float32_t>::quiet_NaN();
+                    }
+
+                    switch (options.method)
+                    {
+                    case combine_method::mean:
+                        return mean_of(values.data(), values.data() + values.size());
+                    case combine_method::median:
+                        return median_of(values);
+                    case combine_method::sigma_clipped_mean:
+                        return sigma_clipped_mean_of(values, options);
+                    case combine_method::minmax_rejected_mean:
+                    default:
+                        if (values.size() <= options.reject_low + options.reject_high)
+                        {
+                            return median_of(values);
+                        }
+                        std::sort(values.begin(), values.end());
+                        return mean_of(values.data() + options.reject_low, values.data() + values.size() - options.reject_high);
+                    }
+                }
+
+            protected:
+                static boost::float32_t mean_of(boost::float32_t const* first, boost::float32_t const* last)
+                {
+                    double sum = 0;
+                    for (boost::float32_t const* value = first; value != last; value++)
+                    {
+                        sum += *value;
+                    }
+                    return static_cast<boost::float32_t>(sum / static_cast<double>(last - first));
+                }
+
+                static boost::float32_t median_of(std::vector<boost::float32_t>& values)
+                {
+                    std::size_t const middle = values.size() / 2;
+                    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle), values.end());
+                    double const upper = values[middle];
+                    if (values.size() % 2 == 1)
+                    {
+                        return values[middle];
+                    }
+                    double const lower = *std::max_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle));
+                    return static_cast<boost::float32_t>((lower + upper) / 2);
+                }
+
+                //!the values are sorted once, every iteration narrows the window of values kept
+                static boost::float32_t sigma_clipped_mean_of(std::vector<boost::float32_t>& values, stack_options const& options)
+                {
+                    boost::float32_t* first = values.data();
+                    boost::float32_t* last = values.data() + values.size();
+                    boost::astronomy::detail::clipped_statistics const kept = boost::astronomy::detail::sigma_clip(
+                        first, last, options.sigma_low, options.sigma_high, options.max_iterations);
+                    return kept.count == 0 ? std::numeric_limits<boost::float32_t>::quiet_NaN()
+                        : static_cast<boost::float32_t>(kept.mean);
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_STACK_HPP
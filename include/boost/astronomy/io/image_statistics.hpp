@@ -0,0 +1,186 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_STATISTICS_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_STATISTICS_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <boost/astronomy/detail/parallel_for.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!count, sum, minimum, maximum, mean and variance of pixel values computed in a single pass
+            //!partial results of different parts of an image (chunks, threads or strips) are combined with merge(), then finish()
+            struct image_statistics
+            {
+                std::size_t count = 0; //!number of pixels
+                double min = 0; //!minimum pixel value
+                double max = 0; //!maximum pixel value
+                double mean = 0; //!mean of pixel values
+                double sum = 0; //!sum of pixel values
+                double m2 = 0; //!sum of squared differences from the mean
+
+            protected:
+                double sum_compensation = 0; //!low order bits lost while adding to sum (Kahan-Babuska summation)
+
+                //!number of pixels processed at once, small enough for the block to stay in L1 cache between the two passes
+                static std::size_t const block_size = 2048;
+
+            public:
+                //!sample variance (divided by count - 1)
+                double variance() const
+                {
+                    return this->count > 1 ? this->m2 / static_cast<double>(this->count - 1) : 0.0;
+                }
+
+                //!sample standard deviation
+                double std_dev() const
+                {
+                    return std::sqrt(this->variance());
+                }
+
+                //!adds the statistics of another, disjoint set of pixels (Chan et al. pairwise update)
+                void merge(image_statistics const& other)
+                {
+                    if (other.count == 0)
+                    {
+                        return;
+                    }
+                    if (this->count == 0)
+                    {
+                        *this = other;
+                        return;
+                    }
+
+                    double const n_a = static_cast<double>(this->count);
+                    double const n_b = static_cast<double>(other.count);
+                    double const n = n_a + n_b;
+                    double const delta = other.mean - this->mean;
+
+                    this->mean += delta * n_b / n;
+                    this->m2 += other.m2 + delta * delta * n_a * n_b / n;
+                    this->min = (std::min)(this->min, other.min);
+                    this->max = (std::max)(this->max, other.max);
+                    this->count += other.count;
+                    add_to_sum(other.sum);
+                    this->sum_compensation += other.sum_compensation;
+                }
+
+                //!adds the low order bits lost by merge() to sum, to be called once the last part is merged
+                void finish()
+                {
+                    this->sum += this->sum_compensation;
+                    this->sum_compensation = 0;
+                }
+
+                //!adds size pixels starting at pixels
+                template <typename PixelType>
+                void add(PixelType const* pixels, std::size_t size)
+                {
+                    std::size_t const block = block_size;
+                    for (std::size_t i = 0; i < size; i += block)
+                    {
+                        merge(of_block(pixels + i, (std::min)(block, size - i)));
+                    }
+                    finish();
+                }
+
+                //!computes statistics of size pixels using up to threads threads (0 uses all hardware threads)
+                //!the pixels are split into contiguous parts whose results are merged in order, so the result does not
+                //!depend on the number of threads
+                template <typename PixelType>
+                static image_statistics compute(PixelType const* pixels, std::size_t size, std::size_t threads = 0)
+                {
+                    std::size_t const part_size = std::size_t(1) << 18;
+                    std::size_t const parts = (size + part_size - 1) / part_size;
+
+                    std::vector<image_statistics> partial(parts);
+                    boost::astronomy::detail::parallel_for(parts, [&](std::size_t i)
+                    {
+                        partial[i].add(pixels + i * part_size, (std::min)(part_size, size - i * part_size));
+                    }, threads);
+
+                    image_statistics result;
+                    for (image_statistics const& part : partial)
+                    {
+                        result.merge(part);
+                    }
+                    result.finish();
+                    return result;
+                }
+
+            protected:
+                void add_to_sum(double value)
+                {
+                    double const total = this->sum + value;
+                    if (std::abs(this->sum) >= std::abs(value))
+                    {
+                        this->sum_compensation += (this->sum - total) + value;
+                    }
+                    else
+                    {
+                        this->sum_compensation += (value - total) + this->sum;
+                    }
+                    this->sum = total;
+                }
+
+                //!exact two pass statistics of a block which is in cache, four independent accumulators let the
+                //!compiler vectorize both passes
+                template <typename PixelType>
+                static image_statistics of_block(PixelType const* pixels, std::size_t size)
+                {
+                    double sums[4] = {0, 0, 0, 0};
+                    PixelType low = pixels[0], high = pixels[0];
+
+                    std::size_t i = 0;
+                    for (; i + 4 <= size; i += 4)
+                    {
+                        for (std::size_t lane = 0; lane < 4; lane++)
+                        {
+                            sums[lane] += static_cast<double>(pixels[i + lane]);
+                            low = pixels[i + lane] < low ? pixels[i + lane] : low;
+                            high = pixels[i + lane] > high ? pixels[i + lane] : high;
+                        }
+                    }
+                    for (; i < size; i++)
+                    {
+                        sums[0] += static_cast<double>(pixels[i]);
+                        low = pixels[i] < low ? pixels[i] : low;
+                        high = pixels[i] > high ? pixels[i] : high;
+                    }
+
+                    image_statistics result;
+                    result.count = size;
+                    result.sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+                    result.mean = result.sum / static_cast<double>(size);
+                    result.min = static_cast<double>(low);
+                    result.max = static_cast<double>(high);
+
+                    double squares[4] = {0, 0, 0, 0};
+                    for (i = 0; i + 4 <= size; i += 4)
+                    {
+                        for (std::size_t lane = 0; lane < 4; lane++)
+                        {
+                            double const difference = static_cast<double>(pixels[i + lane]) - result.mean;
+                            squares[lane] += difference * difference;
+                        }
+                    }
+                    for (; i < size; i++)
+                    {
+                        double const difference = static_cast<double>(pixels[i]) - result.mean;
+                        squares[0] += difference * difference;
+                    }
+                    result.m2 = (squares[0] + squares[1]) + (squares[2] + squares[3]);
+                    return result;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_STATISTICS_HPP
@@ -0,0 +1,185 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_STREAM_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_STREAM_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+#include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/image_statistics.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!reads an image which does not fit in memory as a sequence of strips of strip_height full rows
+            //!only two strips are kept in memory: the current one and the next one which is read in background
+            //!while the current strip is processed, both buffers are reused for all the strips
+            template <bitpix DataType>
+            struct image_stream
+            {
+            protected:
+                std::shared_ptr<boost::astronomy::detail::positional_file> file; //!file containing the image
+                std::uint64_t data_offset; //!position of the first pixel in file
+                std::size_t width; //!width of image
+                std::size_t height; //!height of image
+                std::size_t strip_height; //!number of rows in every strip (except possibly the last one)
+                bool prefetch; //!true if next strip is read in background
+
+                image<DataType> current; //!strip returned by strip()
+                image<DataType> next_strip; //!buffer into which the following strip is read
+                std::future<void> pending; //!background read of next_strip
+                std::size_t current_row; //!first row of current strip
+                std::size_t next_row; //!first row of next_strip
+
+            public:
+                //!offset is the position of image data in file, image_width and image_height are the dimensions of whole image
+                //!every strip has rows_per_strip rows, the next strip is read in background if read_ahead is true
+                image_stream(std::string const& file_path, std::uint64_t offset, std::size_t image_width, std::size_t image_height,
+                    std::size_t rows_per_strip, bool read_ahead = true) :
+                    file(std::make_shared<boost::astronomy::detail::positional_file>(file_path)),
+                    data_offset(offset), width(image_width), height(image_height),
+                    strip_height((std::max)(rows_per_strip, std::size_t(1))), prefetch(read_ahead),
+                    current_row(0), next_row(0)
+                {
+                    rewind();
+                }
+
+                image_stream(image_stream const&) = delete;
+                image_stream& operator=(image_stream const&) = delete;
+
+                ~image_stream()
+                {
+                    if (this->pending.valid())
+                    {
+                        this->pending.wait();
+                    }
+                }
+
+                //!starts reading again from the first row
+                void rewind()
+                {
+                    if (this->pending.valid())
+                    {
+                        this->pending.wait();
+                    }
+                    this->current_row = this->height;
+                    this->next_row = 0;
+                    if (this->prefetch)
+                    {
+                        start_read();
+                    }
+                }
+
+                //!makes the next strip current, returns false if all the strips have been read
+                //!the previous strip is overwritten so it must not be used after this call
+                bool next()
+                {
+                    if (this->next_row >= this->height)
+                    {
+                        this->current_row = this->height;
+                        return false;
+                    }
+
+                    if (this->pending.valid())
+                    {
+                        this->pending.get();
+                    }
+                    else
+                    {
+                        read_strip(this->next_strip, this->next_row);
+                    }
+
+                    std::swap(this->current, this->next_strip);
+                    this->current_row = this->next_row;
+                    this->next_row += this->current.get_height();
+
+                    if (this->prefetch)
+                    {
+                        start_read();
+                    }
+                    return true;
+                }
+
+                //!returns the current strip, its width is the width of image and height is at most strip_height
+                image<DataType> const& strip() const
+                {
+                    return this->current;
+                }
+
+                //!returns the row of image at which the current strip starts
+                std::size_t strip_row() const
+                {
+                    return this->current_row;
+                }
+
+                //!returns the width of whole image
+                std::size_t get_width() const
+                {
+                    return this->width;
+                }
+
+                //!returns the height of whole image
+                std::size_t get_height() const
+                {
+                    return this->height;
+                }
+
+                //!calls function(strip, first_row) for every remaining strip of the image
+                template <typename Function>
+                void for_each_strip(Function function)
+                {
+                    while (next())
+                    {
+                        function(this->current, this->current_row);
+                    }
+                }
+
+                //!returns the statistics of all the remaining strips, which are merged strip by strip
+                //!so the whole image is never held in memory
+                image_statistics statistics(std::size_t threads = 0)
+                {
+                    image_statistics result;
+                    while (next())
+                    {
+                        result.merge(this->current.statistics(threads));
+                    }
+                    result.finish();
+                    return result;
+                }
+
+            protected:
+                void read_strip(image<DataType>& strip, std::size_t first_row) const
+                {
+                    std::size_t rows = (std::min)(this->strip_height, this->height - first_row);
+                    strip.assign_big_endian(*this->file, this->data_offset + first_row * this->width * element_size(DataType),
+                        this->width, rows);
+                }
+
+                void start_read()
+                {
+                    if (this->next_row >= this->height)
+                    {
+                        return;
+                    }
+
+                    std::size_t row = this->next_row;
+                    this->pending = std::async(std::launch::async, [this, row]()
+                    {
+                        this->read_strip(this->next_strip, row);
+                    });
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_STREAM_HPP
@@ -0,0 +1,100 @@
+#ifndef BOOST_ASTRONOMY_IO_IMAGE_VIEW_HPP
+#define BOOST_ASTRONOMY_IO_IMAGE_VIEW_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+#include <boost/astronomy/detail/byteswap.hpp>
+#include <boost/astronomy/io/bitpix.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!typed read only view of big-endian image data inside a mapped file
+            //!nothing is copied when the view is created, pixels are converted to native byte order when accessed
+            template <bitpix DataType>
+            struct image_view
+            {
+            public:
+                typedef typename image<DataType>::pixel_type pixel_type;
+
+            protected:
+                std::shared_ptr<mapped_file const> file; //!keeps the mapping alive as long as the view exists
+                char const* pixels; //!first byte of the image data inside the mapping
+                std::size_t _width; //!width of image
+                std::size_t _height; //!height of image
+
+            public:
+                image_view() : pixels(nullptr), _width(0), _height(0) {}
+
+                image_view(std::shared_ptr<mapped_file const> const& mapping, std::size_t offset,
+                    std::size_t width, std::size_t height) :
+                    file(mapping), pixels(mapping->data() + offset), _width(width), _height(height) {}
+
+                //!returns width of image
+                std::size_t width() const
+                {
+                    return this->_width;
+                }
+
+                //!returns height of image
+                std::size_t height() const
+                {
+                    return this->_height;
+                }
+
+                //!returns total number of pixels
+                std::size_t size() const
+                {
+                    return this->_width * this->_height;
+                }
+
+                //!returns the big-endian bytes of the image as stored in the file
+                char const* raw_data() const
+                {
+                    return this->pixels;
+                }
+
+                //!returns the pixel at index in native byte order
+                pixel_type operator[](std::size_t index) const
+                {
+                    pixel_type value;
+                    std::memcpy(&value, this->pixels + index * sizeof(pixel_type), sizeof(pixel_type));
+                    boost::astronomy::detail::big_to_native_inplace(&value, 1);
+                    return value;
+                }
+
+                //!same indexing as image_buffer::operator()
+                pixel_type operator() (std::size_t x, std::size_t y) const
+                {
+                    return (*this)[(x*this->_width) + y];
+                }
+
+                //!converts only the region which starts at (x, y) (x is the row and y the column as in operator())
+                //!into an image stored in memory
+                image<DataType> region(std::size_t x, std::size_t y, std::size_t region_width, std::size_t region_height) const
+                {
+                    image<DataType> result;
+                    result.assign_region_big_endian(this->pixels, this->_width, this->_height, x, y, region_width, region_height);
+                    return result;
+                }
+
+                //!converts the whole view into an image stored in memory
+                image<DataType> to_image() const
+                {
+                    image<DataType> result;
+                    result.assign_big_endian(this->pixels, this->_width, this->_height);
+                    return result;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_IMAGE_VIEW_HPP
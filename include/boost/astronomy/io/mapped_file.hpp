@@ -0,0 +1,48 @@
+#ifndef BOOST_ASTRONOMY_IO_MAPPED_FILE_HPP
+#define BOOST_ASTRONOMY_IO_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstddef>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!read only memory mapping of a whole file
+            //!pages are loaded by the OS on first access and shared with every other process mapping the same file
+            struct mapped_file
+            {
+            protected:
+                boost::interprocess::file_mapping mapping; //!mapping object of the file
+                boost::interprocess::mapped_region region; //!mapped view of the whole file
+
+            public:
+                mapped_file(std::string const& file_path) :
+                    mapping(file_path.c_str(), boost::interprocess::read_only),
+                    region(mapping, boost::interprocess::read_only)
+                {
+                    region.advise(boost::interprocess::mapped_region::advice_sequential);
+                }
+
+                //!returns pointer to the first byte of the file
+                char const* data() const
+                {
+                    return static_cast<char const*>(this->region.get_address());
+                }
+
+                //!returns the size of file in bytes
+                std::size_t size() const
+                {
+                    return this->region.get_size();
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_MAPPED_FILE_HPP
@@ -0,0 +1,70 @@
+#ifndef BOOST_ASTRONOMY_IO_PIXEL_CONVERSION_HPP
+#define BOOST_ASTRONOMY_IO_PIXEL_CONVERSION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <boost/astronomy/detail/byteswap.hpp>
+#include <boost/astronomy/detail/convert_pixels.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!rounding of floating point values converted to integer pixels
+            enum class rounding_policy
+            {
+                nearest, //!to the nearest integer, halfway values to the even integer
+                toward_zero //!the fractional part is discarded as by static_cast
+            };
+
+            //!converts count pixels of input to the pixel type of output, e.g. std::int16_t to float or double to float
+            //!integer targets saturate at the limits of Target (NaN becomes 0), floating point targets follow IEEE 754
+            //!common pairs of pixel types are converted with SIMD widening and narrowing, large arrays are split
+            //!in parts converted by up to threads threads (0 uses all hardware threads)
+            template <typename Target, typename Source>
+            void convert_pixels(Source const* input, std::size_t count, Target* output,
+                rounding_policy rounding = rounding_policy::nearest, std::size_t threads = 0)
+            {
+                std::size_t const part_size = std::size_t(1) << 18;
+                bool const nearest = rounding == rounding_policy::nearest;
+                boost::astronomy::detail::parallel_for((count + part_size - 1) / part_size, [&](std::size_t part)
+                {
+                    std::size_t const first = part * part_size;
+                    boost::astronomy::detail::convert_kernel<Target, Source>::apply(input + first,
+                        (std::min)(part_size, count - first), output + first, nearest);
+                }, threads);
+            }
+
+            //!same as convert_pixels() for count big-endian Source values stored at bytes (e.g. in a mapped file)
+            //!every block is converted to native byte order on the stack and then to Target while it is in cache,
+            //!so the data unit is decoded straight into the target type
+            template <typename Target, typename Source>
+            void convert_big_endian(char const* bytes, std::size_t count, Target* output,
+                rounding_policy rounding = rounding_policy::nearest, std::size_t threads = 0)
+            {
+                std::size_t const part_size = std::size_t(1) << 18;
+                bool const nearest = rounding == rounding_policy::nearest;
+                boost::astronomy::detail::parallel_for((count + part_size - 1) / part_size, [&](std::size_t part)
+                {
+                    std::size_t const block_size = 4096 / sizeof(Source);
+                    Source block[block_size];
+                    std::size_t const end = (std::min)(count, (part + 1) * part_size);
+                    for (std::size_t i = part * part_size; i < end; i += block_size)
+                    {
+                        std::size_t const block_count = (std::min)(block_size, end - i);
+                        std::memcpy(block, bytes + i * sizeof(Source), block_count * sizeof(Source));
+                        boost::astronomy::detail::big_to_native_inplace(block, block_count);
+                        boost::astronomy::detail::convert_kernel<Target, Source>::apply(block, block_count, output + i, nearest);
+                    }
+                }, threads);
+            }
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_PIXEL_CONVERSION_HPP
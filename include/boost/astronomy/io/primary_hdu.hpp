@@ -3,13 +3,13 @@
 
 //#include <map>
 #include <string>
-#include <vector>
 #include <cstddef>
-#include <valarray>
 #include <fstream>
+#include <memory>
 
 #include <boost/astronomy/io/hdu.hpp>
-#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/image_data_unit.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
 
 namespace boost
 {
@@ -18,74 +18,54 @@ namespace boost
         namespace io
         {
             template <bitpix DataType>
-            struct primary_hdu : public boost::astronomy::io::hdu
+            struct primary_hdu : public boost::astronomy::io::hdu,
+                public boost::astronomy::io::image_data_unit<primary_hdu<DataType>, DataType>
             {
             protected:
+                typedef boost::astronomy::io::image_data_unit<primary_hdu<DataType>, DataType> data_unit;
+
                 bool simple; //!Stores the value of SIMPLE
                 bool extend; //!Stores the value of EXTEND
-                image<DataType> data; //!stores the image of primary HDU if any
-                
+
             public:
                 primary_hdu() {}
 
                 //!This constructore should be used when file is never read and boost::astronomy::io::hdu object is not created of the file
                 primary_hdu(std::fstream &file) : hdu(file)
                 {
-                    //primary header always starts at the begining of the file
-                    file.seekg(0);
                     simple = this->value_of<bool>("SIMPLE");
-                    extend = this->value_of<bool>("EXTEND");
-
-                    //read image according to dimension specified by naxis
-                    switch (this->naxis())
-                    {
-                    case 0:
-                        break;
-                    case 1:
-                        data.read_image(file, this->naxis(1), 1);
-                        break;
-                    case 2:
-                        data.read_image(file, this->naxis(1), this->naxis(2));
-                        break;
-                    default:
-                        data.read_image(file, this->naxis(1), std::accumulate(this->_naxis.begin()+1, this->_naxis.end(), 0, std::multiplies<std::size_t>()));
-                        break;
-                    }
+                    extend = this->value_of<bool>("EXTEND", true);
 
+                    this->read_data_unit(file);
                     set_unit_end(file);    //set cursor to the end of the HDU unit
                 }
 
                 //!This constructore should be used when boost::astronomy::io::hdu object already exist for the file 
                 primary_hdu(std::fstream &file, hdu const& other) : hdu(other)
                 {
-                    //primary header always starts at the begining of the file
-                    file.seekg(0);
                     simple = this->value_of<bool>("SIMPLE");
-                    extend = this->value_of<bool>("EXTEND");
-
-                    //read image according to dimension specified by naxis
-                    switch (this->naxis())
-                    {
-                    case 0:
-                        break;
-                    case 1:
-                        data.read_image(file, this->naxis(1), 1);
-                        break;
-                    case 2:
-                        data.read_image(file, this->naxis(1), this->naxis(2));
-                        break;
-                    default:
-                        data.read_image(file, this->naxis(1), std::accumulate(this->_naxis.begin() + 1, this->_naxis.end(), 0, std::multiplies<std::size_t>()));
-                        break;
-                    }
+                    extend = this->value_of<bool>("EXTEND", true);
 
+                    this->read_data_unit(file);
                     set_unit_end(file);    //set cursor to the end of the HDU unit
                 }
 
-                //!returnes the stored data
-                image<DataType> get_data() const
+                //!This constructor should be used when the file is memory mapped, offset is the position of data unit in the file
+                //!image data is not copied, it is converted only when accessed through get_view() or get_data()
+                primary_hdu(std::shared_ptr<mapped_file const> const& file, std::size_t offset, hdu const& other) :
+                    hdu(other), data_unit(file, offset, other)
+                {
+                    simple = this->value_of<bool>("SIMPLE");
+                    extend = this->value_of<bool>("EXTEND", true);
+                }
+
+                //!This constructor should be used when data unit is read on demand, offset is the position of data unit in path
+                //!image is read from the file on the first call to get_data() or load_data()
+                primary_hdu(std::string const& path, std::size_t offset, hdu const& other) :
+                    hdu(other), data_unit(path, offset, other)
                 {
-                    return this->data;
+                    simple = this->value_of<bool>("SIMPLE");
+                    extend = this->value_of<bool>("EXTEND", true);
                 }
 
                 //!value of SIMPLE 
@@ -106,4 +86,3 @@ namespace boost
 
 
 #endif // !BOOST_ASTRONOMY_IO_PRIMARY_HDU_HPP
-
@@ -0,0 +1,283 @@
+#ifndef BOOST_ASTRONOMY_IO_SOURCE_DETECTION_HPP
+#define BOOST_ASTRONOMY_IO_SOURCE_DETECTION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <boost/astronomy/detail/connected_runs.hpp>
+#include <boost/astronomy/detail/parallel_for.hpp>
+#include <boost/astronomy/io/image.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!parameters of detect_sources()
+            struct detection_options
+            {
+                double threshold = 0; //!pixels with a value above threshold belong to sources, NaN pixels never do
+                std::size_t min_area = 1; //!sources with fewer pixels are left out
+                bool eight_connected = true; //!pixels touching at a corner are connected, otherwise only at a side
+                std::size_t threads = 0; //!number of threads (0 uses all hardware threads)
+            };
+
+            //!sources found by detect_sources(), one column per quantity and one row per source
+            //!rows and columns are the indices of image_buffer, moments are weighted by the pixel values
+            //!(which should have the background subtracted) and are NaN for a source without positive flux
+            struct source_table
+            {
+                std::vector<std::size_t> area; //!number of pixels
+                std::vector<double> flux; //!sum of the pixel values
+                std::vector<double> peak; //!largest pixel value
+                std::vector<double> centroid_row;
+                std::vector<double> centroid_column;
+                std::vector<double> row_variance; //!second central moment along the columns of the image
+                std::vector<double> column_variance; //!second central moment along the rows of the image
+                std::vector<double> covariance; //!mixed second central moment
+                std::vector<std::size_t> first_row; //!bounding box, all the bounds are included
+                std::vector<std::size_t> last_row;
+                std::vector<std::size_t> first_column;
+                std::vector<std::size_t> last_column;
+
+                //!returns the number of sources
+                std::size_t size() const
+                {
+                    return this->area.size();
+                }
+            };
+
+            ///@cond INTERNAL
+            namespace source_detail
+            {
+                //!runs of the rows of one strip of the image, labelled within the strip
+                struct strip_runs
+                {
+                    std::vector<boost::astronomy::detail::pixel_run> runs;
+                    std::vector<std::size_t> row_start; //!first run of every row of the strip and the end
+                    std::vector<std::size_t> parent; //!union-find forest of the runs (indices within the strip)
+                };
+
+                //!sums of a source built from its runs
+                struct source_sums
+                {
+                    std::size_t area = 0;
+                    double flux = 0;
+                    double peak = -(std::numeric_limits<double>::max)();
+                    double row_flux = 0;
+                    double row2_flux = 0;
+                    double column_flux = 0;
+                    double column2_flux = 0;
+                    double row_column_flux = 0;
+                    std::size_t first_row = 0;
+                    std::size_t last_row = 0;
+                    std::size_t first_column = (std::numeric_limits<std::size_t>::max)();
+                    std::size_t last_column = 0;
+
+                    void add(boost::astronomy::detail::pixel_run const& run)
+                    {
+                        double const row = static_cast<double>(run.row);
+                        if (this->area == 0)
+                        {
+                            this->first_row = run.row;
+                        }
+                        this->area += run.last - run.first;
+                        this->flux += run.flux;
+                        this->peak = (std::max)(this->peak, run.peak);
+                        this->row_flux += row * run.flux;
+                        this->row2_flux += row * row * run.flux;
+                        this->column_flux += run.column_flux;
+                        this->column2_flux += run.column2_flux;
+                        this->row_column_flux += row * run.column_flux;
+                        this->last_row = run.row;
+                        this->first_column = (std::min)(this->first_column, run.first);
+                        this->last_column = (std::max)(this->last_column, run.last - 1);
+                    }
+                };
+
+                //!finds the runs of pixels above the threshold in rows [first_row, last_row) and joins the runs
+                //!of consecutive rows, the moments of every run are summed while its pixels are in cache
+                template <typename PixelType>
+                void label_strip(PixelType const* pixels, std::size_t width, std::size_t first_row, std::size_t last_row,
+                    detection_options const& options, strip_runs& strip)
+                {
+                    std::size_t const diagonal = options.eight_connected ? 1 : 0;
+                    for (std::size_t row = first_row; row < last_row; row++)
+                    {
+                        std::size_t const row_first_run = strip.runs.size();
+                        strip.row_start.push_back(row_first_run);
+                        PixelType const* line = pixels + row * width;
+                        std::size_t column = 0;
+                        while (true)
+                        {
+                            while (column < width && !(static_cast<double>(line[column]) > options.threshold))
+                            {
+                                column++;
+                            }
+                            if (column == width)
+                            {
+                                break;
+                            }
+
+                            boost::astronomy::detail::pixel_run run = {row, column, column, 0, 0, 0, static_cast<double>(line[column])};
+                            for (; column < width && static_cast<double>(line[column]) > options.threshold; column++)
+                            {
+                                double const value = static_cast<double>(line[column]);
+                                double const position = static_cast<double>(column);
+                                run.flux += value;
+                                run.column_flux += value * position;
+                                run.column2_flux += value * position * position;
+                                run.peak = (std::max)(run.peak, value);
+                            }
+                            run.last = column;
+                            strip.parent.push_back(strip.runs.size());
+                            strip.runs.push_back(run);
+                        }
+
+                        if (row > first_row)
+                        {
+                            std::size_t const above_first_run = strip.row_start[row - first_row - 1];
+                            boost::astronomy::detail::join_rows(strip.parent,
+                                strip.runs.data() + above_first_run, row_first_run - above_first_run, above_first_run,
+                                strip.runs.data() + row_first_run, strip.runs.size() - row_first_run, row_first_run, diagonal);
+                        }
+                    }
+                    strip.row_start.push_back(strip.runs.size());
+                }
+            } //namespace source_detail
+            ///@endcond
+
+            //!finds the connected groups of pixels above options.threshold and measures them
+            //!the rows are split in strips labelled in parallel by union-find over runs of pixels, the strips are then
+            //!joined along their boundaries; sources are in the order of their first pixel (row by row)
+            //!if labels is given it is set to the size of the image and every pixel is set to the row of its
+            //!source in the table plus 1, or 0 for pixels of no source
+            template <typename PixelType>
+            source_table detect_sources(image_buffer<PixelType> const& frame, detection_options const& options,
+                image_buffer<std::int32_t>* labels)
+            {
+                std::size_t const width = frame.get_width(), height = frame.get_height();
+                PixelType const* pixels = frame.raw_data();
+
+                std::size_t const strip_height = width == 0 ? height : (std::max)(std::size_t(1), (std::size_t(1) << 18) / width);
+                std::size_t const strip_count = height == 0 ? 0 : (height + strip_height - 1) / strip_height;
+                std::vector<source_detail::strip_runs> strips(strip_count);
+                boost::astronomy::detail::parallel_for(strip_count, [&](std::size_t s)
+                {
+                    source_detail::label_strip(pixels, width, s * strip_height,
+                        (std::min)(height, (s + 1) * strip_height), options, strips[s]);
+                }, options.threads);
+
+                //the runs are numbered strip after strip, so parents stay below their runs in the whole image
+                std::vector<std::size_t> offset(strip_count + 1, 0);
+                for (std::size_t s = 0; s < strip_count; s++)
+                {
+                    offset[s + 1] = offset[s] + strips[s].runs.size();
+                }
+                std::vector<std::size_t> parent(offset[strip_count]);
+                boost::astronomy::detail::parallel_for(strip_count, [&](std::size_t s)
+                {
+                    for (std::size_t run = 0; run < strips[s].parent.size(); run++)
+                    {
+                        parent[offset[s] + run] = offset[s] + strips[s].parent[run];
+                    }
+                }, options.threads);
+
+                std::size_t const diagonal = options.eight_connected ? 1 : 0;
+                for (std::size_t s = 1; s < strip_count; s++)
+                {
+                    source_detail::strip_runs const& above = strips[s - 1];
+                    std::size_t const above_first_run = above.row_start[above.row_start.size() - 2];
+                    boost::astronomy::detail::join_rows(parent, above.runs.data() + above_first_run, above.runs.size() - above_first_run,
+                        offset[s - 1] + above_first_run, strips[s].runs.data(), strips[s].row_start[1], offset[s], diagonal);
+                }
+
+                //every parent is below its run, so one pass in order links every run to its root
+                //and the roots get their source numbers in the order of their first pixel
+                std::vector<std::size_t> source_of(parent.size());
+                std::vector<source_detail::source_sums> sums;
+                for (std::size_t s = 0; s < strip_count; s++)
+                {
+                    for (std::size_t run = 0; run < strips[s].runs.size(); run++)
+                    {
+                        std::size_t const index = offset[s] + run;
+                        std::size_t const root = parent[parent[index]];
+                        parent[index] = root;
+                        if (root == index)
+                        {
+                            source_of[index] = sums.size();
+                            sums.push_back(source_detail::source_sums());
+                        }
+                        else
+                        {
+                            source_of[index] = source_of[root];
+                        }
+                        sums[source_of[index]].add(strips[s].runs[run]);
+                    }
+                }
+
+                source_table table;
+                std::vector<std::int32_t> row_of(sums.size(), 0);
+                for (std::size_t source = 0; source < sums.size(); source++)
+                {
+                    source_detail::source_sums const& sum = sums[source];
+                    if (sum.area < options.min_area)
+                    {
+                        continue;
+                    }
+                    row_of[source] = static_cast<std::int32_t>(table.size() + 1);
+
+                    double const nan = std::numeric_limits<double>::quiet_NaN();
+                    bool const weighted = sum.flux > 0;
+                    double const row = weighted ? sum.row_flux / sum.flux : nan;
+                    double const column = weighted ? sum.column_flux / sum.flux : nan;
+                    table.area.push_back(sum.area);
+                    table.flux.push_back(sum.flux);
+                    table.peak.push_back(sum.peak);
+                    table.centroid_row.push_back(row);
+                    table.centroid_column.push_back(column);
+                    table.row_variance.push_back(weighted ? sum.row2_flux / sum.flux - row * row : nan);
+                    table.column_variance.push_back(weighted ? sum.column2_flux / sum.flux - column * column : nan);
+                    table.covariance.push_back(weighted ? sum.row_column_flux / sum.flux - row * column : nan);
+                    table.first_row.push_back(sum.first_row);
+                    table.last_row.push_back(sum.last_row);
+                    table.first_column.push_back(sum.first_column);
+                    table.last_column.push_back(sum.last_column);
+                }
+
+                if (labels != nullptr)
+                {
+                    labels->set_size(width, height);
+                    std::int32_t* label = labels->raw_data();
+                    boost::astronomy::detail::parallel_for(strip_count, [&](std::size_t s)
+                    {
+                        std::size_t const first_row = s * strip_height;
+                        std::size_t const last_row = (std::min)(height, first_row + strip_height);
+                        std::fill(label + first_row * width, label + last_row * width, 0);
+                        for (std::size_t run = 0; run < strips[s].runs.size(); run++)
+                        {
+                            boost::astronomy::detail::pixel_run const& pixels_of_run = strips[s].runs[run];
+                            std::fill(label + pixels_of_run.row * width + pixels_of_run.first,
+                                label + pixels_of_run.row * width + pixels_of_run.last, row_of[source_of[offset[s] + run]]);
+                        }
+                    }, options.threads);
+                }
+                return table;
+            }
+
+            //!finds the connected groups of pixels above options.threshold and measures them, see above
+            template <typename PixelType>
+            source_table detect_sources(image_buffer<PixelType> const& frame,
+                detection_options const& options = detection_options())
+            {
+                return detect_sources(frame, options, nullptr);
+            }
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_SOURCE_DETECTION_HPP
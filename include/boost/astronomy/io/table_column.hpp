@@ -0,0 +1,385 @@
+#ifndef BOOST_ASTRONOMY_IO_TABLE_COLUMN_HPP
+#define BOOST_ASTRONOMY_IO_TABLE_COLUMN_HPP
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+#include <boost/align/aligned_allocator.hpp>
+
+#include <boost/astronomy/io/column_format.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/detail/byteswap.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!maps the C++ type of column elements to the TFORM data types stored with that type
+            template <typename T>
+            struct column_type
+            {
+                static bool matches(char) { return false; }
+            };
+
+            template <>
+            struct column_type<bool>
+            {
+                static bool matches(char type) { return type == 'L'; }
+            };
+
+            //!bit columns (X) are stored packed, 8 bits per byte with the first bit in the most significant bit
+            template <>
+            struct column_type<std::uint8_t>
+            {
+                static bool matches(char type) { return type == 'B' || type == 'X'; }
+            };
+
+            template <>
+            struct column_type<char>
+            {
+                static bool matches(char type) { return type == 'A'; }
+            };
+
+            template <>
+            struct column_type<std::int16_t>
+            {
+                static bool matches(char type) { return type == 'I'; }
+            };
+
+            template <>
+            struct column_type<std::int32_t>
+            {
+                static bool matches(char type) { return type == 'J'; }
+            };
+
+            template <>
+            struct column_type<std::int64_t>
+            {
+                static bool matches(char type) { return type == 'K'; }
+            };
+
+            template <>
+            struct column_type<float>
+            {
+                static bool matches(char type) { return type == 'E'; }
+            };
+
+            template <>
+            struct column_type<double>
+            {
+                static bool matches(char type) { return type == 'D'; }
+            };
+
+            template <>
+            struct column_type<std::complex<float>>
+            {
+                static bool matches(char type) { return type == 'C'; }
+            };
+
+            template <>
+            struct column_type<std::complex<double>>
+            {
+                static bool matches(char type) { return type == 'M'; }
+            };
+
+            //!values of one field of a table for a range of rows, stored contiguously in native byte order
+            //!fixed width fields hold repeat elements per row, variable length arrays (P, Q) are stored one after
+            //!the other and the position of the elements of every row is kept in offsets
+            struct table_column
+            {
+            protected:
+                typedef std::vector<unsigned char, boost::alignment::aligned_allocator<unsigned char, 64>> storage;
+
+                column_format format; //!format of the field in the table
+                std::size_t rows = 0; //!number of rows in the column
+                storage values; //!elements of all the rows
+                std::vector<std::size_t> offsets; //!first element of every row and the end (variable length arrays)
+                std::vector<std::uint64_t> descriptors; //!element count and heap offset of every row until the heap is read
+
+            public:
+                table_column() {}
+
+                //!creates the column of field_format for row_count rows, fixed width values are allocated but not filled
+                table_column(column_format const& field_format, std::size_t row_count) :
+                    format(field_format), rows(row_count)
+                {
+                    if (is_variable())
+                    {
+                        this->descriptors.resize(2 * this->rows);
+                    }
+                    else
+                    {
+                        this->values.resize(this->rows * this->format.size);
+                    }
+                }
+
+                //!returns the format of the field (TFORMn, TTYPEn)
+                column_format const& get_format() const
+                {
+                    return this->format;
+                }
+
+                //!returns the name of the column (TTYPEn)
+                std::string const& get_name() const
+                {
+                    return this->format.name;
+                }
+
+                //!returns the data type of the elements stored (array_type for variable length arrays)
+                char element_type() const
+                {
+                    return is_variable() ? this->format.array_type : this->format.type;
+                }
+
+                //!true for variable length array columns (P and Q)
+                bool is_variable() const
+                {
+                    return this->format.array_type != 0;
+                }
+
+                //!returns the number of rows
+                std::size_t get_rows() const
+                {
+                    return this->rows;
+                }
+
+                //!returns the total number of elements stored (bytes for bit columns)
+                std::size_t element_count() const
+                {
+                    std::size_t size = column_format::element_size(element_type());
+                    return size == 0 ? this->values.size() : this->values.size() / size;
+                }
+
+                //!returns the number of elements in row (bytes for bit columns)
+                std::size_t element_count(std::size_t row) const
+                {
+                    if (is_variable())
+                    {
+                        return this->offsets[row + 1] - this->offsets[row];
+                    }
+                    return this->format.type == 'X' ? this->format.size : this->format.repeat;
+                }
+
+                //!returns all the elements of the column, T must match the data type of the column
+                //!(bool for L, std::uint8_t for B and X, char for A, std::int16_t for I, std::int32_t for J,
+                //!std::int64_t for K, float for E, double for D, std::complex<float> for C, std::complex<double> for M)
+                template <typename T>
+                T const* data() const
+                {
+                    if (!column_type<T>::matches(element_type()))
+                    {
+                        throw column_type_exception();
+                    }
+                    return reinterpret_cast<T const*>(this->values.data());
+                }
+
+                //!returns all the elements of the column for writing, T must match the data type of the column
+                template <typename T>
+                T* data()
+                {
+                    if (!column_type<T>::matches(element_type()))
+                    {
+                        throw column_type_exception();
+                    }
+                    return reinterpret_cast<T*>(this->values.data());
+                }
+
+                //!returns the elements of row, there are element_count(row) of them
+                template <typename T>
+                T const* row(std::size_t row) const
+                {
+                    return data<T>() + first_element(row);
+                }
+
+                //!returns the value of row as a single element
+                template <typename T>
+                T value(std::size_t row) const
+                {
+                    return *this->row<T>(row);
+                }
+
+                //!returns the string of a character column (A) in row without trailing spaces and what follows a NUL
+                std::string string(std::size_t row) const
+                {
+                    char const* text = this->row<char>(row);
+                    std::size_t length = element_count(row);
+                    length = static_cast<std::size_t>(std::find(text, text + length, '\0') - text);
+                    while (length > 0 && text[length - 1] == ' ')
+                    {
+                        length--;
+                    }
+                    return std::string(text, length);
+                }
+
+                //!returns bit number bit (0 is the first) of a bit column (X) in row
+                bool bit(std::size_t row, std::size_t bit) const
+                {
+                    return ((this->row<std::uint8_t>(row)[bit / 8] >> (7 - bit % 8)) & 1) != 0;
+                }
+
+                //!copies the field of count rows into the column starting at column row target and converts them to
+                //!native byte order, fields points to the big-endian field of the first row and the next rows follow
+                //!every stride bytes, variable length arrays only record their descriptors, the elements are read by read_heap()
+                void assign_rows(char const* fields, std::size_t stride, std::size_t count, std::size_t target)
+                {
+                    if (is_variable())
+                    {
+                        for (std::size_t i = 0; i < count; i++)
+                        {
+                            read_descriptor(fields + i * stride, this->descriptors[2 * (target + i)],
+                                this->descriptors[2 * (target + i) + 1]);
+                        }
+                        return;
+                    }
+
+                    std::size_t const size = this->format.size;
+                    unsigned char* output = this->values.data() + target * size;
+                    if (size == stride)
+                    {
+                        std::memcpy(output, fields, count * size);
+                    }
+                    else
+                    {
+                        for (std::size_t i = 0; i < count; i++)
+                        {
+                            std::memcpy(output + i * size, fields + i * stride, size);
+                        }
+                    }
+                    to_native(output, count * this->format.repeat, this->format.type);
+                }
+
+                //!returns the range of the heap [first, last) holding the elements of the variable length arrays
+                //!relative to the start of the heap, (0, 0) if there are none
+                std::pair<std::uint64_t, std::uint64_t> heap_range() const
+                {
+                    std::uint64_t first = 0, last = 0;
+                    std::size_t const size = column_format::element_size(this->format.array_type);
+                    for (std::size_t i = 0; i < this->descriptors.size(); i += 2)
+                    {
+                        if (this->descriptors[i] == 0)
+                        {
+                            continue;
+                        }
+                        std::uint64_t end = this->descriptors[i + 1] + this->descriptors[i] * size;
+                        first = last == 0 ? this->descriptors[i + 1] : (std::min)(first, this->descriptors[i + 1]);
+                        last = (std::max)(last, end);
+                    }
+                    return std::make_pair(first, last);
+                }
+
+                //!copies the elements of the variable length arrays from heap, which holds heap_size bytes of the heap
+                //!starting at heap_start, and converts them to native byte order
+                void read_heap(char const* heap, std::uint64_t heap_start, std::uint64_t heap_size)
+                {
+                    if (!is_variable())
+                    {
+                        return;
+                    }
+
+                    std::size_t const size = column_format::element_size(this->format.array_type);
+                    this->offsets.assign(this->rows + 1, 0);
+                    for (std::size_t i = 0; i < this->rows; i++)
+                    {
+                        this->offsets[i + 1] = this->offsets[i] + static_cast<std::size_t>(this->descriptors[2 * i]);
+                    }
+
+                    this->values.resize(this->offsets.back() * size);
+                    for (std::size_t i = 0; i < this->rows; i++)
+                    {
+                        std::uint64_t const count = this->descriptors[2 * i];
+                        std::uint64_t const offset = this->descriptors[2 * i + 1];
+                        if (count == 0)
+                        {
+                            continue;
+                        }
+                        if (offset < heap_start || offset - heap_start + count * size > heap_size)
+                        {
+                            throw fits_exception();
+                        }
+                        std::memcpy(this->values.data() + this->offsets[i] * size, heap + (offset - heap_start),
+                            static_cast<std::size_t>(count * size));
+                    }
+                    to_native(this->values.data(), this->offsets.back(), this->format.array_type);
+                    std::vector<std::uint64_t>().swap(this->descriptors);
+                }
+
+            protected:
+                std::size_t first_element(std::size_t row) const
+                {
+                    return is_variable() ? this->offsets[row] : row * element_count(row);
+                }
+
+                void read_descriptor(char const* field, std::uint64_t& count, std::uint64_t& offset) const
+                {
+                    if (this->format.type == 'P')
+                    {
+                        std::uint32_t words[2];
+                        std::memcpy(words, field, 8);
+                        boost::astronomy::detail::big_to_native_inplace(words, 2);
+                        count = words[0];
+                        offset = words[1];
+                    }
+                    else
+                    {
+                        std::uint64_t words[2];
+                        std::memcpy(words, field, 16);
+                        boost::astronomy::detail::big_to_native_inplace(words, 2);
+                        count = words[0];
+                        offset = words[1];
+                    }
+                }
+
+                //!converts count big-endian elements of type (a TFORM data type) to native representation in place
+                static void to_native(unsigned char* elements, std::size_t count, char type)
+                {
+                    using boost::astronomy::detail::reverse_bytes;
+                    if (type == 'L')
+                    {
+                        for (std::size_t i = 0; i < count; i++)
+                        {
+                            elements[i] = elements[i] == 'T' ? 1 : 0;
+                        }
+                        return;
+                    }
+                    if (boost::endian::order::native != boost::endian::order::little)
+                    {
+                        return;
+                    }
+
+                    switch (type)
+                    {
+                    case 'I':
+                        reverse_bytes<2>(elements, count);
+                        break;
+                    case 'J':
+                    case 'E':
+                        reverse_bytes<4>(elements, count);
+                        break;
+                    case 'K':
+                    case 'D':
+                        reverse_bytes<8>(elements, count);
+                        break;
+                    case 'C':
+                        reverse_bytes<4>(elements, 2 * count);
+                        break;
+                    case 'M':
+                        reverse_bytes<8>(elements, 2 * count);
+                        break;
+                    default:
+                        break;
+                    }
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_TABLE_COLUMN_HPP
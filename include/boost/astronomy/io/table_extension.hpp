@@ -0,0 +1,237 @@
+#ifndef BOOST_ASTRONOMY_IO_TABLE_EXTENSION_HPP
+#define BOOST_ASTRONOMY_IO_TABLE_EXTENSION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+
+#include <boost/astronomy/io/hdu.hpp>
+#include <boost/astronomy/io/extension_hdu.hpp>
+#include <boost/astronomy/io/table_column.hpp>
+#include <boost/astronomy/io/table_selection.hpp>
+#include <boost/astronomy/io/mapped_file.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+#include <boost/astronomy/detail/positional_file.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!columns, selection and data unit shared by ascii_table_extension and binary_table_extension
+            //!Table is the extension deriving from it (CRTP) which reads the layout of its fields of type Format
+            //!from the header in set_layout() and fills the columns in load_columns(read, threads) and load_mapped(threads)
+            template <typename Table, typename Format>
+            struct table_extension : public boost::astronomy::io::extension_hdu
+            {
+            protected:
+                std::vector<Format> formats; //!format of every field
+                std::size_t rows = 0; //!NAXIS2
+                std::size_t row_size = 0; //!NAXIS1
+                table_selection selection; //!columns and rows stored in the HDU
+
+                std::shared_ptr<char const> data_unit; //!data unit inside the mapped file if the HDU is mapped
+                std::string file_path; //!file from which the table is read on first access if the HDU is deferred
+                std::size_t data_offset = 0; //!position of data unit in file_path
+
+                mutable std::vector<std::size_t> column_indices; //!index of the field of every column read
+                mutable std::vector<table_column> columns; //!columns after the table is read
+                mutable bool loaded = false; //!false until the columns are read from the data unit
+
+                //!the HDU whose header other has just been read from a stream, see read_data_unit()
+                table_extension(hdu const& other, table_selection const& query) :
+                    extension_hdu(other), selection(query) {}
+
+                //!the table is accessed in the mapped file, offset is the position of data unit in the file
+                table_extension(std::shared_ptr<mapped_file const> const& file, std::size_t offset, hdu const& other,
+                    table_selection const& query) :
+                    extension_hdu(other), selection(query), data_unit(file, file->data() + offset) {}
+
+                //!the table is read on demand, offset is the position of data unit in path
+                table_extension(std::string const& path, std::size_t offset, hdu const& other, table_selection const& query) :
+                    extension_hdu(other), selection(query), file_path(path), data_offset(offset) {}
+
+            public:
+                //!returns the number of rows of the table (NAXIS2)
+                std::size_t get_row_count() const
+                {
+                    return this->rows;
+                }
+
+                //!returns the size of a row in the data unit in bytes (NAXIS1)
+                std::size_t get_row_size() const
+                {
+                    return this->row_size;
+                }
+
+                //!returns the number of fields of the table (TFIELDS)
+                std::size_t get_column_count() const
+                {
+                    return this->formats.size();
+                }
+
+                //!returns the format of every field, available without reading the table
+                std::vector<Format> const& get_formats() const
+                {
+                    return this->formats;
+                }
+
+                //!returns the columns and rows which are stored, row 0 of the columns is row selection.first_row of the table
+                table_selection const& get_selection() const
+                {
+                    return this->selection;
+                }
+
+                //!returns the index of the field named name (TTYPEn), throws column_not_found_exception if there is none
+                std::size_t column_index(std::string const& name) const
+                {
+                    for (std::size_t i = 0; i < this->formats.size(); i++)
+                    {
+                        if (this->formats[i].name == name)
+                        {
+                            return i;
+                        }
+                    }
+                    throw column_not_found_exception();
+                }
+
+                //!returns the column of the field at index (0 is the first field)
+                //!throws column_not_found_exception if the field is not selected
+                table_column const& get_column(std::size_t index) const
+                {
+                    load_data();
+                    for (std::size_t i = 0; i < this->column_indices.size(); i++)
+                    {
+                        if (this->column_indices[i] == index)
+                        {
+                            return this->columns[i];
+                        }
+                    }
+                    throw column_not_found_exception();
+                }
+
+                //!returns the column named name (TTYPEn)
+                table_column const& get_column(std::string const& name) const
+                {
+                    return get_column(column_index(name));
+                }
+
+                //!returns all the selected columns in the order of selection.columns (the order of the fields if all are selected)
+                std::vector<table_column> const& get_columns() const
+                {
+                    load_data();
+                    return this->columns;
+                }
+
+                //!reads the selected columns of a mapped or deferred HDU if they are not read yet
+                //!using up to threads threads (0 uses all hardware threads)
+                void load_data(std::size_t threads = 0) const
+                {
+                    if (this->loaded)
+                    {
+                        return;
+                    }
+
+                    if (this->data_unit)
+                    {
+                        table().load_mapped(threads);
+                        return;
+                    }
+                    boost::astronomy::detail::positional_file file(this->file_path);
+                    load_data(file, threads);
+                }
+
+                //!reads the selected columns of a deferred HDU using positional reads on file if they are not read yet
+                //!different HDUs can be loaded from the same file by different threads at the same time
+                void load_data(boost::astronomy::detail::positional_file const& file, std::size_t threads = 1) const
+                {
+                    if (!this->loaded)
+                    {
+                        table().load_columns(reader_of(file), threads);
+                    }
+                }
+
+                //!false if the columns have not been read yet
+                bool is_loaded() const
+                {
+                    return this->loaded;
+                }
+
+            protected:
+                //!reads bytes of the data unit of a deferred HDU at an offset from the start of data unit
+                struct positional_reader
+                {
+                    boost::astronomy::detail::positional_file const& file;
+                    std::size_t data_offset;
+
+                    positional_reader(boost::astronomy::detail::positional_file const& source, std::size_t unit_offset) :
+                        file(source), data_offset(unit_offset) {}
+
+                    void operator()(char* buffer, std::size_t size, std::uint64_t offset) const
+                    {
+                        this->file.read(buffer, size, this->data_offset + offset);
+                    }
+                };
+
+                Table const& table() const
+                {
+                    return static_cast<Table const&>(*this);
+                }
+
+                positional_reader reader_of(boost::astronomy::detail::positional_file const& file) const
+                {
+                    return positional_reader(file, this->data_offset);
+                }
+
+                //!reads the selected columns from the data unit starting at the current position of file
+                //!(threads share file under a lock) and leaves file at the end of data unit
+                void read_data_unit(std::fstream &file, std::size_t threads)
+                {
+                    std::streampos const start = file.tellg();
+                    std::mutex file_mutex;
+                    table().load_columns([&](char* buffer, std::size_t size, std::uint64_t offset)
+                    {
+                        std::lock_guard<std::mutex> lock(file_mutex);
+                        file.seekg(start + static_cast<std::streamoff>(offset));
+                        file.read(buffer, static_cast<std::streamsize>(size));
+                        if (!file)
+                        {
+                            throw fits_exception();
+                        }
+                    }, threads);
+                    file.seekg(start + static_cast<std::streamoff>(hdu::unit_size(this->data_size())));
+                }
+
+                //!returns the indices of the fields selected by query, all the fields if it names no column
+                std::vector<std::size_t> resolve(table_selection const& query) const
+                {
+                    std::vector<std::size_t> indices;
+                    for (std::string const& name : query.columns)
+                    {
+                        std::size_t index = column_index(name);
+                        if (std::find(indices.begin(), indices.end(), index) == indices.end())
+                        {
+                            indices.push_back(index);
+                        }
+                    }
+                    if (query.columns.empty())
+                    {
+                        for (std::size_t i = 0; i < this->formats.size(); i++)
+                        {
+                            indices.push_back(i);
+                        }
+                    }
+                    return indices;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_TABLE_EXTENSION_HPP
@@ -0,0 +1,46 @@
+#ifndef BOOST_ASTRONOMY_IO_TABLE_SELECTION_HPP
+#define BOOST_ASTRONOMY_IO_TABLE_SELECTION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!columns and range of rows of a table to be read, only the bytes of these fields are read and converted
+            struct table_selection
+            {
+                std::vector<std::string> columns; //!names (TTYPEn) of the columns to read, all the columns if empty
+                std::size_t first_row = 0; //!first row to read (0 is the first row of the table)
+                std::size_t row_count = (std::numeric_limits<std::size_t>::max)(); //!number of rows, clipped to the table
+
+                table_selection() {}
+
+                table_selection(std::vector<std::string> const& column_names, std::size_t first = 0,
+                    std::size_t count = (std::numeric_limits<std::size_t>::max)()) :
+                    columns(column_names), first_row(first), row_count(count) {}
+
+                //!true if the selection contains the whole table
+                bool is_whole_table() const
+                {
+                    return this->columns.empty() && this->first_row == 0 &&
+                        this->row_count == (std::numeric_limits<std::size_t>::max)();
+                }
+
+                //!returns the number of rows selected from a table of rows rows
+                std::size_t rows_in(std::size_t rows) const
+                {
+                    return this->first_row >= rows ? 0 : (std::min)(this->row_count, rows - this->first_row);
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_TABLE_SELECTION_HPP
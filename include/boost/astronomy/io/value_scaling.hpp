@@ -0,0 +1,157 @@
+#ifndef BOOST_ASTRONOMY_IO_VALUE_SCALING_HPP
+#define BOOST_ASTRONOMY_IO_VALUE_SCALING_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include <boost/astronomy/detail/byteswap.hpp>
+#include <boost/astronomy/exception/fits_exception.hpp>
+
+namespace boost
+{
+    namespace astronomy
+    {
+        namespace io
+        {
+            //!linear scaling from the values stored in a data unit to physical values (BSCALE, BZERO and BLANK)
+            //!physical = BSCALE * stored + BZERO, stored integers equal to BLANK are undefined
+            struct value_scaling
+            {
+                double scale = 1; //!BSCALE
+                double zero = 0; //!BZERO
+                bool has_blank = false; //!true if BLANK is defined
+                std::int64_t blank = 0; //!BLANK, the stored value of undefined pixels of integer images
+
+                value_scaling() {}
+
+                value_scaling(double bscale, double bzero) : scale(bscale), zero(bzero) {}
+
+                value_scaling(double bscale, double bzero, std::int64_t blank_value) :
+                    scale(bscale), zero(bzero), has_blank(true), blank(blank_value) {}
+
+                //!true if physical values are equal to stored values
+                bool is_identity() const
+                {
+                    return equals(this->scale, 1) && equals(this->zero, 0) && !this->has_blank;
+                }
+
+                //!true if physical values are stored values plus an integer (BSCALE = 1 and BZERO is an integer)
+                bool is_integer_offset() const
+                {
+                    return equals(this->scale, 1) && equals(this->zero, std::floor(this->zero)) &&
+                        std::fabs(this->zero) <= 9223372036854775807.0;
+                }
+
+                //!stores in output the physical values of count stored values of input (in native byte order)
+                //!floating point Physical types accept any scaling and undefined pixels are NaN
+                //!integer Physical types must have the size of Stored and the scaling must be an integer offset
+                //!(e.g. std::uint16_t for BITPIX = 16 and BZERO = 32768, std::uint32_t for BITPIX = 32 and BZERO = 2^31)
+                //!then the offset is added modulo the size of the type so undefined pixels are not marked
+                template <typename Stored, typename Physical>
+                void apply(Stored const* input, std::size_t count, Physical* output) const
+                {
+                    apply_to(input, count, output, std::integral_constant<bool,
+                        std::is_integral<Stored>::value && std::is_integral<Physical>::value>());
+                }
+
+                //!same as apply() for count big-endian stored values at bytes, the values are converted in blocks which
+                //!stay in cache between the byte order conversion and the scaling so data is traversed once
+                template <typename Stored, typename Physical>
+                void apply_big_endian(char const* bytes, std::size_t count, Physical* output) const
+                {
+                    std::size_t const block_size = 4096 / sizeof(Stored);
+                    Stored block[block_size];
+                    for (std::size_t i = 0; i < count; i += block_size)
+                    {
+                        std::size_t const block_count = (std::min)(block_size, count - i);
+                        std::memcpy(block, bytes + i * sizeof(Stored), block_count * sizeof(Stored));
+                        boost::astronomy::detail::big_to_native_inplace(block, block_count);
+                        apply(block, block_count, output + i);
+                    }
+                }
+
+            private:
+                static bool equals(double value, double expected)
+                {
+                    return !(value < expected) && !(value > expected);
+                }
+
+                //!integer stored values converted to integer physical values by adding BZERO
+                template <typename Stored, typename Physical>
+                void apply_to(Stored const* input, std::size_t count, Physical* output, std::true_type) const
+                {
+                    if (sizeof(Stored) != sizeof(Physical) || !is_integer_offset())
+                    {
+                        throw fits_exception();
+                    }
+
+                    typedef typename std::make_unsigned<Stored>::type unsigned_type;
+                    unsigned_type const offset = static_cast<unsigned_type>(static_cast<std::int64_t>(this->zero));
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        output[i] = static_cast<Physical>(static_cast<unsigned_type>(static_cast<unsigned_type>(input[i]) + offset));
+                    }
+                }
+
+                //!any stored values converted to floating point physical values
+                template <typename Stored, typename Physical>
+                void apply_to(Stored const* input, std::size_t count, Physical* output, std::false_type) const
+                {
+                    if (!std::is_floating_point<Physical>::value)
+                    {
+                        throw fits_exception();
+                    }
+
+                    if (this->has_blank && scale_with_blank(input, count, output, std::is_integral<Stored>()))
+                    {
+                        return;
+                    }
+
+                    double const a = this->scale;
+                    double const b = this->zero;
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        output[i] = static_cast<Physical>(static_cast<double>(input[i]) * a + b);
+                    }
+                }
+
+                //!stored integers equal to BLANK become NaN, the comparison is a select so the loop stays vectorizable
+                //!returns false without converting if BLANK is not in the range of Stored (no pixel can be undefined)
+                template <typename Stored, typename Physical>
+                bool scale_with_blank(Stored const* input, std::size_t count, Physical* output, std::true_type) const
+                {
+                    if (this->blank < static_cast<std::int64_t>((std::numeric_limits<Stored>::min)()) ||
+                        this->blank > static_cast<std::int64_t>((std::numeric_limits<Stored>::max)()))
+                    {
+                        return false;
+                    }
+
+                    double const a = this->scale;
+                    double const b = this->zero;
+                    Stored const blank_value = static_cast<Stored>(this->blank);
+                    Physical const undefined = std::numeric_limits<Physical>::quiet_NaN();
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        Physical const value = static_cast<Physical>(static_cast<double>(input[i]) * a + b);
+                        output[i] = input[i] == blank_value ? undefined : value;
+                    }
+                    return true;
+                }
+
+                //!BLANK does not apply to floating point stored values, undefined pixels are already NaN
+                template <typename Stored, typename Physical>
+                bool scale_with_blank(Stored const*, std::size_t, Physical*, std::false_type) const
+                {
+                    return false;
+                }
+            };
+        } //namespace io
+    } //namespace astronomy
+} //namespace boost
+
+#endif // !BOOST_ASTRONOMY_IO_VALUE_SCALING_HPP
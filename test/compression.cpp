@@ -0,0 +1,483 @@
+#define BOOST_TEST_DYN_LINK
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/astronomy/io/fits.hpp>
+
+#if defined(BOOST_ASTRONOMY_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+
+using namespace std;
+using namespace boost::astronomy::io;
+
+namespace
+{
+    //creates 80 char card with value right justified in columns 11-30 (or starting at column 11 for strings)
+    string make_card(string const& key, string const& value)
+    {
+        string result = key;
+        result.resize(8, ' ');
+        result += "= ";
+        result += value[0] == '\'' ? value : string(value.length() < 20 ? 20 - value.length() : 0, ' ') + value;
+        result.resize(80, ' ');
+        return result;
+    }
+
+    string pad(string bytes, char fill)
+    {
+        bytes.resize(((bytes.size() + 2879) / 2880) * 2880, fill);
+        return bytes;
+    }
+
+    template <typename T>
+    string big_endian(T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        return string(bytes, sizeof(T));
+    }
+
+    //writes bits most significant bit first
+    struct bit_writer
+    {
+        string bytes;
+        std::uint64_t bits = 0;
+        int count = 0;
+
+        void write(std::uint64_t value, int size)
+        {
+            for (int i = size - 1; i >= 0; i--)
+            {
+                bits = (bits << 1) | ((value >> i) & 1);
+                if (++count == 8)
+                {
+                    bytes += static_cast<char>(bits);
+                    bits = 0;
+                    count = 0;
+                }
+            }
+        }
+
+        string finish()
+        {
+            if (count > 0)
+            {
+                write(0, 8 - count);
+            }
+            return bytes;
+        }
+    };
+
+    //Rice compression as described by the tiled image convention, values are Bytes wide
+    template <int Bytes, typename T>
+    string rice_encode(vector<T> const& values, size_t block_size = 32)
+    {
+        int const fs_bits = Bytes == 1 ? 3 : (Bytes == 2 ? 4 : 5);
+        int const fs_max = Bytes == 1 ? 6 : (Bytes == 2 ? 14 : 25);
+        int const value_bits = 8 * Bytes;
+        std::uint64_t const mask = (std::uint64_t(1) << value_bits) - 1;
+
+        bit_writer writer;
+        std::uint64_t last = static_cast<std::uint64_t>(static_cast<std::int64_t>(values[0])) & mask;
+        writer.write(last, value_bits);
+
+        for (size_t i = 0; i < values.size(); i += block_size)
+        {
+            size_t const end = (std::min)(values.size(), i + block_size);
+            vector<std::uint64_t> mapped;
+            std::uint64_t sum = 0;
+            for (size_t j = i; j < end; j++)
+            {
+                std::uint64_t value = static_cast<std::uint64_t>(static_cast<std::int64_t>(values[j])) & mask;
+                std::int64_t difference = static_cast<std::int64_t>((value - last) & mask);
+                if (difference >= (std::int64_t(1) << (value_bits - 1)))
+                {
+                    difference -= std::int64_t(1) << value_bits;
+                }
+                mapped.push_back(difference < 0 ? static_cast<std::uint64_t>(-2 * difference - 1) : static_cast<std::uint64_t>(2 * difference));
+                sum += mapped.back();
+                last = value;
+            }
+
+            int fs = 0;
+            std::uint64_t mean = sum / mapped.size();
+            while ((mean >> fs) > 1)
+            {
+                fs++;
+            }
+
+            if (sum == 0)
+            {
+                writer.write(0, fs_bits);
+            }
+            else if (fs >= fs_max)
+            {
+                writer.write(static_cast<std::uint64_t>(fs_max + 1), fs_bits);
+                for (std::uint64_t value : mapped)
+                {
+                    writer.write(value, value_bits);
+                }
+            }
+            else
+            {
+                writer.write(static_cast<std::uint64_t>(fs + 1), fs_bits);
+                for (std::uint64_t value : mapped)
+                {
+                    writer.write(0, static_cast<int>(value >> fs));
+                    writer.write(1, 1);
+                    writer.write(value & ((std::uint64_t(1) << fs) - 1), fs);
+                }
+            }
+        }
+        return writer.finish();
+    }
+
+    //splits pixels of image width x height (planes of plane_height rows) into tiles of tile_width x tile_height
+    template <typename T>
+    vector<vector<T>> split_tiles(vector<T> const& pixels, size_t width, size_t height, size_t plane_height,
+        size_t tile_width, size_t tile_height)
+    {
+        vector<vector<T>> tiles;
+        for (size_t plane = 0; plane < height; plane += plane_height)
+        {
+            for (size_t row = 0; row < plane_height; row += tile_height)
+            {
+                for (size_t column = 0; column < width; column += tile_width)
+                {
+                    tiles.emplace_back();
+                    for (size_t r = row; r < (std::min)(row + tile_height, plane_height); r++)
+                    {
+                        for (size_t c = column; c < (std::min)(column + tile_width, width); c++)
+                        {
+                            tiles.back().push_back(pixels[(plane + r) * width + c]);
+                        }
+                    }
+                }
+            }
+        }
+        return tiles;
+    }
+
+    //returns a file with an empty primary HDU and a compressed image HDU whose table rows hold tiles
+    //(and ZSCALE, ZZERO of every tile if scales is not empty), keywords are the Z keywords of the image
+    string compressed_file(string const& keywords, vector<string> const& tiles,
+        vector<double> const& scales = vector<double>(), vector<double> const& zeros = vector<double>())
+    {
+        bool const quantized = !scales.empty();
+        size_t longest = 0;
+        string table, heap;
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            table += big_endian(static_cast<std::int32_t>(tiles[i].size())) + big_endian(static_cast<std::int32_t>(heap.size()));
+            if (quantized)
+            {
+                table += big_endian(scales[i]) + big_endian(zeros[i]);
+            }
+            heap += tiles[i];
+            longest = (std::max)(longest, tiles[i].size());
+        }
+
+        string header = make_card("XTENSION", "'BINTABLE'") + make_card("BITPIX", "8") + make_card("NAXIS", "2") +
+            make_card("NAXIS1", to_string(quantized ? 24 : 8)) + make_card("NAXIS2", to_string(tiles.size())) +
+            make_card("PCOUNT", to_string(heap.size())) + make_card("GCOUNT", "1") +
+            make_card("TFIELDS", quantized ? "3" : "1") + make_card("TTYPE1", "'COMPRESSED_DATA'") +
+            make_card("TFORM1", "'1PB(" + to_string(longest) + ")'");
+        if (quantized)
+        {
+            header += make_card("TTYPE2", "'ZSCALE  '") + make_card("TFORM2", "'1D      '") +
+                make_card("TTYPE3", "'ZZERO   '") + make_card("TFORM3", "'1D      '");
+        }
+        header += make_card("ZIMAGE", "T") + keywords + string("END").append(77, ' ');
+
+        string primary = make_card("SIMPLE", "T") + make_card("BITPIX", "8") + make_card("NAXIS", "0") +
+            make_card("EXTEND", "T") + string("END").append(77, ' ');
+        return pad(primary, ' ') + pad(header, ' ') + pad(table + heap, '\0');
+    }
+
+    string const sample_file = "test_compressed.fits";
+
+    void write_file(string const& bytes)
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << bytes;
+    }
+
+    template <typename T>
+    bool same_bits(T a, T b)
+    {
+        return std::memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    //checks that image (or its region at x, y) has the expected pixels of an image expected_width wide
+    template <bitpix DataType, typename T>
+    void check_image(image<DataType> img, vector<T> const& expected, size_t expected_width,
+        size_t x = 0, size_t y = 0)
+    {
+        size_t mismatches = 0;
+        for (size_t r = 0; r < img.get_height(); r++)
+        {
+            for (size_t c = 0; c < img.get_width(); c++)
+            {
+                if (!same_bits(img(r, c), expected[(x + r) * expected_width + y + c]))
+                {
+                    mismatches++;
+                }
+            }
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+    }
+
+    //reads the compressed image of sample_file in every read mode and compares it with pixels
+    template <bitpix DataType, typename T>
+    void check_all_modes(vector<T> const& pixels, size_t width, size_t height)
+    {
+        std::shared_ptr<hdu> compressed;
+        {
+            fits file(sample_file);
+            file.read_extensions();
+            BOOST_REQUIRE_EQUAL(file.hdu_count(), 2u);
+            compressed = file.get_hdu(1);
+        }
+        fits mapped(sample_file, fits::mapped);
+        fits deferred(sample_file, fits::deferred);
+
+        for (std::shared_ptr<hdu> const& header : {compressed, mapped.get_hdu(1), deferred.get_hdu(1)})
+        {
+            BOOST_REQUIRE_EQUAL(header->value_of<int>("ZBITPIX"), header_value(DataType));
+            compressed_image_extension<DataType>& typed = static_cast<compressed_image_extension<DataType>&>(*header);
+            BOOST_CHECK_EQUAL(typed.get_width(), width);
+            BOOST_CHECK_EQUAL(typed.get_height(), height);
+
+            //regions before and after the whole image is decompressed
+            check_image(typed.get_region(1, 2, width - 3, height / 2), pixels, width, 1, 2);
+            check_image(typed.get_region(height - 1, 0, width, 1), pixels, width, height - 1, 0);
+            image<DataType> whole = typed.get_data(2);
+            BOOST_CHECK_EQUAL(whole.get_width(), width);
+            BOOST_CHECK_EQUAL(whole.get_height(), height);
+            check_image(whole, pixels, width);
+            check_image(typed.get_region(2, 1, 3, 2), pixels, width, 2, 1);
+            BOOST_CHECK_THROW(typed.get_region(height, 0, 1, 1), boost::astronomy::region_out_of_range_exception);
+        }
+    }
+
+    //the random sequence of the tiled image convention
+    vector<float> dither_sequence()
+    {
+        vector<float> random;
+        double seed = 1;
+        for (int i = 0; i < 10000; i++)
+        {
+            double product = 16807.0 * seed;
+            seed = product - 2147483647.0 * static_cast<double>(static_cast<std::int64_t>(product / 2147483647.0));
+            random.push_back(static_cast<float>(seed / 2147483647.0));
+        }
+        //value given by the convention to check implementations of the generator
+        BOOST_REQUIRE_EQUAL(static_cast<std::int64_t>(seed), 1043618065);
+        return random;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(tile_compression)
+
+BOOST_AUTO_TEST_CASE(rice_short_tiles)
+{
+    //10 x 4 tiles, partial at the right and bottom edges
+    size_t const width = 37, height = 23;
+    vector<std::int16_t> pixels(width * height);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        size_t row = i / width, column = i % width;
+        if (row < 8 && column < 20)
+        {
+            pixels[i] = 1000; //constant blocks
+        }
+        else if (row < 16)
+        {
+            pixels[i] = static_cast<std::int16_t>(row * 37 - column * 11); //smooth
+        }
+        else
+        {
+            pixels[i] = static_cast<std::int16_t>((i * 2654435761u) >> 13); //noise
+        }
+    }
+
+    vector<string> tiles;
+    for (vector<std::int16_t> const& tile : split_tiles(pixels, width, height, height, 10, 4))
+    {
+        tiles.push_back(rice_encode<2>(tile, 16));
+    }
+    write_file(compressed_file(make_card("ZBITPIX", "16") + make_card("ZNAXIS", "2") + make_card("ZNAXIS1", "37") +
+        make_card("ZNAXIS2", "23") + make_card("ZTILE1", "10") + make_card("ZTILE2", "4") +
+        make_card("ZCMPTYPE", "'RICE_1  '") + make_card("ZNAME1", "'BLOCKSIZE'") + make_card("ZVAL1", "16") +
+        make_card("ZNAME2", "'BYTEPIX '") + make_card("ZVAL2", "2"), tiles));
+
+    check_all_modes<B16>(pixels, width, height);
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(rice_int_and_byte_cubes)
+{
+    //three axes folded into rows, one tile per row (default tiling) and default BYTEPIX of 4
+    size_t const width = 13, plane_height = 5, height = 10;
+    vector<std::int32_t> pixels(width * height);
+    vector<std::uint8_t> bytes(width * height);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = i % 3 == 0 ? static_cast<std::int32_t>(i * 2654435761u) : static_cast<std::int32_t>(i) - 60;
+        bytes[i] = static_cast<std::uint8_t>(i * 7);
+    }
+
+    string const axes = make_card("ZNAXIS", "3") + make_card("ZNAXIS1", "13") + make_card("ZNAXIS2", "5") +
+        make_card("ZNAXIS3", "2") + make_card("ZCMPTYPE", "'RICE_1  '");
+
+    vector<string> tiles;
+    for (vector<std::int32_t> const& tile : split_tiles(pixels, width, height, plane_height, width, 1))
+    {
+        tiles.push_back(rice_encode<4>(tile));
+    }
+    write_file(compressed_file(make_card("ZBITPIX", "32") + axes, tiles));
+    check_all_modes<B32>(pixels, width, height);
+
+    tiles.clear();
+    for (vector<std::uint8_t> const& tile : split_tiles(bytes, width, height, plane_height, 4, 3))
+    {
+        tiles.push_back(rice_encode<1>(tile));
+    }
+    write_file(compressed_file(make_card("ZBITPIX", "8") + axes + make_card("ZTILE1", "4") + make_card("ZTILE2", "3") +
+        make_card("ZNAME1", "'BYTEPIX '") + make_card("ZVAL1", "1"), tiles));
+    check_all_modes<B8>(bytes, width, height);
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(quantized_float)
+{
+    size_t const width = 40, height = 6;
+    vector<float> const random = dither_sequence();
+    std::int64_t const dither_seed = 9998; //the sequence wraps around within the image
+
+    vector<std::int32_t> quantized(width * height);
+    for (size_t i = 0; i < quantized.size(); i++)
+    {
+        quantized[i] = static_cast<std::int32_t>(i * 37 % 1001) - 500;
+    }
+    quantized[7] = -2147483647; //blank
+    quantized[8] = -2147483646; //zero
+
+    //one tile per row, expected values computed as given by the convention
+    vector<float> expected(quantized.size());
+    vector<double> scales, zeros;
+    vector<string> tiles;
+    for (size_t row = 0; row < height; row++)
+    {
+        scales.push_back(0.25 + static_cast<double>(row));
+        zeros.push_back(-100.0 * static_cast<double>(row));
+        vector<std::int32_t> tile(quantized.begin() + static_cast<std::ptrdiff_t>(row * width),
+            quantized.begin() + static_cast<std::ptrdiff_t>((row + 1) * width));
+        tiles.push_back(rice_encode<4>(tile));
+
+        size_t seed = static_cast<size_t>((static_cast<std::int64_t>(row) + dither_seed - 1) % 10000);
+        size_t next = static_cast<size_t>(random[seed] * 500);
+        for (size_t column = 0; column < width; column++)
+        {
+            size_t i = row * width + column;
+            expected[i] = static_cast<float>((static_cast<double>(quantized[i]) - random[next] + 0.5) * scales[row] + zeros[row]);
+            if (++next == 10000)
+            {
+                seed = (seed + 1) % 10000;
+                next = static_cast<size_t>(random[seed] * 500);
+            }
+        }
+    }
+    expected[7] = std::numeric_limits<float>::quiet_NaN();
+    expected[8] = 0;
+
+    write_file(compressed_file(make_card("ZBITPIX", "-32") + make_card("ZNAXIS", "2") + make_card("ZNAXIS1", "40") +
+        make_card("ZNAXIS2", "6") + make_card("ZCMPTYPE", "'RICE_1  '") +
+        make_card("ZQUANTIZ", "'SUBTRACTIVE_DITHER_2'") + make_card("ZDITHER0", to_string(dither_seed)) +
+        make_card("ZBLANK", "-2147483647"), tiles, scales, zeros));
+
+    fits file(sample_file, fits::mapped);
+    image<_B32> img = static_cast<compressed_image_extension<_B32>&>(*file.get_hdu(1)).get_data();
+    BOOST_CHECK(std::isnan(img(0, 7)));
+    expected[7] = img(0, 7);
+    check_image(img, expected, width);
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(unsupported)
+{
+    write_file(compressed_file(make_card("ZBITPIX", "16") + make_card("ZNAXIS", "2") + make_card("ZNAXIS1", "2") +
+        make_card("ZNAXIS2", "1") + make_card("ZCMPTYPE", "'HCOMPRESS_1'"), vector<string>(1, string(4, '\0'))));
+
+    fits file(sample_file, fits::deferred);
+    compressed_image_extension<B16>& typed = static_cast<compressed_image_extension<B16>&>(*file.get_hdu(1));
+    BOOST_CHECK_THROW(typed.get_data(), boost::astronomy::unsupported_compression_exception);
+
+    std::remove(sample_file.c_str());
+}
+
+#if defined(BOOST_ASTRONOMY_HAS_ZLIB)
+BOOST_AUTO_TEST_CASE(gzip_double)
+{
+    size_t const width = 17, height = 9;
+    vector<double> pixels(width * height);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = std::sin(static_cast<double>(i)) * 1.0e5;
+    }
+
+    for (bool shuffled : {false, true})
+    {
+        vector<string> tiles;
+        for (vector<double> const& tile : split_tiles(pixels, width, height, height, 8, 4))
+        {
+            string raw;
+            for (double value : tile)
+            {
+                raw += big_endian(value);
+            }
+            if (shuffled)
+            {
+                string bytes(raw.size(), '\0');
+                for (size_t i = 0; i < tile.size(); i++)
+                {
+                    for (size_t b = 0; b < 8; b++)
+                    {
+                        bytes[b * tile.size() + i] = raw[i * 8 + b];
+                    }
+                }
+                raw = bytes;
+            }
+
+            vector<Bytef> compressed(compressBound(static_cast<uLong>(raw.size())));
+            uLongf size = static_cast<uLongf>(compressed.size());
+            compress2(compressed.data(), &size, reinterpret_cast<Bytef const*>(raw.data()), static_cast<uLong>(raw.size()), 6);
+            tiles.emplace_back(reinterpret_cast<char const*>(compressed.data()), size);
+        }
+
+        write_file(compressed_file(make_card("ZBITPIX", "-64") + make_card("ZNAXIS", "2") + make_card("ZNAXIS1", "17") +
+            make_card("ZNAXIS2", "9") + make_card("ZTILE1", "8") + make_card("ZTILE2", "4") +
+            make_card("ZCMPTYPE", shuffled ? "'GZIP_2  '" : "'GZIP_1  '"), tiles));
+        check_all_modes<_B64>(pixels, width, height);
+    }
+
+    std::remove(sample_file.c_str());
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,822 @@
+#define BOOST_TEST_DYN_LINK
+
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/astronomy/io/fits.hpp>
+#include <boost/astronomy/io/fits_writer.hpp>
+#include <boost/astronomy/io/image_stack.hpp>
+
+
+using namespace std;
+using namespace boost::astronomy::io;
+
+namespace
+{
+    //creates 80 char card with value right justified in columns 11-30
+    string make_card(string const& key, string const& value)
+    {
+        string result = key;
+        result.resize(8, ' ');
+        result += "= ";
+        result += string(value.length() < 20 ? 20 - value.length() : 0, ' ') + value;
+        result.resize(80, ' ');
+        return result;
+    }
+
+    //appends END card and pads the header to a multiple of 2880 bytes
+    string end_header(string header)
+    {
+        header += string("END").append(77, ' ');
+        header.resize(((header.size() + 2879) / 2880) * 2880, ' ');
+        return header;
+    }
+
+    //converts values to big-endian and pads with zeros to a multiple of 2880 bytes
+    template <typename T>
+    string make_data(vector<T> const& values)
+    {
+        string result;
+        for (T value : values)
+        {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            std::reverse(bytes, bytes + sizeof(T));
+            result.append(bytes, sizeof(T));
+        }
+        result.resize(((result.size() + 2879) / 2880) * 2880, '\0');
+        return result;
+    }
+
+    string image_header(bool primary, int bitpix, size_t naxis1, size_t naxis2)
+    {
+        string header = primary ? make_card("SIMPLE", "T") : make_card("XTENSION", "'IMAGE   '");
+        header += make_card("BITPIX", to_string(bitpix));
+        header += make_card("NAXIS", "2");
+        header += make_card("NAXIS1", to_string(naxis1));
+        header += make_card("NAXIS2", to_string(naxis2));
+        header += primary ? make_card("EXTEND", "T") : make_card("PCOUNT", "0") + make_card("GCOUNT", "1");
+        return header;
+    }
+
+    vector<std::int16_t> primary_pixels()
+    {
+        vector<std::int16_t> pixels;
+        for (int i = 0; i < 12; i++)
+        {
+            pixels.push_back(static_cast<std::int16_t>(i * 1000 - 5000));
+        }
+        return pixels;
+    }
+
+    vector<float> extension_pixels()
+    {
+        vector<float> pixels;
+        for (int i = 0; i < 10; i++)
+        {
+            pixels.push_back(static_cast<float>(i) * 0.25f - 1.0f);
+        }
+        return pixels;
+    }
+
+    vector<std::int32_t> last_pixels()
+    {
+        vector<std::int32_t> pixels;
+        for (int i = 0; i < 6; i++)
+        {
+            pixels.push_back(i * 100000 - 300000);
+        }
+        return pixels;
+    }
+
+    //primary B16 image (header with exactly 36 cards), a _B32 image extension,
+    //a binary table and a B32 image extension
+    string const sample_file = "test_fits_sample.fits";
+
+    void write_sample_file()
+    {
+        string primary = image_header(true, 16, 4, 3);
+        while (primary.size() < 35 * 80)
+        {
+            primary += string("COMMENT").append(73, ' ');
+        }
+
+        string table = make_card("XTENSION", "'BINTABLE'") + make_card("BITPIX", "8") + make_card("NAXIS", "2") +
+            make_card("NAXIS1", "4") + make_card("NAXIS2", "3") + make_card("PCOUNT", "0") +
+            make_card("GCOUNT", "1") + make_card("TFIELDS", "1") + make_card("TFORM1", "'J       '");
+
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << end_header(primary) << make_data(primary_pixels())
+            << end_header(image_header(false, -32, 5, 2)) << make_data(extension_pixels())
+            << end_header(table) << make_data(vector<std::int32_t>(3, 7))
+            << end_header(image_header(false, 32, 3, 2)) << make_data(last_pixels());
+    }
+
+    template <template <bitpix> class HduType, bitpix DataType, typename T>
+    void check_pixels(std::shared_ptr<hdu> const& header, vector<T> const& expected)
+    {
+        BOOST_REQUIRE_EQUAL(header->bitpix(), DataType);
+        HduType<DataType>* typed = static_cast<HduType<DataType>*>(header.get());
+
+        auto data = typed->get_data();
+        size_t mismatches = 0;
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            T value = data(i / header->naxis(1), i % header->naxis(1));
+            if (std::memcmp(&value, &expected[i], sizeof(T)) != 0)
+            {
+                mismatches++;
+            }
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+    }
+
+    //sums the pixels of an image of any type
+    struct pixel_sum
+    {
+        typedef double result_type;
+
+        template <typename Image>
+        double operator()(Image const& data) const
+        {
+            double sum = 0;
+            for (size_t i = 0; i < data.get_width() * data.get_height(); i++)
+            {
+                sum += static_cast<double>(data.raw_data()[i]);
+            }
+            return sum;
+        }
+    };
+
+    //names the kind of a typed HDU
+    struct hdu_kind
+    {
+        typedef string result_type;
+
+        template <bitpix DataType>
+        string operator()(primary_hdu<DataType> const&) const
+        {
+            return "primary";
+        }
+
+        template <bitpix DataType>
+        string operator()(image_extension<DataType> const& extension) const
+        {
+            return "image " + to_string(extension.image_width());
+        }
+
+        template <bitpix DataType>
+        string operator()(compressed_image_extension<DataType> const&) const
+        {
+            return "compressed";
+        }
+    };
+
+    template <typename T>
+    double sum_of(vector<T> const& values)
+    {
+        double sum = 0;
+        for (T value : values)
+        {
+            sum += static_cast<double>(value);
+        }
+        return sum;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(fits_read)
+
+BOOST_AUTO_TEST_CASE(stream)
+{
+    write_sample_file();
+
+    fits file(sample_file);
+    file.read_extensions();
+    BOOST_REQUIRE_EQUAL(file.hdu_count(), 4u);
+
+    check_pixels<primary_hdu, B16>(file.get_hdu(0), primary_pixels());
+    check_pixels<image_extension, _B32>(file.get_hdu(1), extension_pixels());
+    BOOST_CHECK_EQUAL(file.get_hdu(2)->value_of<int>("TFIELDS"), 1);
+    check_pixels<image_extension, B32>(file.get_hdu(3), last_pixels());
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(mapped)
+{
+    write_sample_file();
+
+    std::shared_ptr<hdu> extension;
+    {
+        fits file(sample_file, fits::mapped);
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 4u);
+
+        check_pixels<primary_hdu, B16>(file.get_hdu(0), primary_pixels());
+        check_pixels<image_extension, _B32>(file.get_hdu(1), extension_pixels());
+        BOOST_CHECK_EQUAL(file.get_hdu(2)->value_of<int>("TFIELDS"), 1);
+        check_pixels<image_extension, B32>(file.get_hdu(3), last_pixels());
+        extension = file.get_hdu(3);
+    }
+
+    //views keep the mapping alive after fits is destroyed
+    BOOST_REQUIRE_EQUAL(extension->bitpix(), B32);
+    image_view<B32> view = static_cast<image_extension<B32>&>(*extension).get_view();
+    BOOST_CHECK(static_cast<image_extension<B32>&>(*extension).is_mapped());
+    BOOST_CHECK_EQUAL(view.width(), 3u);
+    BOOST_CHECK_EQUAL(view.height(), 2u);
+    BOOST_CHECK_EQUAL(view(1, 2), last_pixels()[5]);
+    BOOST_CHECK_EQUAL(view[1], last_pixels()[1]);
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(multi_block_header)
+{
+    //header of 3 blocks with END card as the first card of the last block
+    string header = image_header(true, 8, 2, 2);
+    for (int i = 0; header.size() < 72 * 80; i++)
+    {
+        header += make_card("KEY" + to_string(i), to_string(i));
+    }
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << end_header(header) << make_data(vector<std::uint8_t>{1, 2, 3, 4});
+    }
+
+    for (fits::read_mode mode : {fits::stream, fits::mapped})
+    {
+        fits file(sample_file, mode);
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 1u);
+        BOOST_CHECK_EQUAL(file.get_hdu(0)->value_of<int>("KEY65"), 65);
+        BOOST_CHECK_EQUAL(file.get_hdu(0)->naxis(2), 2u);
+        check_pixels<primary_hdu, B8>(file.get_hdu(0), vector<std::uint8_t>{1, 2, 3, 4});
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(keywords)
+{
+    //primary header without EXTEND with repeated commentary cards and a key longer than 8 chars
+    string header = make_card("SIMPLE", "T") + make_card("BITPIX", "8") + make_card("NAXIS", "0");
+    header += string("HISTORY first step").append(62, ' ');
+    header += make_card("OBSERVER", "'Hubble'");
+    header += string("HISTORY second step").append(61, ' ');
+    header += string("COMMENT").append(73, ' ');
+    header += make_card("EXPOSURE", "10");
+    header += make_card("EXPOSURE", "20");
+    header = end_header(header);
+
+    hdu primary;
+    BOOST_REQUIRE_EQUAL(primary.read_header(header.data(), header.data() + header.size()), 2880u);
+
+    BOOST_CHECK(primary.has_key("OBSERVER"));
+    BOOST_CHECK(!primary.has_key("OBSERV"));
+    BOOST_CHECK(!primary.has_key("OBSERVER1"));
+    BOOST_CHECK_EQUAL(primary.value_of<std::string>("OBSERVER"), "'Hubble'");
+    BOOST_CHECK_EQUAL(primary.value_of<int>("EXPOSURE"), 20);
+    BOOST_CHECK_EQUAL(primary.key_count("EXPOSURE"), 2u);
+    BOOST_CHECK_EQUAL(primary.value_of<bool>("EXTEND", true), true);
+    BOOST_CHECK_THROW(primary.value_of<bool>("EXTEND"), boost::astronomy::key_not_defined_exception);
+    BOOST_CHECK_EQUAL(primary.data_size(), 0u);
+
+    vector<string> history = primary.commentary("HISTORY");
+    BOOST_REQUIRE_EQUAL(history.size(), 2u);
+    BOOST_CHECK_EQUAL(history[0], "first step");
+    BOOST_CHECK_EQUAL(history[1], "second step");
+    BOOST_CHECK_EQUAL(primary.key_count("COMMENT"), 1u);
+    BOOST_CHECK_EQUAL(primary.commentary("COMMENT")[0], "");
+    BOOST_CHECK(primary.commentary("NOTHING").empty());
+
+    //primary HDU without EXTEND can be read
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << header;
+    }
+    fits file(sample_file);
+    BOOST_CHECK_EQUAL(file.hdu_count(), 1u);
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(card_values)
+{
+    card logical(make_card("SIMPLE", "T"));
+    BOOST_CHECK(logical.value<bool>());
+    BOOST_CHECK_EQUAL(logical.parsed_value().type, card_value::logical);
+    BOOST_CHECK_THROW(logical.value<int>(), boost::astronomy::invalid_value_type_exception);
+
+    card integer(make_card("NAXIS1", "-2048 / width"));
+    BOOST_CHECK_EQUAL(integer.value<int>(), -2048);
+    BOOST_CHECK_EQUAL(integer.value<double>(), -2048.0);
+    BOOST_CHECK_EQUAL(integer.value<std::string>(), "-2048");
+    BOOST_CHECK_THROW(integer.value<std::size_t>(), boost::astronomy::invalid_value_type_exception);
+    BOOST_CHECK_THROW(card(make_card("BIG", "70000")).value<std::int16_t>(), boost::astronomy::invalid_value_type_exception);
+
+    //FITS D exponent and free format value without comment
+    card real(string("EXPTIME =  1.5D3").append(64, ' '));
+    BOOST_CHECK_EQUAL(real.parsed_value().type, card_value::real);
+    BOOST_CHECK_EQUAL(real.value<double>(), 1500.0);
+    BOOST_CHECK_EQUAL(real.value<float>(), 1500.0f);
+
+    card complex(make_card("IMPEDANC", "(1.5, -2)/ ohm"));
+    BOOST_CHECK(complex.value<std::complex<double>>() == std::complex<double>(1.5, -2.0));
+    BOOST_CHECK_EQUAL(complex.value<std::string>(), "(1.5, -2)");
+
+    //'/' inside quotes does not start the comment and '' stands for one quote
+    card path(make_card("FILENAME", "'data/m31 ''raw''.fits' / source"));
+    BOOST_CHECK_EQUAL(path.parsed_value().type, card_value::string);
+    BOOST_CHECK_EQUAL(path.value<std::string>(), "'data/m31 ''raw''.fits'");
+
+    card history(string("HISTORY   flat/dark corrected").append(51, ' '));
+    BOOST_CHECK_EQUAL(history.parsed_value().type, card_value::undefined);
+    BOOST_CHECK_EQUAL(history.value<std::string>(), "flat/dark corrected");
+
+    //copies keep the parsed value and modified cards are parsed again
+    card copy(integer);
+    BOOST_CHECK_EQUAL(copy.value<long>(), -2048L);
+    copy.value("                  42");
+    BOOST_CHECK_EQUAL(copy.value<int>(), 42);
+    BOOST_CHECK_EQUAL(integer.value<int>(), -2048);
+}
+
+BOOST_AUTO_TEST_CASE(deferred)
+{
+    write_sample_file();
+
+    fits file(sample_file, fits::deferred);
+    BOOST_REQUIRE_EQUAL(file.hdu_count(), 4u);
+    BOOST_REQUIRE_EQUAL(file.get_hdu(3)->bitpix(), B32);
+
+    image_extension<B32>& last = static_cast<image_extension<B32>&>(*file.get_hdu(3));
+    BOOST_CHECK(!last.is_loaded());
+    check_pixels<image_extension, B32>(file.get_hdu(3), last_pixels());
+    BOOST_CHECK(last.is_loaded());
+
+    //other HDUs are still not read
+    BOOST_CHECK(!static_cast<primary_hdu<B16>&>(*file.get_hdu(0)).is_loaded());
+    BOOST_CHECK(!static_cast<image_extension<_B32>&>(*file.get_hdu(1)).is_loaded());
+
+    check_pixels<primary_hdu, B16>(file.get_hdu(0), primary_pixels());
+    check_pixels<image_extension, _B32>(file.get_hdu(1), extension_pixels());
+    BOOST_CHECK_EQUAL(file.get_hdu(2)->value_of<int>("TFIELDS"), 1);
+
+    //strips of deferred HDU are read directly from the file
+    std::unique_ptr<image_stream<B16>> stream = static_cast<primary_hdu<B16>&>(*file.get_hdu(0)).get_stream(2);
+    BOOST_REQUIRE(stream->next());
+    BOOST_CHECK_EQUAL(stream->strip().get_height(), 2u);
+    BOOST_REQUIRE(stream->next());
+    BOOST_CHECK_EQUAL(stream->strip_row(), 2u);
+    BOOST_CHECK_EQUAL(stream->strip().get_height(), 1u);
+    BOOST_CHECK_EQUAL(stream->strip().max(), primary_pixels()[11]);
+    BOOST_CHECK(!stream->next());
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(parallel)
+{
+    write_sample_file();
+    {
+        fits file(sample_file, fits::parallel, 3);
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 4u);
+        BOOST_CHECK(static_cast<image_extension<B32>&>(*file.get_hdu(3)).is_loaded());
+
+        check_pixels<primary_hdu, B16>(file.get_hdu(0), primary_pixels());
+        check_pixels<image_extension, _B32>(file.get_hdu(1), extension_pixels());
+        BOOST_CHECK_EQUAL(file.get_hdu(2)->value_of<int>("TFIELDS"), 1);
+        check_pixels<image_extension, B32>(file.get_hdu(3), last_pixels());
+    }
+
+    //many extensions of equal size as in detector mosaics
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << end_header(image_header(true, 16, 0, 0));
+        for (int i = 0; i < 24; i++)
+        {
+            vector<std::int16_t> pixels(40 * 30);
+            for (size_t j = 0; j < pixels.size(); j++)
+            {
+                pixels[j] = static_cast<std::int16_t>(i * 1000 + static_cast<int>(j));
+            }
+            file << end_header(image_header(false, 16, 40, 30)) << make_data(pixels);
+        }
+    }
+
+    fits file(sample_file, fits::parallel, 4);
+    BOOST_REQUIRE_EQUAL(file.hdu_count(), 25u);
+    for (std::size_t i = 1; i < file.hdu_count(); i++)
+    {
+        BOOST_REQUIRE_EQUAL(file.get_hdu(i)->bitpix(), B16);
+        image<B16> data = static_cast<image_extension<B16>&>(*file.get_hdu(i)).get_data();
+        BOOST_CHECK_EQUAL(data(0, 0), static_cast<std::int16_t>((i - 1) * 1000));
+        BOOST_CHECK_EQUAL(data(29, 39), static_cast<std::int16_t>((i - 1) * 1000 + 1199));
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(prefetch)
+{
+    write_sample_file();
+    {
+        fits file(sample_file, fits::prefetch);
+        file.read_extensions();
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 4u);
+
+        check_pixels<primary_hdu, B16>(file.get_hdu(0), primary_pixels());
+        check_pixels<image_extension, _B32>(file.get_hdu(1), extension_pixels());
+        BOOST_CHECK_EQUAL(file.get_hdu(2)->value_of<int>("TFIELDS"), 1);
+        check_pixels<image_extension, B32>(file.get_hdu(3), last_pixels());
+    }
+
+    //blocks smaller than the HDUs and a pool of two buffers, so reads wait for the background thread
+    //and seeks both inside and outside of the blocks read ahead
+    string bytes;
+    {
+        ifstream raw(sample_file, ios_base::in | ios_base::binary);
+        bytes.assign((std::istreambuf_iterator<char>(raw)), std::istreambuf_iterator<char>());
+    }
+    boost::astronomy::detail::read_ahead_buffer buffer(sample_file, 1000, 2);
+    std::istream input(&buffer);
+    BOOST_CHECK_EQUAL(buffer.size(), bytes.size());
+
+    std::size_t const positions[] = {0, 2500, 2400, 9000, 100, 14399, 5000, 5999, 14000};
+    std::size_t const lengths[] = {3000, 1, 700, 2000, 10, 1, 1000, 1, 400};
+    for (std::size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+    {
+        input.seekg(static_cast<std::streamoff>(positions[i]));
+        string read(lengths[i], '\0');
+        input.read(&read[0], static_cast<std::streamsize>(read.size()));
+        BOOST_REQUIRE(input);
+        BOOST_CHECK(read == bytes.substr(positions[i], lengths[i]));
+        BOOST_CHECK_EQUAL(static_cast<std::size_t>(input.tellg()), positions[i] + lengths[i]);
+    }
+
+    //end of file
+    input.seekg(static_cast<std::streamoff>(bytes.size() - 10));
+    string tail(20, '\0');
+    input.read(&tail[0], 20);
+    BOOST_CHECK_EQUAL(input.gcount(), 10);
+    BOOST_CHECK(input.eof());
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(typed_images)
+{
+    write_sample_file();
+
+    pixel_sum sum;
+    hdu_kind kind;
+    for (fits::read_mode mode : {fits::stream, fits::mapped, fits::deferred, fits::parallel})
+    {
+        fits file(sample_file, mode);
+        if (mode == fits::stream)
+        {
+            file.read_extensions();
+        }
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 4u);
+
+        BOOST_CHECK_EQUAL(file.get_image(0).bitpix(), B16);
+        BOOST_CHECK_EQUAL(file.get_image(0).visit(kind), "primary");
+        BOOST_CHECK_CLOSE(file.get_image(0).visit_data(sum), sum_of(primary_pixels()), 1e-9);
+        BOOST_CHECK_EQUAL(file.get_image(1).bitpix(), _B32);
+        BOOST_CHECK_EQUAL(file.get_image(1).visit(kind), "image 5");
+        BOOST_CHECK_CLOSE(file.get_image(1).visit_data(sum), sum_of(extension_pixels()), 1e-9);
+        BOOST_CHECK_EQUAL(&file.get_image(3).get_header(), file.get_hdu(3).get());
+        BOOST_CHECK_CLOSE(file.get_image(3).visit_data(sum), sum_of(last_pixels()), 1e-9);
+        BOOST_CHECK_THROW(file.get_image(2), boost::astronomy::fits_exception);
+    }
+    BOOST_CHECK_THROW(image_hdu().visit_data(sum), boost::astronomy::fits_exception);
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(physical_values)
+{
+    //unsigned 16 bit primary image and a scaled extension with BLANK pixels
+    vector<std::int16_t> stored = {-32768, -1, 0, 32767, 100, -100};
+    string primary = image_header(true, 16, 3, 2) + make_card("BZERO", "32768") + make_card("BSCALE", "1");
+    string extension = image_header(false, 16, 3, 2) + make_card("BZERO", "1.0D1") + make_card("BSCALE", "0.25") +
+        make_card("BLANK", "-1");
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << end_header(primary) << make_data(stored) << end_header(extension) << make_data(stored);
+    }
+
+    for (fits::read_mode mode : {fits::stream, fits::mapped, fits::deferred})
+    {
+        fits file(sample_file, mode);
+        if (mode == fits::stream)
+        {
+            file.read_extensions();
+        }
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 2u);
+
+        image_buffer<std::uint16_t> unsigned_image =
+            static_cast<primary_hdu<B16>&>(*file.get_hdu(0)).get_physical_data<std::uint16_t>();
+        image_buffer<float> scaled = static_cast<image_extension<B16>&>(*file.get_hdu(1)).get_physical_data<float>();
+        BOOST_REQUIRE_EQUAL(unsigned_image.get_width(), 3u);
+        BOOST_REQUIRE_EQUAL(scaled.get_height(), 2u);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < stored.size(); i++)
+        {
+            mismatches += unsigned_image.raw_data()[i] != static_cast<std::uint16_t>(stored[i] + 32768);
+            if (stored[i] == -1)
+            {
+                mismatches += !std::isnan(scaled.raw_data()[i]);
+            }
+            else
+            {
+                float const expected = static_cast<float>(stored[i]) * 0.25f + 10.0f;
+                mismatches += std::memcmp(&scaled.raw_data()[i], &expected, sizeof(float)) != 0;
+            }
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(converted_data)
+{
+    write_sample_file();
+
+    for (fits::read_mode mode : {fits::stream, fits::mapped, fits::deferred})
+    {
+        fits file(sample_file, mode);
+        if (mode == fits::stream)
+        {
+            file.read_extensions();
+        }
+
+        //B16 primary image decoded as float and the _B32 extension narrowed to B16 with rounding
+        image<_B32> widened = static_cast<primary_hdu<B16>&>(*file.get_hdu(0)).get_data_as<_B32>();
+        image<B16> narrowed = static_cast<image_extension<_B32>&>(*file.get_hdu(1)).get_data_as<B16>(
+            rounding_policy::toward_zero, 1);
+        BOOST_REQUIRE_EQUAL(widened.get_width(), 4u);
+        BOOST_REQUIRE_EQUAL(narrowed.get_height(), 2u);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < primary_pixels().size(); i++)
+        {
+            float const expected = static_cast<float>(primary_pixels()[i]);
+            mismatches += std::memcmp(&widened.raw_data()[i], &expected, sizeof(float)) != 0;
+        }
+        for (size_t i = 0; i < extension_pixels().size(); i++)
+        {
+            mismatches += narrowed.raw_data()[i] != static_cast<std::int16_t>(extension_pixels()[i]);
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(stacking)
+{
+    //three 3 x 2 frames: a B16 primary image, a scaled B16 extension and a _B32 extension
+    vector<std::int16_t> const primary_values = {1, 2, 3, 4, 5, 6};
+    vector<std::int16_t> const scaled_values = {0, 2, 4, 6, 8, -1};
+    vector<float> const float_values = {3.0f, 3.0f, 3.0f, 3.0f, 3.0f, 3.0f};
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << end_header(image_header(true, 16, 3, 2)) << make_data(primary_values)
+            << end_header(image_header(false, 16, 3, 2) + make_card("BSCALE", "0.5") + make_card("BLANK", "-1"))
+            << make_data(scaled_values)
+            << end_header(image_header(false, -32, 3, 2)) << make_data(float_values);
+    }
+
+    stack_options options;
+    options.method = combine_method::mean;
+    options.memory_budget = 1;
+    vector<float> const expected = {4.0f / 3.0f, 2.0f, 8.0f / 3.0f, 10.0f / 3.0f, 4.0f, 4.5f};
+
+    //frames of HDUs of a mapped file and frames read from the file as they are combined
+    fits mapped(sample_file, fits::mapped);
+    image_stack from_hdus, from_paths;
+    for (size_t index = 0; index < 3; index++)
+    {
+        from_hdus.add(stack_frame(mapped.get_image(index)));
+        from_paths.add(stack_frame(sample_file, index));
+    }
+
+    for (image_stack const* stack : {&from_hdus, &from_paths})
+    {
+        image_buffer<float> combined = stack->combine(options);
+        BOOST_REQUIRE_EQUAL(combined.get_width(), 3u);
+        BOOST_REQUIRE_EQUAL(combined.get_height(), 2u);
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            BOOST_CHECK_CLOSE(combined.raw_data()[i], expected[i], 1e-4);
+        }
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(region)
+{
+    write_sample_file();
+
+    for (fits::read_mode mode : {fits::stream, fits::mapped, fits::deferred})
+    {
+        fits file(sample_file, mode);
+        if (mode == fits::stream)
+        {
+            file.read_extensions();
+        }
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 4u);
+
+        //rows 1-2 and columns 1-2 of the 4 x 3 primary image
+        primary_hdu<B16>& primary = static_cast<primary_hdu<B16>&>(*file.get_hdu(0));
+        image<B16> stamp = primary.get_region(1, 1, 2, 2);
+        BOOST_CHECK_EQUAL(stamp.get_width(), 2u);
+        BOOST_CHECK_EQUAL(stamp.get_height(), 2u);
+        BOOST_CHECK_EQUAL(stamp(0, 0), primary_pixels()[5]);
+        BOOST_CHECK_EQUAL(stamp(0, 1), primary_pixels()[6]);
+        BOOST_CHECK_EQUAL(stamp(1, 0), primary_pixels()[9]);
+        BOOST_CHECK_EQUAL(stamp(1, 1), primary_pixels()[10]);
+
+        //full width region of the 3 x 2 extension
+        image_extension<B32>& last = static_cast<image_extension<B32>&>(*file.get_hdu(3));
+        image<B32> row = last.get_region(1, 0, 3, 1);
+        BOOST_CHECK_EQUAL(row(0, 0), last_pixels()[3]);
+        BOOST_CHECK_EQUAL(row(0, 2), last_pixels()[5]);
+
+        BOOST_CHECK_THROW(last.get_region(1, 1, 3, 1), boost::astronomy::region_out_of_range_exception);
+        if (mode == fits::deferred)
+        {
+            BOOST_CHECK(!last.is_loaded());
+        }
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(cube)
+{
+    //4 x 3 x 5 primary cube followed by a 2 x 2 x 2 extension, pixel (x, y, z) of the cube is x + 10 y + 100 z
+    vector<std::int32_t> pixels;
+    for (int z = 0; z < 5; z++)
+    {
+        for (int y = 0; y < 3; y++)
+        {
+            for (int x = 0; x < 4; x++)
+            {
+                pixels.push_back(x + 10 * y + 100 * z);
+            }
+        }
+    }
+    string primary = make_card("SIMPLE", "T") + make_card("BITPIX", "32") + make_card("NAXIS", "3") +
+        make_card("NAXIS1", "4") + make_card("NAXIS2", "3") + make_card("NAXIS3", "5") + make_card("EXTEND", "T");
+    string extension = make_card("XTENSION", "'IMAGE   '") + make_card("BITPIX", "16") + make_card("NAXIS", "3") +
+        make_card("NAXIS1", "2") + make_card("NAXIS2", "2") + make_card("NAXIS3", "2") +
+        make_card("PCOUNT", "0") + make_card("GCOUNT", "1");
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << end_header(primary) << make_data(pixels)
+            << end_header(extension) << make_data(vector<std::int16_t>{1, 2, 3, 4, 5, 6, 7, 8});
+    }
+
+    for (fits::read_mode mode : {fits::stream, fits::mapped, fits::deferred})
+    {
+        fits file(sample_file, mode);
+        if (mode == fits::stream)
+        {
+            file.read_extensions();
+        }
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 2u);
+
+        primary_hdu<B32>& spectral = static_cast<primary_hdu<B32>&>(*file.get_hdu(0));
+        BOOST_CHECK(spectral.get_shape() == (vector<size_t>{4, 3, 5}));
+
+        //plane 3 along the spectral axis
+        image_cube<B32> plane = spectral.get_slice(2, 3);
+        BOOST_REQUIRE(plane.get_shape() == (vector<size_t>{4, 3}));
+        BOOST_CHECK_EQUAL(plane({0, 0}), 300);
+        BOOST_CHECK_EQUAL(plane({3, 2}), 323);
+
+        //spectrum of pixel (2, 1)
+        image_cube<B32> spectrum = spectral.get_cube({2, 1, 0}, {1, 1, 5});
+        BOOST_REQUIRE_EQUAL(spectrum.size(), 5u);
+        for (size_t z = 0; z < 5; z++)
+        {
+            BOOST_CHECK_EQUAL(spectrum.raw_data()[z], static_cast<std::int32_t>(12 + 100 * z));
+        }
+
+        //slice along the first axis and a hyperslab inside the cube
+        image_cube<B32> side = spectral.get_slice(0, 1);
+        BOOST_REQUIRE(side.get_shape() == (vector<size_t>{3, 5}));
+        BOOST_CHECK_EQUAL(side({2, 4}), 421);
+        image_cube<B32> inner = spectral.get_cube({1, 1, 1}, {2, 2, 3});
+        BOOST_CHECK_EQUAL(inner({0, 0, 0}), 111);
+        BOOST_CHECK_EQUAL(inner({1, 1, 2}), 322);
+        BOOST_CHECK_EQUAL(spectral.get_cube().size(), pixels.size());
+
+        BOOST_CHECK_THROW(spectral.get_slice(3, 0), boost::astronomy::region_out_of_range_exception);
+        BOOST_CHECK_THROW(spectral.get_cube({0, 0, 4}, {4, 3, 2}), boost::astronomy::region_out_of_range_exception);
+        if (mode == fits::deferred)
+        {
+            BOOST_CHECK(!spectral.is_loaded());
+        }
+        BOOST_CHECK_EQUAL(spectral.get_data().get_height(), 15u);
+
+        //the extension after the cube is found at the right position
+        image_extension<B16>& small = static_cast<image_extension<B16>&>(*file.get_hdu(1));
+        BOOST_CHECK_EQUAL(small.get_slice(2, 1)({1, 1}), 8);
+        BOOST_CHECK_EQUAL(small.get_data().get_height(), 4u);
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(vector_slice)
+{
+    //the slice of a one dimensional image keeps a single axis
+    string primary = make_card("SIMPLE", "T") + make_card("BITPIX", "16") + make_card("NAXIS", "1") +
+        make_card("NAXIS1", "5");
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << end_header(primary) << make_data(vector<std::int16_t>{10, 11, 12, 13, 14});
+    }
+
+    for (fits::read_mode mode : {fits::stream, fits::mapped, fits::deferred})
+    {
+        fits file(sample_file, mode);
+        primary_hdu<B16>& spectrum = static_cast<primary_hdu<B16>&>(*file.get_hdu(0));
+        image_cube<B16> pixel = spectrum.get_slice(0, 3);
+        BOOST_REQUIRE(pixel.get_shape() == (vector<size_t>{1}));
+        BOOST_CHECK_EQUAL(pixel.raw_data()[0], 13);
+        BOOST_CHECK_THROW(spectrum.get_slice(0, 5), boost::astronomy::region_out_of_range_exception);
+        BOOST_CHECK_THROW(spectrum.get_slice(1, 0), boost::astronomy::region_out_of_range_exception);
+    }
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(fits_write)
+
+BOOST_AUTO_TEST_CASE(images)
+{
+    string const name = "test_fits_write.fits";
+    string const raw_name = "test_fits_write.raw";
+
+    image<B16> primary;
+    primary.assign_big_endian(make_data(primary_pixels()).data(), 4, 3);
+    image<_B32> extension;
+    extension.assign_big_endian(make_data(extension_pixels()).data(), 5, 2);
+    {
+        ofstream raw(raw_name, ios_base::out | ios_base::binary);
+        raw << make_data(last_pixels());
+    }
+
+    card object;
+    object.create_card("OBJECT", string("'M31     '"), " observed object");
+    {
+        //the smallest buffer, so the headers and data units are split between writes
+        fits_writer writer(name, 1);
+        writer.write_primary_hdu(primary, vector<card>(1, object));
+        writer.write_image_extension(extension);
+        image_stream<B32> strips(raw_name, 0, 3, 2, 1);
+        writer.write_image_extension(strips);
+        writer.close();
+        BOOST_CHECK_EQUAL(writer.size(), 6u * 2880);
+    }
+
+    ifstream written(name, ios_base::in | ios_base::binary);
+    string bytes((std::istreambuf_iterator<char>(written)), std::istreambuf_iterator<char>());
+    BOOST_CHECK_EQUAL(bytes.size(), 6u * 2880);
+    //fixed format: values end in column 30
+    BOOST_CHECK_EQUAL(bytes.substr(80, 30), make_card("BITPIX", "16").substr(0, 30));
+    BOOST_CHECK_EQUAL(bytes.substr(2880 * 2, 20), "XTENSION= 'IMAGE   '");
+    BOOST_CHECK_EQUAL(bytes.substr(2880 * 2 + 80, 30), make_card("BITPIX", "-32").substr(0, 30));
+    BOOST_CHECK_EQUAL(bytes.substr(2880, 24), make_data(primary_pixels()).substr(0, 24));
+
+    fits file(name, fits::mapped);
+    BOOST_REQUIRE_EQUAL(file.hdu_count(), 3u);
+    BOOST_CHECK_EQUAL(file.get_hdu(0)->value_of<string>("OBJECT"), "'M31     '");
+    check_pixels<primary_hdu, B16>(file.get_hdu(0), primary_pixels());
+    check_pixels<image_extension, _B32>(file.get_hdu(1), extension_pixels());
+    check_pixels<image_extension, B32>(file.get_hdu(2), last_pixels());
+
+    std::remove(name.c_str());
+    std::remove(raw_name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,1037 @@
+#define BOOST_TEST_DYN_LINK
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/astronomy/io/image.hpp>
+#include <boost/astronomy/io/image_background.hpp>
+#include <boost/astronomy/io/image_cube.hpp>
+#include <boost/astronomy/io/image_expression.hpp>
+#include <boost/astronomy/io/image_stack.hpp>
+#include <boost/astronomy/io/image_stream.hpp>
+#include <boost/astronomy/io/source_detection.hpp>
+
+
+using namespace std;
+using namespace boost::astronomy::io;
+
+namespace
+{
+    //writes values to file in big-endian byte order
+    template <typename T>
+    void write_big_endian(string const& name, vector<T> const& values)
+    {
+        ofstream file(name, ios_base::out | ios_base::binary);
+        for (T value : values)
+        {
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            if (boost::endian::order::native == boost::endian::order::little)
+            {
+                std::reverse(bytes, bytes + sizeof(T));
+            }
+            file.write(reinterpret_cast<char*>(bytes), sizeof(T));
+        }
+    }
+
+    //returns values as big-endian bytes
+    template <typename T>
+    vector<char> big_endian_bytes(vector<T> const& values)
+    {
+        vector<char> bytes(values.size() * sizeof(T));
+        std::memcpy(bytes.data(), values.data(), bytes.size());
+        if (boost::endian::order::native == boost::endian::order::little)
+        {
+            for (size_t i = 0; i < bytes.size(); i += sizeof(T))
+            {
+                std::reverse(bytes.begin() + i, bytes.begin() + i + sizeof(T));
+            }
+        }
+        return bytes;
+    }
+
+    template <typename T>
+    bool same_bits(T a, T b)
+    {
+        return std::memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    template <bitpix DataType, typename T>
+    void check_round_trip(vector<T> const& values, size_t width, size_t height)
+    {
+        string const name = "test_image_read.raw";
+        write_big_endian(name, values);
+
+        fstream file(name, ios_base::in | ios_base::binary);
+        image<DataType> img(file, width, height, 0);
+        file.close();
+
+        size_t mismatches = 0;
+        for (size_t x = 0; x < height; x++)
+        {
+            for (size_t y = 0; y < width; y++)
+            {
+                if (!same_bits(img(x, y), values[x * width + y]))
+                {
+                    mismatches++;
+                }
+            }
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+        std::remove(name.c_str());
+    }
+
+    //edge values of every conversion (halfway values, limits of every pixel type, NaN and infinities)
+    //followed by pseudo random values, saturated to T, the length is not a multiple of any vector width
+    template <typename T>
+    vector<T> conversion_input()
+    {
+        vector<double> const edges = {0.0, 1.0, -1.0, 0.5, -0.5, 1.5, 2.5, -2.5, 127.5, 255.49, 255.5, 256.0, -129.0,
+            32766.5, 32767.5, 32768.0, -32768.5, -40000.0, 2147483520.0, 2147483648.0, -2147483904.0, 1.0e10, -1.0e10,
+            3.0e38, std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity()};
+
+        vector<T> values;
+        for (double edge : edges)
+        {
+            values.push_back(boost::astronomy::detail::convert_value<T>(edge, true));
+        }
+        std::uint32_t state = 12345;
+        while (values.size() < 1037)
+        {
+            state = state * 1664525u + 1013904223u;
+            double const scale = std::ldexp(1.0, static_cast<int>(state % 34));
+            values.push_back(boost::astronomy::detail::convert_value<T>(
+                (static_cast<double>(state >> 8) / 16777216.0 - 0.5) * scale, true));
+        }
+        return values;
+    }
+
+    //compares convert_pixels() and convert_big_endian() with the scalar reference for both roundings
+    template <typename Target, typename Source>
+    size_t conversion_mismatches()
+    {
+        vector<Source> const input = conversion_input<Source>();
+        vector<char> const bytes = big_endian_bytes(input);
+        size_t mismatches = 0;
+        for (rounding_policy rounding : {rounding_policy::nearest, rounding_policy::toward_zero})
+        {
+            vector<Target> expected(input.size()), converted(input.size()), decoded(input.size());
+            boost::astronomy::detail::convert_scalar(input.data(), input.size(), expected.data(),
+                rounding == rounding_policy::nearest);
+            convert_pixels(input.data(), input.size(), converted.data(), rounding);
+            convert_big_endian<Target, Source>(bytes.data(), input.size(), decoded.data(), rounding);
+            for (size_t i = 0; i < input.size(); i++)
+            {
+                mismatches += !same_bits(converted[i], expected[i]) || !same_bits(decoded[i], expected[i]);
+            }
+        }
+        return mismatches;
+    }
+
+    template <typename Source>
+    size_t conversion_mismatches_to_all()
+    {
+        return conversion_mismatches<std::uint8_t, Source>() + conversion_mismatches<std::int16_t, Source>() +
+            conversion_mismatches<std::int32_t, Source>() + conversion_mismatches<boost::float32_t, Source>() +
+            conversion_mismatches<boost::float64_t, Source>();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(image_read)
+
+BOOST_AUTO_TEST_CASE(integer_types)
+{
+    vector<std::uint8_t> b8;
+    vector<std::int16_t> b16;
+    vector<std::int32_t> b32;
+    for (int i = 0; i < 35; i++)
+    {
+        b8.push_back(static_cast<std::uint8_t>(i * 7));
+        b16.push_back(static_cast<std::int16_t>(i * 997 - 17000));
+        b32.push_back(static_cast<std::int32_t>(static_cast<std::uint32_t>(i) * 123456789u));
+    }
+
+    check_round_trip<B8>(b8, 5, 7);
+    check_round_trip<B16>(b16, 5, 7);
+    check_round_trip<B32>(b32, 7, 5);
+}
+
+BOOST_AUTO_TEST_CASE(floating_point_types)
+{
+    vector<boost::float32_t> f32;
+    vector<boost::float64_t> f64;
+    for (int i = 0; i < 35; i++)
+    {
+        f32.push_back(static_cast<boost::float32_t>(i * 3.14159 - 50.5));
+        f64.push_back(i * 2.718281828459045e-7 - 1.0e10);
+    }
+
+    check_round_trip<_B32>(f32, 5, 7);
+    check_round_trip<_B64>(f64, 7, 5);
+}
+
+BOOST_AUTO_TEST_CASE(multiple_chunks)
+{
+    //larger than the 1 MiB read chunk and not a multiple of any vector width
+    size_t const width = 641, height = 509;
+    vector<std::int32_t> b32(width * height);
+    for (size_t i = 0; i < b32.size(); i++)
+    {
+        b32[i] = static_cast<std::int32_t>(i * 2654435761u);
+    }
+
+    check_round_trip<B32>(b32, width, height);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(physical_values)
+
+BOOST_AUTO_TEST_CASE(unsigned_offsets)
+{
+    //unsigned 16 and 32 bit integers are stored as signed integers with BZERO = 2^15 and 2^31
+    vector<std::int16_t> b16;
+    vector<std::int32_t> b32;
+    for (int i = 0; i < 35; i++)
+    {
+        b16.push_back(static_cast<std::int16_t>(i * 1871 - 32768));
+        b32.push_back(static_cast<std::int32_t>(static_cast<std::uint32_t>(i) * 122713351u));
+    }
+
+    vector<char> bytes16 = big_endian_bytes(b16);
+    image_buffer<std::uint16_t> u16;
+    u16.assign_physical<std::int16_t>(bytes16.data(), 5, 7, value_scaling(1, 32768));
+    vector<char> bytes32 = big_endian_bytes(b32);
+    image_buffer<std::uint32_t> u32;
+    u32.assign_physical<std::int32_t>(bytes32.data(), 7, 5, value_scaling(1, 2147483648.0));
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < b16.size(); i++)
+    {
+        mismatches += u16.raw_data()[i] != static_cast<std::uint16_t>(b16[i] + 32768);
+        mismatches += u32.raw_data()[i] != static_cast<std::uint32_t>(static_cast<std::int64_t>(b32[i]) + 2147483648LL);
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+
+    image_buffer<std::uint16_t> invalid;
+    BOOST_CHECK_THROW(invalid.assign_physical<std::int16_t>(bytes16.data(), 5, 7, value_scaling(2, 0)),
+        boost::astronomy::fits_exception);
+    BOOST_CHECK_THROW(invalid.assign_physical<std::int32_t>(bytes32.data(), 7, 5, value_scaling(1, 32768)),
+        boost::astronomy::fits_exception);
+}
+
+BOOST_AUTO_TEST_CASE(scale_and_blank)
+{
+    //larger than the read chunk and the conversion block with BLANK pixels
+    size_t const width = 733, height = 811;
+    vector<std::int16_t> stored(width * height);
+    for (size_t i = 0; i < stored.size(); i++)
+    {
+        stored[i] = i % 101 == 0 ? std::int16_t(-32768) : static_cast<std::int16_t>(static_cast<int>(i % 60001) - 30000);
+    }
+    value_scaling const scaling(0.5, 100, -32768);
+
+    string const name = "test_image_physical.raw";
+    write_big_endian(name, stored);
+    vector<char> bytes = big_endian_bytes(stored);
+    image<B16> native;
+    native.assign_big_endian(bytes.data(), width, height);
+
+    image_buffer<float> mapped;
+    mapped.assign_physical<std::int16_t>(bytes.data(), width, height, scaling);
+    image_buffer<double> from_file;
+    from_file.assign_physical<std::int16_t>(boost::astronomy::detail::positional_file(name), 0, width, height, scaling);
+    image_buffer<double> from_native;
+    from_native.assign_physical(native, scaling);
+    std::remove(name.c_str());
+
+    BOOST_REQUIRE_EQUAL(from_file.get_width(), width);
+    BOOST_REQUIRE_EQUAL(from_native.get_height(), height);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < stored.size(); i++)
+    {
+        if (i % 101 == 0)
+        {
+            mismatches += !std::isnan(mapped.raw_data()[i]) || !std::isnan(from_file.raw_data()[i]) ||
+                !std::isnan(from_native.raw_data()[i]);
+        }
+        else
+        {
+            double const expected = stored[i] * 0.5 + 100;
+            mismatches += !same_bits(mapped.raw_data()[i], static_cast<float>(expected)) ||
+                !same_bits(from_file.raw_data()[i], expected) || !same_bits(from_native.raw_data()[i], expected);
+        }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(floating_point_stored)
+{
+    //BLANK does not apply to floating point images and NaN pixels stay NaN
+    vector<boost::float32_t> stored = {1.5f, std::numeric_limits<boost::float32_t>::quiet_NaN(), -2.0f, 0.0f};
+    vector<char> bytes = big_endian_bytes(stored);
+    image_buffer<double> physical;
+    physical.assign_physical<boost::float32_t>(bytes.data(), 2, 2, value_scaling(2, 1, 0));
+
+    BOOST_CHECK(same_bits(physical.raw_data()[0], 4.0));
+    BOOST_CHECK(std::isnan(physical.raw_data()[1]));
+    BOOST_CHECK(same_bits(physical.raw_data()[2], -3.0));
+    BOOST_CHECK(same_bits(physical.raw_data()[3], 1.0));
+    BOOST_CHECK(value_scaling().is_identity());
+    BOOST_CHECK(!value_scaling(1, 0, 0).is_identity());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(image_cubes)
+
+BOOST_AUTO_TEST_CASE(strided_views)
+{
+    //pixel (x, y, z) of the 3 x 4 x 2 cube is x + 10 y + 100 z
+    image_cube<B16> cube({3, 4, 2});
+    for (std::size_t z = 0; z < 2; z++)
+    {
+        for (std::size_t y = 0; y < 4; y++)
+        {
+            for (std::size_t x = 0; x < 3; x++)
+            {
+                cube({x, y, z}) = static_cast<std::int16_t>(x + 10 * y + 100 * z);
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(cube.raw_data()[3], 10);
+
+    //views along every axis share the pixels of the cube
+    cube_view<std::int16_t const> row = cube.slice(2, 1).slice(1, 2);
+    BOOST_REQUIRE_EQUAL(row.rank(), 1u);
+    BOOST_CHECK_EQUAL(row({2}), 122);
+    BOOST_CHECK(row.is_contiguous());
+
+    cube_view<std::int16_t const> spectrum = cube.slice(0, 1).slice(0, 3);
+    BOOST_REQUIRE_EQUAL(spectrum.size(), 2u);
+    BOOST_CHECK_EQUAL(spectrum({1}), 131);
+    BOOST_CHECK(!spectrum.is_contiguous());
+
+    cube_view<std::int16_t const> block = cube.get_view().range(0, 1, 2).range(1, 1, 2);
+    image_cube<B16> copy;
+    copy.assign(block);
+    BOOST_REQUIRE(copy.get_shape() == (std::vector<std::size_t>{2, 2, 2}));
+    std::vector<std::int16_t> expected = {11, 12, 21, 22, 111, 112, 121, 122};
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(), copy.raw_data()));
+
+    //writes through a view change the cube
+    cube.get_view().slice(1, 0)({0, 1}) = -1;
+    BOOST_CHECK_EQUAL(cube({0, 0, 1}), -1);
+
+    image<B16> flat = cube.to_image();
+    BOOST_CHECK_EQUAL(flat.get_width(), 3u);
+    BOOST_CHECK_EQUAL(flat.get_height(), 8u);
+
+    BOOST_CHECK_THROW(cube.slice(3, 0), boost::astronomy::region_out_of_range_exception);
+    BOOST_CHECK_THROW(cube.get_view().range(1, 3, 2), boost::astronomy::region_out_of_range_exception);
+    BOOST_CHECK_THROW(copy.reshape({3, 3}), boost::astronomy::fits_exception);
+}
+
+BOOST_AUTO_TEST_CASE(hyperslab_reads)
+{
+    //big-endian 4 x 3 x 2 cube, only the runs of the hyperslab are copied
+    std::vector<std::int32_t> values(24);
+    std::vector<char> bytes(values.size() * sizeof(std::int32_t));
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<std::int32_t>(i) * 1000 - 7;
+        std::int32_t big = values[i];
+        boost::astronomy::detail::big_to_native_inplace(&big, 1); //swapping is its own inverse
+        std::memcpy(&bytes[i * sizeof(std::int32_t)], &big, sizeof(std::int32_t));
+    }
+
+    std::vector<std::size_t> runs;
+    boost::astronomy::detail::for_each_run({4, 3, 2}, {1, 0, 0}, {1, 3, 2},
+        [&](std::size_t source, std::size_t, std::size_t length)
+    {
+        runs.push_back(source);
+        BOOST_CHECK_EQUAL(length, 1u);
+    });
+    BOOST_CHECK(runs == (std::vector<std::size_t>{1, 5, 9, 13, 17, 21}));
+
+    std::size_t planes = 0;
+    boost::astronomy::detail::for_each_run({4, 3, 2}, {0, 0, 1}, {4, 3, 1},
+        [&](std::size_t source, std::size_t, std::size_t length)
+    {
+        planes++;
+        BOOST_CHECK_EQUAL(source, 12u);
+        BOOST_CHECK_EQUAL(length, 12u);
+    });
+    BOOST_CHECK_EQUAL(planes, 1u);
+
+    image_cube<B32> slab;
+    slab.assign_big_endian(bytes.data(), {4, 3, 2}, {2, 1, 0}, {2, 2, 2});
+    BOOST_REQUIRE_EQUAL(slab.size(), 8u);
+    BOOST_CHECK_EQUAL(slab({0, 0, 0}), values[6]);
+    BOOST_CHECK_EQUAL(slab({1, 1, 1}), values[23]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(pixel_conversion)
+
+BOOST_AUTO_TEST_CASE(kernels_match_scalar)
+{
+    BOOST_CHECK_EQUAL(conversion_mismatches_to_all<std::uint8_t>(), 0u);
+    BOOST_CHECK_EQUAL(conversion_mismatches_to_all<std::int16_t>(), 0u);
+    BOOST_CHECK_EQUAL(conversion_mismatches_to_all<std::int32_t>(), 0u);
+    BOOST_CHECK_EQUAL(conversion_mismatches_to_all<boost::float32_t>(), 0u);
+    BOOST_CHECK_EQUAL(conversion_mismatches_to_all<boost::float64_t>(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(saturation_and_rounding)
+{
+    vector<boost::float32_t> const values = {-0.5f, 0.5f, 1.5f, 2.5f, -1.7f, 40000.0f, -40000.0f,
+        std::numeric_limits<boost::float32_t>::quiet_NaN(), 1.0e10f};
+    vector<std::int16_t> nearest(values.size()), truncated(values.size());
+    convert_pixels(values.data(), values.size(), nearest.data());
+    convert_pixels(values.data(), values.size(), truncated.data(), rounding_policy::toward_zero);
+
+    vector<std::int16_t> const expected_nearest = {0, 0, 2, 2, -2, 32767, -32768, 0, 32767};
+    vector<std::int16_t> const expected_truncated = {0, 0, 1, 2, -1, 32767, -32768, 0, 32767};
+    BOOST_CHECK(nearest == expected_nearest);
+    BOOST_CHECK(truncated == expected_truncated);
+
+    vector<std::int32_t> const wide = {-5, 300, 128};
+    vector<std::uint8_t> narrow(wide.size());
+    convert_pixels(wide.data(), wide.size(), narrow.data());
+    BOOST_CHECK(narrow == (vector<std::uint8_t>{0, 255, 128}));
+}
+
+BOOST_AUTO_TEST_CASE(images)
+{
+    //B16 frame as float, larger than one part of the parallel conversion and one read chunk
+    size_t const width = 700, height = 800;
+    vector<std::int16_t> stored(width * height);
+    for (size_t i = 0; i < stored.size(); i++)
+    {
+        stored[i] = static_cast<std::int16_t>(i * 40503u);
+    }
+
+    image<B16> frame;
+    vector<char> const bytes = big_endian_bytes(stored);
+    frame.assign_big_endian(bytes.data(), width, height);
+
+    image<_B32> from_memory, from_bytes, from_file;
+    from_memory.assign_converted(frame, rounding_policy::nearest, 3);
+    from_bytes.assign_converted<std::int16_t>(bytes.data(), width, height);
+
+    string const name = "test_image_convert.raw";
+    write_big_endian(name, stored);
+    {
+        boost::astronomy::detail::positional_file file(name);
+        from_file.assign_converted<std::int16_t>(file, 0, width, height, rounding_policy::nearest, 2);
+    }
+    std::remove(name.c_str());
+
+    BOOST_REQUIRE_EQUAL(from_file.get_width(), width);
+    BOOST_REQUIRE_EQUAL(from_file.get_height(), height);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < stored.size(); i++)
+    {
+        boost::float32_t const expected = static_cast<boost::float32_t>(stored[i]);
+        mismatches += !same_bits(from_memory.raw_data()[i], expected) || !same_bits(from_bytes.raw_data()[i], expected) ||
+            !same_bits(from_file.raw_data()[i], expected);
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+
+    //and back with saturation
+    image<B8> bytes_image;
+    bytes_image.assign_converted(from_memory);
+    BOOST_CHECK_EQUAL(stored[1], -25033);
+    BOOST_CHECK_EQUAL(bytes_image(0, 1), 0);
+    BOOST_CHECK_EQUAL(stored[2], 15470);
+    BOOST_CHECK_EQUAL(bytes_image(0, 2), 255);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(image_expressions)
+
+BOOST_AUTO_TEST_CASE(calibration)
+{
+    //(raw - bias - t * dark) / flat over two parts of the parallel evaluation
+    size_t const width = 600, height = 500;
+    image<B16> raw, bias;
+    image<_B32> dark, flat;
+    raw.set_size(width, height);
+    bias.set_size(width, height);
+    dark.set_size(width, height);
+    flat.set_size(width, height);
+    for (size_t i = 0; i < width * height; i++)
+    {
+        raw.raw_data()[i] = static_cast<std::int16_t>(1000 + i % 3000);
+        bias.raw_data()[i] = static_cast<std::int16_t>(300 + i % 7);
+        dark.raw_data()[i] = static_cast<boost::float32_t>(i % 11) * 0.5f;
+        flat.raw_data()[i] = 0.9f + static_cast<boost::float32_t>(i % 5) * 0.05f;
+    }
+    double const t = 2.5;
+
+    image_buffer<boost::float32_t> calibrated = evaluate<boost::float32_t>((raw - bias - t * dark) / flat, 2);
+    BOOST_REQUIRE_EQUAL(calibrated.get_width(), width);
+    BOOST_REQUIRE_EQUAL(calibrated.get_height(), height);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < width * height; i++)
+    {
+        double const expected = (static_cast<double>(raw.raw_data()[i] - bias.raw_data()[i]) -
+            t * static_cast<double>(dark.raw_data()[i])) / static_cast<double>(flat.raw_data()[i]);
+        mismatches += !same_bits(calibrated.raw_data()[i], static_cast<boost::float32_t>(expected));
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+
+    image<B16> small;
+    small.set_size(3, 2);
+    BOOST_CHECK_THROW(raw - small, boost::astronomy::image_size_mismatch_exception);
+}
+
+BOOST_AUTO_TEST_CASE(masks_and_scalars)
+{
+    image<_B32> frame;
+    image<B8> bad;
+    frame.set_size(4, 1);
+    bad.set_size(4, 1);
+    vector<boost::float32_t> const values = {50.0f, 150.0f, -20.0f, 400.0f};
+    std::copy(values.begin(), values.end(), frame.raw_data());
+    bad.raw_data()[3] = 1;
+
+    //bad pixels replaced and the others clipped to [0, 255]
+    image<B8> clipped;
+    evaluate(where(bad, 0.0f, minimum(maximum(frame, 0.0f), 255.0f) + 0.4f), clipped);
+    BOOST_CHECK(std::equal(clipped.raw_data(), clipped.raw_data() + 4, vector<std::uint8_t>{50, 150, 0, 0}.begin()));
+
+    //masks of comparisons, combined and evaluated as 0 or 1
+    image<B8> inside;
+    evaluate((frame > 0.0f && !(frame >= 200.0f)) || frame < -10.0f, inside);
+    BOOST_CHECK(std::equal(inside.raw_data(), inside.raw_data() + 4, vector<std::uint8_t>{1, 1, 1, 0}.begin()));
+
+    //saturation of integer results and evaluation in place
+    image<B16> counts;
+    counts.set_size(4, 1);
+    vector<std::int16_t> const stored = {50, 150, -20, 400};
+    std::copy(stored.begin(), stored.end(), counts.raw_data());
+    evaluate(-counts * 100, counts);
+    BOOST_CHECK_EQUAL(counts(0, 0), -5000);
+    BOOST_CHECK_EQUAL(counts(0, 2), 2000);
+    BOOST_CHECK_EQUAL(counts(0, 3), -32768);
+
+    //scalars alone fill the image with its current size
+    evaluate(7, counts);
+    BOOST_CHECK_EQUAL(counts(0, 3), 7);
+    BOOST_CHECK_EQUAL(evaluate<double>(pixel_cast<double>(frame) / 4.0).raw_data()[1], 37.5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(image_stacking)
+
+BOOST_AUTO_TEST_CASE(combine_methods)
+{
+    //values of the first pixel in 6 frames, one outlier and one undefined value, the other pixels are constant
+    vector<boost::float32_t> const first_pixel = {10.0f, 12.0f, 11.0f, 1000.0f, 13.0f,
+        std::numeric_limits<boost::float32_t>::quiet_NaN()};
+    vector<image<_B32>> frames(first_pixel.size());
+    image_stack stack;
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        frames[f].set_size(3, 2);
+        std::fill(frames[f].raw_data(), frames[f].raw_data() + 6, 5.0f);
+        frames[f].raw_data()[0] = first_pixel[f];
+        stack.add(stack_frame(frames[f]));
+    }
+    BOOST_CHECK_EQUAL(stack.size(), 6u);
+
+    stack_options options;
+    options.method = combine_method::mean;
+    BOOST_CHECK_CLOSE(stack.combine(options).raw_data()[0], 209.2f, 1e-4);
+    options.method = combine_method::median;
+    BOOST_CHECK_CLOSE(stack.combine(options).raw_data()[0], 12.0f, 1e-4);
+    options.method = combine_method::sigma_clipped_mean;
+    options.sigma_low = options.sigma_high = 1.5;
+    BOOST_CHECK_CLOSE(stack.combine(options).raw_data()[0], 11.5f, 1e-4);
+    options.method = combine_method::minmax_rejected_mean;
+    image_buffer<boost::float32_t> rejected = stack.combine(options);
+    BOOST_CHECK_CLOSE(rejected.raw_data()[0], 12.0f, 1e-4);
+    BOOST_CHECK_CLOSE(rejected(1, 2), 5.0f, 1e-4);
+
+    image<_B32> other;
+    other.set_size(2, 3);
+    BOOST_CHECK_THROW(stack.add(stack_frame(other)), boost::astronomy::image_size_mismatch_exception);
+    BOOST_CHECK_THROW(image_stack().combine(), boost::astronomy::fits_exception);
+}
+
+BOOST_AUTO_TEST_CASE(memory_budget)
+{
+    //20 B16 frames, the strips of a small budget give the same result as a single strip
+    size_t const width = 64, height = 50, count = 20;
+    vector<image<B16>> frames(count);
+    image_stack stack;
+    for (size_t f = 0; f < count; f++)
+    {
+        frames[f].set_size(width, height);
+        for (size_t i = 0; i < width * height; i++)
+        {
+            frames[f].raw_data()[i] = static_cast<std::int16_t>((i * 7 + f * 13) % 1000);
+        }
+        stack.add(stack_frame(frames[f]));
+    }
+
+    stack_options options;
+    options.method = combine_method::sigma_clipped_mean;
+    options.threads = 3;
+    size_t threads = 0;
+    BOOST_CHECK_EQUAL(stack.strip_height(options, threads), height);
+    BOOST_CHECK_EQUAL(threads, 3u);
+    image_buffer<boost::float32_t> whole = stack.combine(options);
+
+    //room for 4 rows of all the frames: 2 rows for each of 2 threads
+    options.memory_budget = 4 * width * (count * sizeof(boost::float32_t) + sizeof(double));
+    BOOST_CHECK_EQUAL(stack.strip_height(options, threads), 1u);
+    options.threads = 2;
+    BOOST_CHECK_EQUAL(stack.strip_height(options, threads), 2u);
+    BOOST_CHECK_EQUAL(threads, 2u);
+    image_buffer<boost::float32_t> strips = stack.combine(options);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < width * height; i++)
+    {
+        mismatches += !same_bits(whole.raw_data()[i], strips.raw_data()[i]);
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(sky_background)
+
+BOOST_AUTO_TEST_CASE(gradient_with_sources)
+{
+    //a tilted plane with bright sources, 250 columns are split in 8 boxes of 31 or 32 columns
+    size_t const width = 250, height = 192;
+    image<_B32> frame;
+    frame.set_size(width, height);
+    for (size_t row = 0; row < height; row++)
+    {
+        for (size_t column = 0; column < width; column++)
+        {
+            frame.raw_data()[row * width + column] =
+                100.0f + 0.05f * static_cast<float>(column) + 0.02f * static_cast<float>(row);
+        }
+    }
+    for (size_t star = 0; star < 40; star++)
+    {
+        frame.raw_data()[(star * 37 % height) * width + star * 53 % width] = 5000.0f;
+    }
+
+    background_options options;
+    options.box_width = options.box_height = 32;
+    options.filter_width = options.filter_height = 1;
+    image_background background(frame, options);
+    BOOST_CHECK_EQUAL(background.get_mesh_width(), 8u);
+    BOOST_CHECK_EQUAL(background.get_mesh_height(), 6u);
+
+    //the spline reproduces the plane up to the centres of the boxes at the edges
+    image_buffer<boost::float32_t> sky = background.get_background();
+    BOOST_REQUIRE_EQUAL(sky.get_width(), width);
+    BOOST_REQUIRE_EQUAL(sky.get_height(), height);
+    float largest_error = 0;
+    for (size_t row = 16; row < 176; row++)
+    {
+        for (size_t column = 16; column < 234; column++)
+        {
+            float const plane = 100.0f + 0.05f * static_cast<float>(column) + 0.02f * static_cast<float>(row);
+            largest_error = (std::max)(largest_error, std::abs(sky.raw_data()[row * width + column] - plane));
+        }
+    }
+    BOOST_CHECK_SMALL(largest_error, 0.05f);
+
+    image_buffer<boost::float32_t> serial = background.get_background(1);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < width * height; i++)
+    {
+        mismatches += !same_bits(serial.raw_data()[i], sky.raw_data()[i]);
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_boxes_and_filter)
+{
+    //a flat sky of 10 with one box of undefined pixels and one box covered by a large source
+    size_t const width = 64, height = 64;
+    image<_B32> frame;
+    frame.set_size(width, height);
+    std::fill(frame.raw_data(), frame.raw_data() + width * height, 10.0f);
+    for (size_t row = 0; row < 16; row++)
+    {
+        for (size_t column = 0; column < 16; column++)
+        {
+            frame.raw_data()[row * width + column] = std::numeric_limits<float>::quiet_NaN();
+            frame.raw_data()[(row + 32) * width + column + 16] = 900.0f;
+        }
+    }
+
+    background_options options;
+    options.box_width = options.box_height = 16;
+    image_background background(frame, options);
+    BOOST_CHECK_EQUAL(background.level_at(0, 0), 10.0f);
+    BOOST_CHECK_EQUAL(background.level_at(2, 1), 10.0f);
+    BOOST_CHECK_EQUAL(background.rms_at(2, 1), 0.0f);
+
+    image_buffer<boost::float32_t> sky = background.get_background();
+    BOOST_CHECK_EQUAL(*std::min_element(sky.raw_data(), sky.raw_data() + width * height), 10.0f);
+    BOOST_CHECK_EQUAL(*std::max_element(sky.raw_data(), sky.raw_data() + width * height), 10.0f);
+
+    BOOST_CHECK_THROW(image_background(image<_B32>()), boost::astronomy::fits_exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(source_detection)
+
+BOOST_AUTO_TEST_CASE(moments_and_connectivity)
+{
+    size_t const width = 40, height = 30;
+    image<_B32> frame;
+    frame.set_size(width, height);
+    std::fill(frame.raw_data(), frame.raw_data() + width * height, 0.0f);
+    for (size_t row = 2; row < 5; row++)
+    {
+        std::fill(frame.raw_data() + row * width + 5, frame.raw_data() + row * width + 8, 1.0f);
+    }
+    frame.raw_data()[10 * width + 10] = 2.0f;
+    frame.raw_data()[11 * width + 11] = 4.0f;
+    frame.raw_data()[20 * width + 30] = 5.0f;
+    frame.raw_data()[25 * width + 3] = std::numeric_limits<float>::quiet_NaN();
+
+    detection_options options;
+    options.threshold = 0.5;
+    options.min_area = 2;
+    image_buffer<std::int32_t> labels;
+    source_table sources = detect_sources(frame, options, &labels);
+    BOOST_REQUIRE_EQUAL(sources.size(), 2u);
+
+    BOOST_CHECK_EQUAL(sources.area[0], 9u);
+    BOOST_CHECK_CLOSE(sources.flux[0], 9.0, 1e-9);
+    BOOST_CHECK_CLOSE(sources.centroid_row[0], 3.0, 1e-9);
+    BOOST_CHECK_CLOSE(sources.centroid_column[0], 6.0, 1e-9);
+    BOOST_CHECK_CLOSE(sources.row_variance[0], 2.0 / 3, 1e-9);
+    BOOST_CHECK_CLOSE(sources.column_variance[0], 2.0 / 3, 1e-9);
+    BOOST_CHECK_SMALL(sources.covariance[0], 1e-9);
+    BOOST_CHECK_EQUAL(sources.first_row[0], 2u);
+    BOOST_CHECK_EQUAL(sources.last_row[0], 4u);
+    BOOST_CHECK_EQUAL(sources.first_column[0], 5u);
+    BOOST_CHECK_EQUAL(sources.last_column[0], 7u);
+
+    //the two diagonal pixels are one source with 8-connectivity
+    BOOST_CHECK_EQUAL(sources.area[1], 2u);
+    BOOST_CHECK_CLOSE(sources.peak[1], 4.0, 1e-9);
+    BOOST_CHECK_CLOSE(sources.centroid_row[1], 32.0 / 3, 1e-9);
+    BOOST_CHECK_CLOSE(sources.covariance[1], 2.0 / 9, 1e-9);
+
+    BOOST_CHECK_EQUAL(labels(3, 6), 1);
+    BOOST_CHECK_EQUAL(labels(11, 11), 2);
+    BOOST_CHECK_EQUAL(labels(20, 30), 0);
+    BOOST_CHECK_EQUAL(labels(0, 0), 0);
+
+    options.eight_connected = false;
+    options.min_area = 1;
+    BOOST_CHECK_EQUAL(detect_sources(frame, options).size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(sources_across_strips)
+{
+    //rows of 4096 pixels are labelled in strips of 64 rows
+    size_t const width = 4096, height = 200;
+    image<B16> frame;
+    frame.set_size(width, height);
+    std::fill(frame.raw_data(), frame.raw_data() + width * height, std::int16_t(0));
+    for (size_t row = 50; row <= 150; row++)
+    {
+        frame.raw_data()[row * width + 100] = 10;
+    }
+    //two arms in the first strip only joined by a bar in the second strip
+    for (size_t row = 10; row <= 70; row++)
+    {
+        frame.raw_data()[row * width + 200] = 10;
+        frame.raw_data()[row * width + 210] = 10;
+    }
+    std::fill(frame.raw_data() + 70 * width + 200, frame.raw_data() + 70 * width + 211, std::int16_t(10));
+    for (size_t i = 0; i < 3000; i++)
+    {
+        size_t const row = 160 + (i * 7919) % 40, column = 1000 + (i * 104729) % 3000;
+        frame.raw_data()[row * width + column] = static_cast<std::int16_t>(1 + i % 5);
+    }
+
+    detection_options options;
+    options.threads = 1;
+    image_buffer<std::int32_t> labels;
+    source_table serial = detect_sources(frame, options, &labels);
+    BOOST_REQUIRE_GE(serial.size(), 2u);
+    BOOST_CHECK_EQUAL(serial.area[0], 61u + 61u + 9u);
+    BOOST_CHECK_EQUAL(serial.last_row[0], 70u);
+    BOOST_CHECK_EQUAL(serial.area[1], 101u);
+    BOOST_CHECK_EQUAL(serial.first_row[1], 50u);
+    BOOST_CHECK_EQUAL(serial.last_row[1], 150u);
+
+    //every labelled pixel is counted once in the area of its source
+    vector<size_t> counted(serial.size() + 1, 0);
+    for (size_t i = 0; i < width * height; i++)
+    {
+        counted[static_cast<size_t>(labels.raw_data()[i])]++;
+    }
+    size_t wrong_areas = 0;
+    for (size_t source = 0; source < serial.size(); source++)
+    {
+        wrong_areas += counted[source + 1] != serial.area[source];
+    }
+    BOOST_CHECK_EQUAL(wrong_areas, 0u);
+
+    options.threads = 4;
+    source_table threaded = detect_sources(frame, options);
+    BOOST_REQUIRE_EQUAL(threaded.size(), serial.size());
+    BOOST_CHECK(threaded.area == serial.area);
+    BOOST_CHECK(threaded.flux == serial.flux);
+    BOOST_CHECK(threaded.centroid_column == serial.centroid_column);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(image_strip_stream)
+
+BOOST_AUTO_TEST_CASE(strips)
+{
+    size_t const width = 37, height = 101, offset = 2880;
+    vector<std::int16_t> pixels(offset / 2 + width * height);
+    for (size_t i = 0; i < width * height; i++)
+    {
+        pixels[offset / 2 + i] = static_cast<std::int16_t>(i);
+    }
+    string const name = "test_image_stream.raw";
+    write_big_endian(name, pixels);
+
+    for (bool prefetch : {true, false})
+    {
+        image_stream<B16> stream(name, offset, width, height, 10, prefetch);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            size_t rows = 0, strip_count = 0, mismatches = 0;
+            stream.for_each_strip([&](image<B16> const& strip, size_t first_row)
+            {
+                BOOST_CHECK_EQUAL(first_row, rows);
+                BOOST_CHECK_EQUAL(strip.get_width(), width);
+                image<B16> copy = strip;
+                for (size_t x = 0; x < strip.get_height(); x++)
+                {
+                    for (size_t y = 0; y < width; y++)
+                    {
+                        if (copy(x, y) != static_cast<std::int16_t>((first_row + x) * width + y))
+                        {
+                            mismatches++;
+                        }
+                    }
+                }
+                rows += strip.get_height();
+                strip_count++;
+            });
+
+            BOOST_CHECK_EQUAL(rows, height);
+            BOOST_CHECK_EQUAL(strip_count, 11u);
+            BOOST_CHECK_EQUAL(mismatches, 0u);
+            BOOST_CHECK(!stream.next());
+            stream.rewind();
+        }
+    }
+
+    std::remove(name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(pixel_statistics)
+
+BOOST_AUTO_TEST_CASE(single_pass)
+{
+    //several parallel parts, the last one partial
+    size_t const width = 1031, height = 613;
+    vector<std::int16_t> pixels(width * height);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = static_cast<std::int16_t>((i * 2654435761u) >> 16);
+    }
+    image<B16> img;
+    img.assign_big_endian(big_endian_bytes(pixels).data(), width, height);
+
+    long double sum = 0, squares = 0;
+    for (std::int16_t pixel : pixels)
+    {
+        sum += pixel;
+    }
+    long double const mean = sum / pixels.size();
+    for (std::int16_t pixel : pixels)
+    {
+        squares += (pixel - mean) * (pixel - mean);
+    }
+
+    image_statistics stats = img.statistics();
+    BOOST_CHECK_EQUAL(stats.count, pixels.size());
+    BOOST_CHECK_EQUAL(stats.sum, static_cast<double>(sum));
+    BOOST_CHECK_EQUAL(stats.min, *std::min_element(pixels.begin(), pixels.end()));
+    BOOST_CHECK_EQUAL(stats.max, *std::max_element(pixels.begin(), pixels.end()));
+    BOOST_CHECK_CLOSE(stats.mean, static_cast<double>(mean), 1e-9);
+    BOOST_CHECK_CLOSE(stats.variance(), static_cast<double>(squares / (pixels.size() - 1)), 1e-9);
+    BOOST_CHECK_CLOSE(img.std_dev(), std::sqrt(static_cast<double>(squares / (pixels.size() - 1))), 1e-9);
+
+    //result does not depend on the number of threads
+    image_statistics serial = img.statistics(1), threaded = img.statistics(4);
+    BOOST_CHECK(same_bits(serial.mean, threaded.mean));
+    BOOST_CHECK(same_bits(serial.m2, threaded.m2));
+    BOOST_CHECK(same_bits(serial.sum, threaded.sum));
+}
+
+BOOST_AUTO_TEST_CASE(large_offset)
+{
+    //a naive sum of squares loses all the digits of the variance
+    vector<boost::float64_t> pixels(10000);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = 1.0e9 + static_cast<double>(i % 2);
+    }
+    image<_B64> img;
+    img.assign_big_endian(big_endian_bytes(pixels).data(), 100, 100);
+
+    image_statistics stats = img.statistics();
+    BOOST_CHECK_CLOSE(stats.mean, 1.0e9 + 0.5, 1e-12);
+    BOOST_CHECK_CLOSE(stats.variance(), 0.25 * 10000 / 9999, 1e-9);
+    BOOST_CHECK_EQUAL(image<_B64>().statistics().count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(streamed)
+{
+    size_t const width = 211, height = 97;
+    vector<boost::float32_t> pixels(width * height);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = static_cast<boost::float32_t>(std::sin(static_cast<double>(i) * 0.01) * 1000.0);
+    }
+    string const name = "test_image_statistics.raw";
+    write_big_endian(name, pixels);
+
+    image<_B32> img;
+    img.assign_big_endian(big_endian_bytes(pixels).data(), width, height);
+    image_statistics whole = img.statistics();
+
+    image_stream<_B32> stream(name, 0, width, height, 8);
+    image_statistics strips = stream.statistics();
+    BOOST_CHECK_EQUAL(strips.count, whole.count);
+    BOOST_CHECK_EQUAL(strips.min, whole.min);
+    BOOST_CHECK_EQUAL(strips.max, whole.max);
+    BOOST_CHECK_EQUAL(strips.sum, whole.sum);
+    BOOST_CHECK_CLOSE(strips.mean, whole.mean, 1e-9);
+    BOOST_CHECK_CLOSE(strips.variance(), whole.variance(), 1e-9);
+
+    std::remove(name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(pixel_percentiles)
+
+namespace
+{
+    //percentiles by sorting a copy, same rank definition as image_buffer::percentiles
+    template <typename T>
+    vector<T> sorted_percentiles(vector<T> values, vector<double> const& q)
+    {
+        values.erase(std::remove_if(values.begin(), values.end(), [](T v) { return std::isnan(v); }), values.end());
+        std::sort(values.begin(), values.end());
+        vector<T> result;
+        for (double percentage : q)
+        {
+            size_t rank = static_cast<size_t>(std::floor(percentage / 100.0 * static_cast<double>(values.size())));
+            result.push_back(values[(std::min)(rank, values.size() - 1)]);
+        }
+        return result;
+    }
+
+    template <bitpix DataType, typename T>
+    void check_percentiles(vector<T> const& values, size_t width, size_t height)
+    {
+        vector<double> const q = {0, 0.1, 25, 50, 50, 75, 99.9, 100};
+        image<DataType> img;
+        img.assign_big_endian(big_endian_bytes(values).data(), width, height);
+
+        vector<T> expected = sorted_percentiles(values, q);
+        for (size_t threads : {1, 4})
+        {
+            vector<T> found = img.percentiles(q, threads);
+            BOOST_REQUIRE_EQUAL(found.size(), q.size());
+            for (size_t k = 0; k < q.size(); k++)
+            {
+                BOOST_CHECK_MESSAGE(same_bits(found[k], expected[k]), "percentile " << q[k]);
+            }
+        }
+        BOOST_CHECK(same_bits(img.median(), expected[3]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(all_types)
+{
+    size_t const width = 409, height = 353;
+    vector<std::uint8_t> b8(width * height);
+    vector<std::int16_t> b16(width * height);
+    vector<std::int32_t> b32(width * height);
+    vector<boost::float32_t> f32(width * height);
+    vector<boost::float64_t> f64(width * height);
+    for (size_t i = 0; i < b8.size(); i++)
+    {
+        std::uint32_t hash = static_cast<std::uint32_t>(i * 2654435761u);
+        b8[i] = static_cast<std::uint8_t>(hash >> 24);
+        b16[i] = static_cast<std::int16_t>(hash >> 16);
+        b32[i] = static_cast<std::int32_t>(hash);
+        f32[i] = static_cast<boost::float32_t>(std::sin(static_cast<double>(i) * 0.37) * 1.0e3);
+        f64[i] = std::tan(static_cast<double>(i) * 0.11) * -1.0e-5;
+    }
+    //a few repeated values and signed zeros
+    f64[7] = f64[8] = f64[9] = 0.0;
+    f64[10] = -0.0;
+
+    check_percentiles<B8>(b8, width, height);
+    check_percentiles<B16>(b16, width, height);
+    check_percentiles<B32>(b32, width, height);
+    check_percentiles<_B32>(f32, width, height);
+    check_percentiles<_B64>(f64, width, height);
+}
+
+BOOST_AUTO_TEST_CASE(nan_pixels)
+{
+    vector<boost::float32_t> f32 = {5, NAN, 1, 4, NAN, 2, 3};
+    image<_B32> img;
+    img.assign_big_endian(big_endian_bytes(f32).data(), 7, 1);
+
+    BOOST_CHECK_EQUAL(img.median(), 3.0f);
+    BOOST_CHECK_EQUAL(img.percentile(0), 1.0f);
+    BOOST_CHECK_EQUAL(img.percentile(100), 5.0f);
+
+    vector<boost::float32_t> blank(4, NAN);
+    img.assign_big_endian(big_endian_bytes(blank).data(), 2, 2);
+    BOOST_CHECK(std::isnan(img.median()));
+    BOOST_CHECK_THROW(img.percentile(101), boost::astronomy::invalid_percentile_exception);
+    BOOST_CHECK_THROW(img.percentiles(vector<double>{50, -1}), boost::astronomy::fits_exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,519 @@
+#define BOOST_TEST_DYN_LINK
+
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/astronomy/io/fits.hpp>
+
+
+using namespace std;
+using namespace boost::astronomy::io;
+
+namespace
+{
+    //creates 80 char card with value right justified in columns 11-30 (or starting at column 11 for strings)
+    string make_card(string const& key, string const& value)
+    {
+        string result = key;
+        result.resize(8, ' ');
+        result += "= ";
+        result += value[0] == '\'' ? value : string(value.length() < 20 ? 20 - value.length() : 0, ' ') + value;
+        result.resize(80, ' ');
+        return result;
+    }
+
+    string pad(string bytes, char fill)
+    {
+        bytes.resize(((bytes.size() + 2879) / 2880) * 2880, fill);
+        return bytes;
+    }
+
+    template <typename T>
+    string big_endian(T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        return string(bytes, sizeof(T));
+    }
+
+    template <typename T>
+    bool same_bits(T a, T b)
+    {
+        return std::memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    string const sample_file = "test_table.fits";
+
+    void write_file(string const& bytes)
+    {
+        ofstream file(sample_file, ios_base::out | ios_base::binary);
+        file << bytes;
+    }
+
+    //fields of the sample table, TFORMn and TTYPEn
+    char const* const columns[][2] = {
+        {"1L", "FLAG"}, {"10X", "BITS"}, {"1B", "BYTE"}, {"1I", "SHORT"}, {"1J", "INT"}, {"1K", "LONG"},
+        {"8A", "NAME"}, {"1E", "MAG"}, {"1D", "RA"}, {"1C", "CFLOAT"}, {"1M", "CDOUBLE"}, {"2J", "PAIR"},
+        {"1PJ(3)", "VAR"}};
+
+    //returns a file with an empty primary HDU and a binary table of rows rows, the values depend on the row
+    //if padding is not 0 a character field of padding bytes named PAD is inserted after the field LONG
+    string table_file(size_t rows, size_t padding = 0)
+    {
+        string table, heap;
+        for (size_t i = 0; i < rows; i++)
+        {
+            std::int32_t const n = static_cast<std::int32_t>(i);
+            table += (i % 3 == 0 ? "T" : "F");
+            table += static_cast<char>(0xA5) + string(1, static_cast<char>(i % 2 == 0 ? 0xC0 : 0x40));
+            table += static_cast<char>(i % 256);
+            table += big_endian(static_cast<std::int16_t>(n - 1000));
+            table += big_endian(n * 7);
+            table += big_endian(static_cast<std::int64_t>(n) << 33);
+            table += string(padding, '-');
+            string name = "S" + to_string(i);
+            name.resize(8, ' ');
+            table += name;
+            table += big_endian(static_cast<float>(n) / 4);
+            table += big_endian(static_cast<double>(n) / 3);
+            table += big_endian(static_cast<float>(n)) + big_endian(-static_cast<float>(n));
+            table += big_endian(static_cast<double>(n) * 2) + big_endian(0.5);
+            table += big_endian(n) + big_endian(-n);
+
+            std::int32_t const count = n % 4;
+            table += big_endian(count) + big_endian(static_cast<std::int32_t>(heap.size()));
+            for (std::int32_t k = 0; k < count; k++)
+            {
+                heap += big_endian(n + k);
+            }
+        }
+
+        vector<pair<string, string>> fields;
+        for (auto const& column : columns)
+        {
+            fields.emplace_back(column[0], column[1]);
+            if (padding != 0 && fields.back().second == "LONG")
+            {
+                fields.emplace_back(to_string(padding) + "A", "PAD");
+            }
+        }
+
+        string header = make_card("XTENSION", "'BINTABLE'") + make_card("BITPIX", "8") + make_card("NAXIS", "2") +
+            make_card("NAXIS1", to_string(table.size() / (rows == 0 ? 1 : rows))) + make_card("NAXIS2", to_string(rows)) +
+            make_card("PCOUNT", to_string(heap.size())) + make_card("GCOUNT", "1") +
+            make_card("TFIELDS", to_string(fields.size())) + make_card("EXTNAME", "'SAMPLE  '");
+        for (size_t f = 0; f < fields.size(); f++)
+        {
+            header += make_card("TTYPE" + to_string(f + 1), "'" + fields[f].second + "'") +
+                make_card("TFORM" + to_string(f + 1), "'" + fields[f].first + "'");
+        }
+        header += string("END").append(77, ' ');
+
+        string primary = make_card("SIMPLE", "T") + make_card("BITPIX", "8") + make_card("NAXIS", "0") +
+            make_card("EXTEND", "T") + string("END").append(77, ' ');
+        return pad(primary, ' ') + pad(header, ' ') + pad(table + heap, '\0');
+    }
+
+    //returns a binary table named SOURCES of rows rows with the fields ID (1J, row * 3) and FLUX (1D, row / 2)
+    string sources_table(size_t rows)
+    {
+        string table;
+        for (size_t i = 0; i < rows; i++)
+        {
+            table += big_endian(static_cast<std::int32_t>(i) * 3) + big_endian(static_cast<double>(i) / 2);
+        }
+        string header = make_card("XTENSION", "'BINTABLE'") + make_card("BITPIX", "8") + make_card("NAXIS", "2") +
+            make_card("NAXIS1", "12") + make_card("NAXIS2", to_string(rows)) + make_card("PCOUNT", "0") +
+            make_card("GCOUNT", "1") + make_card("TFIELDS", "2") + make_card("EXTNAME", "'SOURCES '") +
+            make_card("TTYPE1", "'ID      '") + make_card("TFORM1", "'1J      '") +
+            make_card("TTYPE2", "'FLUX    '") + make_card("TFORM2", "'1D      '") + string("END").append(77, ' ');
+        return pad(header, ' ') + pad(table, '\0');
+    }
+
+    void check_table(binary_table_extension const& table, size_t rows)
+    {
+        BOOST_REQUIRE_EQUAL(table.get_row_count(), rows);
+        BOOST_REQUIRE_EQUAL(table.get_column_count(), 13u);
+        BOOST_CHECK_EQUAL(table.get_row_size(), 78u);
+
+        table_column const& flag = table.get_column("FLAG");
+        table_column const& bits = table.get_column("BITS");
+        table_column const& byte = table.get_column("BYTE");
+        table_column const& pair = table.get_column("PAIR");
+        table_column const& var = table.get_column("VAR");
+        std::int16_t const* shorts = table.get_column("SHORT").data<std::int16_t>();
+        std::int32_t const* ints = table.get_column("INT").data<std::int32_t>();
+        std::int64_t const* longs = table.get_column("LONG").data<std::int64_t>();
+        float const* mags = table.get_column("MAG").data<float>();
+        double const* ras = table.get_column("RA").data<double>();
+        std::complex<float> const* cfloats = table.get_column("CFLOAT").data<std::complex<float>>();
+        std::complex<double> const* cdoubles = table.get_column("CDOUBLE").data<std::complex<double>>();
+
+        BOOST_CHECK_EQUAL(pair.element_count(), 2 * rows);
+        BOOST_CHECK_EQUAL(bits.element_count(0), 2u);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < rows; i++)
+        {
+            std::int32_t const n = static_cast<std::int32_t>(i);
+            mismatches += flag.value<bool>(i) != (i % 3 == 0);
+            mismatches += bits.bit(i, 0) != true || bits.bit(i, 1) != false || bits.bit(i, 8) != (i % 2 == 0) || !bits.bit(i, 9);
+            mismatches += byte.value<std::uint8_t>(i) != i % 256;
+            mismatches += shorts[i] != n - 1000;
+            mismatches += ints[i] != n * 7;
+            mismatches += longs[i] != static_cast<std::int64_t>(n) << 33;
+            mismatches += table.get_column("NAME").string(i) != "S" + to_string(i);
+            mismatches += !same_bits(mags[i], static_cast<float>(n) / 4);
+            mismatches += !same_bits(ras[i], static_cast<double>(n) / 3);
+            mismatches += !same_bits(cfloats[i], std::complex<float>(static_cast<float>(n), -static_cast<float>(n)));
+            mismatches += !same_bits(cdoubles[i], std::complex<double>(static_cast<double>(n) * 2, 0.5));
+            mismatches += pair.row<std::int32_t>(i)[0] != n || pair.row<std::int32_t>(i)[1] != -n;
+
+            std::size_t const count = i % 4;
+            mismatches += var.element_count(i) != count;
+            for (std::size_t k = 0; k < var.element_count(i); k++)
+            {
+                mismatches += var.row<std::int32_t>(i)[k] != n + static_cast<std::int32_t>(k);
+            }
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+    }
+
+    //returns a file with an empty primary HDU and an ASCII table of rows rows, the values depend on the row
+    //fields: NAME A8, ID I6, FLUX F10.3 (NULL every 7th row), ERR E12.4, BIG D25.17
+    string ascii_table_file(size_t rows)
+    {
+        string table;
+        for (size_t i = 0; i < rows; i++)
+        {
+            char row[512]; //large enough for any double printed with %10.3f
+            char big[32];
+            std::snprintf(big, sizeof(big), "%25.17E", static_cast<double>(i) * 1.0e200 / 3);
+            std::replace(big, big + std::strlen(big), 'E', 'D');
+            if (i % 7 == 0)
+            {
+                std::snprintf(row, sizeof(row), "%-8s %6d %10s %12.4E %s", ("S" + to_string(i)).c_str(),
+                    static_cast<int>(i) - 2500, "NULL", static_cast<double>(i) / 8, big);
+            }
+            else
+            {
+                std::snprintf(row, sizeof(row), "%-8s %6d %10.3f %12.4E %s", ("S" + to_string(i)).c_str(),
+                    static_cast<int>(i) - 2500, static_cast<double>(i) / 4, static_cast<double>(i) / 8, big);
+            }
+            table += string(row, 66);
+        }
+
+        string header = make_card("XTENSION", "'TABLE   '") + make_card("BITPIX", "8") + make_card("NAXIS", "2") +
+            make_card("NAXIS1", "66") + make_card("NAXIS2", to_string(rows)) + make_card("PCOUNT", "0") +
+            make_card("GCOUNT", "1") + make_card("TFIELDS", "5") +
+            make_card("TTYPE1", "'NAME    '") + make_card("TBCOL1", "1") + make_card("TFORM1", "'A8      '") +
+            make_card("TTYPE2", "'ID      '") + make_card("TBCOL2", "10") + make_card("TFORM2", "'I6      '") +
+            make_card("TTYPE3", "'FLUX    '") + make_card("TBCOL3", "17") + make_card("TFORM3", "'F10.3   '") +
+            make_card("TNULL3", "'NULL    '") +
+            make_card("TTYPE4", "'ERR     '") + make_card("TBCOL4", "28") + make_card("TFORM4", "'E12.4   '") +
+            make_card("TTYPE5", "'BIG     '") + make_card("TBCOL5", "41") + make_card("TFORM5", "'D25.17  '") +
+            string("END").append(77, ' ');
+
+        string primary = make_card("SIMPLE", "T") + make_card("BITPIX", "8") + make_card("NAXIS", "0") +
+            make_card("EXTEND", "T") + string("END").append(77, ' ');
+        return pad(primary, ' ') + pad(header, ' ') + pad(table, ' ');
+    }
+
+    void check_ascii_table(ascii_table_extension const& table, size_t first, size_t count)
+    {
+        BOOST_REQUIRE_EQUAL(table.get_column_count(), 5u);
+        table_column const& names = table.get_column("NAME");
+        std::int64_t const* ids = table.get_column("ID").data<std::int64_t>();
+        double const* fluxes = table.get_column("FLUX").data<double>();
+        double const* errors = table.get_column("ERR").data<double>();
+        double const* bigs = table.get_column("BIG").data<double>();
+        BOOST_REQUIRE_EQUAL(names.get_rows(), count);
+
+        size_t mismatches = 0;
+        for (size_t row = 0; row < count; row++)
+        {
+            size_t const i = first + row;
+            mismatches += names.string(row) != "S" + to_string(i);
+            mismatches += ids[row] != static_cast<std::int64_t>(i) - 2500;
+            mismatches += i % 7 == 0 ? !std::isnan(fluxes[row]) : !same_bits(fluxes[row], static_cast<double>(i) / 4);
+            char error[16];
+            std::snprintf(error, sizeof(error), "%12.4E", static_cast<double>(i) / 8);
+            mismatches += !same_bits(errors[row], std::strtod(error, nullptr));
+            char big[32];
+            std::snprintf(big, sizeof(big), "%25.17E", static_cast<double>(i) * 1.0e200 / 3);
+            mismatches += !same_bits(bigs[row], std::strtod(big, nullptr));
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+    }
+
+    //checks the columns RA, INT, VAR and NAME (in this order) read from row first of the table
+    void check_projection(vector<table_column> const& selected, size_t first, size_t count)
+    {
+        BOOST_REQUIRE_EQUAL(selected.size(), 4u);
+        BOOST_CHECK_EQUAL(selected[0].get_name(), "RA");
+        BOOST_CHECK_EQUAL(selected[1].get_name(), "INT");
+        BOOST_CHECK_EQUAL(selected[2].get_name(), "VAR");
+        BOOST_CHECK_EQUAL(selected[3].get_name(), "NAME");
+
+        size_t mismatches = 0;
+        for (table_column const& column : selected)
+        {
+            mismatches += column.get_rows() != count;
+        }
+        for (size_t row = 0; row < count; row++)
+        {
+            size_t const i = first + row;
+            std::int32_t const n = static_cast<std::int32_t>(i);
+            mismatches += !same_bits(selected[0].data<double>()[row], static_cast<double>(n) / 3);
+            mismatches += selected[1].value<std::int32_t>(row) != n * 7;
+            mismatches += selected[2].element_count(row) != i % 4;
+            for (size_t k = 0; k < selected[2].element_count(row); k++)
+            {
+                mismatches += selected[2].row<std::int32_t>(row)[k] != n + static_cast<std::int32_t>(k);
+            }
+            mismatches += selected[3].string(row) != "S" + to_string(i);
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0u);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(binary_table)
+
+BOOST_AUTO_TEST_CASE(all_read_modes)
+{
+    //more than one block of rows so that rows are converted by several threads
+    size_t const rows = 20000;
+    write_file(table_file(rows));
+
+    std::shared_ptr<hdu> streamed;
+    {
+        fits file(sample_file);
+        file.read_extensions();
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 2u);
+        streamed = file.get_hdu(1);
+    }
+    check_table(static_cast<binary_table_extension&>(*streamed), rows);
+
+    fits mapped(sample_file, fits::mapped);
+    binary_table_extension const& mapped_table = static_cast<binary_table_extension&>(*mapped.get_hdu(1));
+    BOOST_CHECK(!mapped_table.is_loaded());
+    BOOST_CHECK_EQUAL(mapped_table.get_formats()[12].array_type, 'J');
+    check_table(mapped_table, rows);
+
+    fits deferred(sample_file, fits::deferred);
+    binary_table_extension const& deferred_table = static_cast<binary_table_extension&>(*deferred.get_hdu(1));
+    BOOST_CHECK(!deferred_table.is_loaded());
+    deferred_table.load_data(2);
+    BOOST_CHECK(deferred_table.is_loaded());
+    check_table(deferred_table, rows);
+
+    fits parallel(sample_file, fits::parallel, 2);
+    binary_table_extension const& parallel_table = static_cast<binary_table_extension&>(*parallel.get_hdu(1));
+    BOOST_CHECK(parallel_table.is_loaded());
+    check_table(parallel_table, rows);
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    write_file(table_file(4));
+    fits file(sample_file, fits::mapped);
+    binary_table_extension const& table = static_cast<binary_table_extension&>(*file.get_hdu(1));
+
+    BOOST_CHECK_THROW(table.get_column("MISSING"), boost::astronomy::column_not_found_exception);
+    BOOST_CHECK_THROW(table.get_column("INT").data<float>(), boost::astronomy::column_type_exception);
+    BOOST_CHECK_THROW(table.get_column("BYTE").data<char>(), boost::astronomy::column_type_exception);
+    BOOST_CHECK_EQUAL(table.get_column(4).get_name(), "INT");
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(projection)
+{
+    size_t const rows = 3000;
+    table_selection const selection({"RA", "INT", "VAR", "NAME"}, 1234, 1500);
+
+    //without padding the rows are read contiguously, with padding the fields before and after PAD are read separately
+    for (size_t padding : {size_t(0), size_t(10000)})
+    {
+        write_file(table_file(rows, padding));
+
+        std::shared_ptr<hdu> streamed;
+        {
+            fits file(sample_file);
+            file.read_extensions(selection);
+            BOOST_REQUIRE_EQUAL(file.hdu_count(), 2u);
+            streamed = file.get_hdu(1);
+        }
+        binary_table_extension const& table = static_cast<binary_table_extension&>(*streamed);
+        BOOST_CHECK_EQUAL(table.get_row_count(), rows);
+        BOOST_CHECK_EQUAL(table.get_selection().first_row, 1234u);
+        check_projection(table.get_columns(), 1234, 1500);
+        BOOST_CHECK_EQUAL(table.get_column("INT").value<std::int32_t>(0), 1234 * 7);
+        BOOST_CHECK_THROW(table.get_column("SHORT"), boost::astronomy::column_not_found_exception);
+
+        fits mapped(sample_file, fits::mapped);
+        binary_table_extension const& mapped_table = static_cast<binary_table_extension&>(*mapped.get_hdu(1));
+        check_projection(mapped_table.read_columns(selection, 2), 1234, 1500);
+        BOOST_CHECK(!mapped_table.is_loaded());
+
+        fits deferred(sample_file, fits::deferred);
+        binary_table_extension const& deferred_table = static_cast<binary_table_extension&>(*deferred.get_hdu(1));
+        check_projection(deferred_table.read_columns(selection, 2), 1234, 1500);
+        BOOST_CHECK(!deferred_table.is_loaded());
+
+        //row range is clipped to the end of the table
+        table_selection const tail({"RA", "INT", "VAR", "NAME"}, rows - 5);
+        check_projection(deferred_table.read_columns(tail), rows - 5, 5);
+        check_projection(mapped_table.read_columns(tail), rows - 5, 5);
+        check_projection(deferred_table.read_columns(table_selection({"RA", "INT", "VAR", "NAME"}, rows + 1)), 0, 0);
+    }
+
+    BOOST_CHECK_THROW(fits(sample_file).read_extensions(table_selection({"MISSING"})),
+        boost::astronomy::column_not_found_exception);
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(projection_by_name)
+{
+    //two tables without common columns, each projected on its own columns
+    size_t const rows = 3000;
+    write_file(table_file(rows) + sources_table(10));
+
+    std::map<string, table_selection> selections;
+    selections["SAMPLE"] = table_selection({"RA", "INT", "VAR", "NAME"}, 1234, 1500);
+    selections["SOURCES"] = table_selection({"ID"}, 4, 3);
+    {
+        fits file(sample_file);
+        file.read_extensions(selections);
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 3u);
+        check_projection(static_cast<binary_table_extension&>(*file.get_hdu(1)).get_columns(), 1234, 1500);
+
+        binary_table_extension const& sources = static_cast<binary_table_extension&>(*file.get_hdu(2));
+        BOOST_REQUIRE_EQUAL(sources.get_columns().size(), 1u);
+        BOOST_REQUIRE_EQUAL(sources.get_column("ID").get_rows(), 3u);
+        BOOST_CHECK_EQUAL(sources.get_column("ID").value<std::int32_t>(0), 12);
+        BOOST_CHECK_EQUAL(sources.get_column("ID").value<std::int32_t>(2), 18);
+        BOOST_CHECK_THROW(sources.get_column("FLUX"), boost::astronomy::column_not_found_exception);
+    }
+
+    //tables which are not named in the selections are read whole
+    selections.erase("SAMPLE");
+    {
+        fits file(sample_file);
+        file.read_extensions(selections);
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 3u);
+        check_table(static_cast<binary_table_extension&>(*file.get_hdu(1)), rows);
+        BOOST_CHECK_EQUAL(static_cast<binary_table_extension&>(*file.get_hdu(2)).get_columns().size(), 1u);
+    }
+
+    //a single selection applies to every table
+    BOOST_CHECK_THROW(fits(sample_file).read_extensions(table_selection({"ID"})),
+        boost::astronomy::column_not_found_exception);
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ascii_table)
+
+BOOST_AUTO_TEST_CASE(fixed_width_numbers)
+{
+    using boost::astronomy::detail::parse_integer;
+    using boost::astronomy::detail::parse_real;
+
+    std::int64_t integer = 1;
+    string const integers[] = {"   42 ", "-17", "+5", "      ", "-9223372036854775808"};
+    std::int64_t const expected_integers[] = {42, -17, 5, 0, (std::numeric_limits<std::int64_t>::min)()};
+    for (size_t i = 0; i < 5; i++)
+    {
+        BOOST_CHECK(parse_integer(integers[i].data(), integers[i].data() + integers[i].size(), integer));
+        BOOST_CHECK_EQUAL(integer, expected_integers[i]);
+    }
+    for (string const text : {"9223372036854775808", "12a", "- 1", "-"})
+    {
+        BOOST_CHECK(!parse_integer(text.data(), text.data() + text.size(), integer));
+    }
+
+    double real = 1;
+    string const reals[] = {" 1.5 ", "-2.25D+02", "1.0E-3", "  ", "12345", "0.1", "1.5+3", "6.02214076d23",
+        "0.30000000000000000000000001", "1.7976931348623157D+308", "4.9406564584124654E-324", "-0.0"};
+    std::size_t const decimals[] = {0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0};
+    double const expected_reals[] = {1.5, -225.0, 1.0e-3, 0.0, 123.45, 0.1, 1500.0, 6.02214076e23,
+        0.30000000000000000000000001, 1.7976931348623157e308, 4.9406564584124654e-324, -0.0};
+    for (size_t i = 0; i < sizeof(expected_reals) / sizeof(expected_reals[0]); i++)
+    {
+        BOOST_CHECK(parse_real(reals[i].data(), reals[i].data() + reals[i].size(), decimals[i], real));
+        BOOST_CHECK_MESSAGE(same_bits(real, expected_reals[i]), reals[i]);
+    }
+    for (string const text : {"1.2.3", "E5", "1.0E", "1.0Q5", "."})
+    {
+        BOOST_CHECK(!parse_real(text.data(), text.data() + text.size(), 0, real));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(all_read_modes)
+{
+    size_t const rows = 40000;
+    write_file(ascii_table_file(rows));
+
+    std::shared_ptr<hdu> streamed;
+    {
+        fits file(sample_file);
+        file.read_extensions();
+        BOOST_REQUIRE_EQUAL(file.hdu_count(), 2u);
+        streamed = file.get_hdu(1);
+    }
+    ascii_table_extension const& table = static_cast<ascii_table_extension&>(*streamed);
+    BOOST_CHECK_EQUAL(table.get_row_count(), rows);
+    BOOST_CHECK_EQUAL(table.get_formats()[3].decimals, 4u);
+    check_ascii_table(table, 0, rows);
+
+    fits mapped(sample_file, fits::mapped);
+    check_ascii_table(static_cast<ascii_table_extension&>(*mapped.get_hdu(1)), 0, rows);
+
+    fits deferred(sample_file, fits::deferred);
+    ascii_table_extension const& deferred_table = static_cast<ascii_table_extension&>(*deferred.get_hdu(1));
+    BOOST_CHECK(!deferred_table.is_loaded());
+    deferred_table.load_data(2);
+    check_ascii_table(deferred_table, 0, rows);
+
+    fits parallel(sample_file, fits::parallel, 2);
+    check_ascii_table(static_cast<ascii_table_extension&>(*parallel.get_hdu(1)), 0, rows);
+
+    //selection of rows, every column is still selected
+    fits selected(sample_file);
+    selected.read_extensions(table_selection(vector<string>(), 35000, 100));
+    check_ascii_table(static_cast<ascii_table_extension&>(*selected.get_hdu(1)), 35000, 100);
+
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(invalid_field)
+{
+    string bytes = ascii_table_file(3);
+    //ID of the second row is not a number
+    bytes.replace(2 * 2880 + 66 + 10, 5, "1x345");
+    write_file(bytes);
+
+    fits file(sample_file, fits::mapped);
+    ascii_table_extension const& table = static_cast<ascii_table_extension&>(*file.get_hdu(1));
+    BOOST_CHECK_THROW(table.get_columns(), boost::astronomy::invalid_table_field_exception);
+    std::remove(sample_file.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()